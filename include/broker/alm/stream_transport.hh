@@ -1,5 +1,9 @@
 #pragma once
 
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -23,9 +27,15 @@
 #include "broker/data.hh"
 #include "broker/defaults.hh"
 #include "broker/detail/assert.hh"
+#include "broker/detail/batch_tuner.hh"
 #include "broker/detail/filesystem.hh"
-#include "broker/detail/generator_file_writer.hh"
+#include "broker/detail/local_subscriber_table.hh"
+#include "broker/detail/metric_registry.hh"
+#include "broker/detail/peer_spool.hh"
 #include "broker/detail/prefix_matcher.hh"
+#include "broker/detail/probes.hh"
+#include "broker/detail/trace_context.hh"
+#include "broker/detail/trace_table.hh"
 #include "broker/error.hh"
 #include "broker/filter_type.hh"
 #include "broker/internal_command.hh"
@@ -108,27 +118,45 @@ public:
   /// Maps path IDs to actor handles.
   using slot_to_hdl_map = std::unordered_map<caf::stream_slot, caf::actor>;
 
+  /// Bundles the metrics we keep per peer.
+  struct peer_metrics {
+    /// Counts messages we have received from the peer.
+    detail::metric* received;
+
+    /// Counts messages we have sent to the peer.
+    detail::metric* sent;
+
+    /// Counts how many nanoseconds we have buffered inbound messages from the
+    /// peer while it was blocked.
+    detail::metric* blocked;
+
+    /// Stores the smoothed round-trip time of batches to the peer in
+    /// nanoseconds. Remains 0 if `broker.peer-stream-goal` is `throughput`.
+    detail::metric* rtt;
+
+    /// Counts how often we had messages for the peer but no credit left.
+    detail::metric* credit_stalls;
+  };
+
   // -- constructors, destructors, and assignment operators --------------------
 
   stream_transport(caf::event_based_actor* self, const filter_type& filter)
-    : caf::stream_manager(self), out_(this), remaining_records_(0) {
+    : caf::stream_manager(self),
+      out_(this),
+      tracer_(caf::get_or(self->system().config(), "broker.trace-sample-rate",
+                          defaults::trace_sample_rate)),
+      spool_(caf::get_or(self->system().config(), "broker.peer-spool-size",
+                         defaults::peer_spool_size)),
+      spool_timeout_(caf::get_or(self->system().config(),
+                                 "broker.peer-spool-timeout",
+                                 defaults::peer_spool_timeout)) {
     continuous(true);
+    init_spool_overflow();
+    auto goal = caf::get_or(self->system().config(), "broker.peer-stream-goal",
+                            defaults::peer_stream_goal);
+    if (!convert(goal, stream_goal_))
+      BROKER_ERROR("invalid value for broker.peer-stream-goal:" << goal);
     // TODO: use filter
-    using caf::get_or;
-    auto& cfg = self->system().config();
-    auto meta_dir = get_or(cfg, "broker.recording-directory",
-                           defaults::recording_directory);
-    if (!meta_dir.empty() && detail::is_directory(meta_dir)) {
-      auto file_name = meta_dir + "/messages.dat";
-      recorder_ = detail::make_generator_file_writer(file_name);
-      if (recorder_ == nullptr) {
-        BROKER_WARNING("cannot open recording file" << file_name);
-      } else {
-        BROKER_DEBUG("opened file for recording:" << file_name);
-        remaining_records_ = get_or(cfg, "broker.output-generator-file-cap",
-                                    defaults::output_generator_file_cap);
-      }
-    }
   }
 
   // -- initialization ---------------------------------------------------------
@@ -166,6 +194,20 @@ public:
     return out().template get<typename store_trait::manager>();
   }
 
+  /// Sets the table for delivering data messages directly into the queues of
+  /// local subscribers.
+  void local_subscribers(detail::local_subscriber_table_ptr ptr) noexcept {
+    local_subscribers_ = std::move(ptr);
+  }
+
+  /// Sets the tables for receiving trace contexts from publisher workers and
+  /// for passing trace contexts of messages from peers to subscriber workers.
+  void traces(detail::trace_table_ptr outbound,
+              detail::trace_table_ptr inbound) noexcept {
+    outbound_traces_ = std::move(outbound);
+    inbound_traces_ = std::move(inbound);
+  }
+
   // -- streaming helper functions ---------------------------------------------
 
   void ack_open_success(caf::stream_slot slot,
@@ -223,12 +265,19 @@ public:
 
   /// Block peer messages from being handled.  They are buffered until unblocked.
   void block_peer(caf::actor peer) {
+    blocked_since_.emplace(peer, std::chrono::steady_clock::now());
     blocked_peers.emplace(std::move(peer));
   }
 
   /// Unblock peer messages and flush any buffered messages immediately.
   void unblock_peer(caf::actor peer) {
     blocked_peers.erase(peer);
+    if (auto i = blocked_since_.find(peer); i != blocked_since_.end()) {
+      auto dt = std::chrono::steady_clock::now() - i->second;
+      metrics_for(peer).blocked->inc(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(dt).count());
+      blocked_since_.erase(i);
+    }
     auto it = blocked_msgs.find(peer);
     if (it == blocked_msgs.end())
       return;
@@ -290,6 +339,27 @@ public:
       slot, std::make_pair(peer_hdl.address(), std::move(peer_filter)));
     // Add bookkeeping state for our new peer.
     add_opath(slot, peer_hdl);
+    negotiate_traces(peer_hdl);
+    if (stream_goal_ != detail::stream_goal::throughput)
+      tuners_.emplace(slot, detail::batch_tuner{stream_goal_});
+    // Replay what the peer missed since it lost its previous connection.
+    if (spool_.contains(peer_hdl.node())) {
+      auto& states = peer_manager().states();
+      if (auto i = states.find(slot); i != states.end()) {
+        auto& buf = i->second.buf;
+        auto size_before = buf.size();
+        auto dropped = spool_.take(peer_hdl.node(), buf);
+        // The peer did not agree on receiving traces yet. Also, the timestamps
+        // of spooled messages would only measure the downtime.
+        for (auto j = buf.begin() + size_before; j != buf.end(); ++j)
+          j->trace = caf::none;
+        BROKER_INFO("replay" << (buf.size() - size_before)
+                             << "spooled messages to" << peer_hdl.node());
+        if (dropped > 0)
+          BROKER_WARNING("spool for" << peer_hdl.node() << "dropped" << dropped
+                                     << "messages");
+      }
+    }
     return slot;
   }
 
@@ -355,6 +425,11 @@ public:
       if (i != e) {
         BROKER_DEBUG("remove outbound path to peer:" << hdl);
         ++performed_erases;
+        if (!graceful_removal && spool_.enabled() && !dref().shutting_down())
+          open_spool(hdl, i->second);
+        tuners_.erase(i->second);
+        stalled_paths_.erase(i->second);
+        trace_peers_.erase(hdl);
         out().remove_path(i->second, reason, silent);
         ostream_to_peer_.erase(i->second);
         hdl_to_ostream_.erase(i);
@@ -375,6 +450,10 @@ public:
       BROKER_DEBUG("no path was removed for peer:" << hdl);
       return false;
     }
+    // Drop our pointers to the metrics before removing them from the registry.
+    peer_metrics_.erase(hdl);
+    blocked_since_.erase(hdl);
+    dref().metrics().remove(dref().peer_metric_labels(hdl.node()));
     if (graceful_removal)
       dref().peer_removed(hdl.node(), hdl);
     else
@@ -390,6 +469,12 @@ public:
     return true;
   }
 
+  /// Discards spools of peers that did not return in time.
+  void expire_spools() {
+    if (auto n = spool_.expire(spool_timeout_); n > 0)
+      BROKER_INFO("discarded" << n << "spools of disconnected peers");
+  }
+
   /// Updates the filter of an existing peer.
   bool update_peer(const caf::actor& hdl, filter_type filter) {
     BROKER_TRACE(BROKER_ARG(hdl) << BROKER_ARG(filter));
@@ -451,6 +536,8 @@ public:
   void local_push(data_message x) {
     BROKER_TRACE(BROKER_ARG(x)
                  << BROKER_ARG2("num_paths", worker_manager().num_paths()));
+    if (local_subscribers_)
+      local_subscribers_->deliver(x);
     if (worker_manager().num_paths() > 0) {
       worker_manager().push(std::move(x));
       worker_manager().emit_batches();
@@ -470,8 +557,89 @@ public:
   /// Pushes data to peers only without forwarding it to local substreams.
   void remote_push(message_type msg) {
     BROKER_TRACE(BROKER_ARG(msg));
+    if (!spool_.empty())
+      spool_.add(msg);
+    if (msg.trace)
+      strip_traces_ = true;
     peer_manager().push(std::move(msg));
+    flush_peer_buffer();
     peer_manager().emit_batches();
+    // Tuning and counting stalls visit all peers, hence we only do this per
+    // inbound batch and per ack rather than per message.
+  }
+
+  /// Sends underfull batches to peers whose tuner asks for it and records all
+  /// batches for measuring round-trip times.
+  void tune_peer_batches() {
+    if (tuners_.empty())
+      return;
+    auto& mgr = peer_manager();
+    auto t = broker::now();
+    for (auto& kvp : mgr.states()) {
+      auto i = tuners_.find(kvp.first);
+      auto path = mgr.path(kvp.first);
+      if (i == tuners_.end() || path == nullptr)
+        continue;
+      auto& buf = kvp.second.buf;
+      auto desired = static_cast<size_t>(path->desired_batch_size);
+      if (i->second.flush(buf.size(), desired))
+        path->emit_batches(self(), buf, true);
+      i->second.sent(path->next_batch_id, t);
+    }
+  }
+
+  /// Counts each transition of a peer into a state where we have buffered
+  /// messages for it but it granted no credit, i.e., a stall ends only after
+  /// the peer granted new credit or we emptied its buffer.
+  void count_credit_stalls() {
+    auto& mgr = peer_manager();
+    for (auto& kvp : mgr.states()) {
+      auto path = mgr.path(kvp.first);
+      if (path == nullptr)
+        continue;
+      if (kvp.second.buf.empty() || path->open_credit > 0) {
+        stalled_paths_.erase(kvp.first);
+      } else if (stalled_paths_.emplace(kvp.first).second) {
+        if (auto i = ostream_to_peer_.find(kvp.first);
+            i != ostream_to_peer_.end())
+          metrics_for(i->second).credit_stalls->inc();
+      }
+    }
+  }
+
+  /// Moves messages from the central buffer for peers to the buffers of the
+  /// individual paths and counts the messages per peer.
+  void flush_peer_buffer() {
+    auto& mgr = peer_manager();
+    if (mgr.buf().empty())
+      return;
+    auto& states = mgr.states();
+    path_sizes_.clear();
+    for (auto& kvp : states)
+      path_sizes_.emplace_back(kvp.second.buf.size());
+    mgr.fan_out_flush();
+    // Calling fan_out_flush only appends to the path buffers, i.e., the map
+    // keeps its order.
+    size_t index = 0;
+    for (auto& kvp : states) {
+      auto n = kvp.second.buf.size() - path_sizes_[index++];
+      if (n == 0)
+        continue;
+      BROKER_PROBE1(peer_send, n);
+      auto i = ostream_to_peer_.find(kvp.first);
+      if (i != ostream_to_peer_.end())
+        metrics_for(i->second).sent->inc(static_cast<int64_t>(n));
+      // Peers that did not agree on exchanging traces would misread them.
+      if (strip_traces_
+          && (i == ostream_to_peer_.end()
+              || trace_peers_.count(i->second) == 0)) {
+        auto& buf = kvp.second.buf;
+        auto first = buf.end() - static_cast<ptrdiff_t>(n);
+        for (auto j = first; j != buf.end(); ++j)
+          j->trace = caf::none;
+      }
+    }
+    strip_traces_ = false;
   }
 
   using caf::stream_manager::push;
@@ -479,17 +647,45 @@ public:
   /// Pushes data to peers and workers.
   void push(data_message msg) {
     BROKER_TRACE(BROKER_ARG(msg));
-    remote_push(make_node_message(std::move(msg), dref().options().ttl));
+    remote_push(make_outbound_message(std::move(msg)));
     // local_push(std::move(x), std::move(y));
   }
 
   /// Pushes data to peers and stores.
   void push(command_message msg) {
     BROKER_TRACE(BROKER_ARG(msg));
-    remote_push(make_node_message(std::move(msg), dref().options().ttl));
+    remote_push(make_outbound_message(std::move(msg)));
     // local_push(std::move(x), std::move(y));
   }
 
+  /// Wraps a locally published message for our peers and attaches a trace
+  /// context if the message got sampled, either by a publisher worker or by
+  /// this core.
+  template <class T>
+  message_type make_outbound_message(T msg) {
+    auto result = make_node_message(std::move(msg), dref().options().ttl);
+    if constexpr (std::is_same<T, data_message>::value) {
+      if (outbound_traces_ && !outbound_traces_->empty())
+        if (auto ctx = outbound_traces_->take(get<T>(result.content)))
+          result.trace = std::move(*ctx);
+    }
+    if (!result.trace && !sampled_upstream_)
+      if (auto id = tracer_.next(); id != 0)
+        result.trace = detail::trace_context{id, {}};
+    if (result.trace)
+      result.trace->add(detail::trace_hop::origin);
+    return result;
+  }
+
+  /// Publishes a message that passed a publisher worker, i.e., the worker
+  /// sampled it already.
+  template <class T>
+  void publish_sampled_upstream(T msg) {
+    sampled_upstream_ = true;
+    dref().publish(std::move(msg));
+    sampled_upstream_ = false;
+  }
+
   /// Pushes data to peers and stores.
   void push(message_type msg) {
     BROKER_TRACE(BROKER_ARG(msg));
@@ -532,12 +728,12 @@ public:
     // of the inbound data we are handling here.
     BROKER_ASSERT(peer_manager().selector().active_sender == nullptr);
     auto& d = dref();
-    peer_manager().fan_out_flush();
+    flush_peer_buffer();
     peer_manager().selector().active_sender = caf::actor_cast<caf::actor_addr>(hdl);
     auto guard = caf::detail::make_scope_guard([this] {
       // Make sure the content of the buffer is pushed to the outbound paths
       // while the sender filter is still active.
-      peer_manager().fan_out_flush();
+      flush_peer_buffer();
       peer_manager().selector().active_sender = nullptr;
     });
     // Handle received batch.
@@ -554,14 +750,21 @@ public:
       auto num_stores = store_manager().num_paths();
       BROKER_DEBUG("forward batch from peers;" << BROKER_ARG(num_workers)
                                                << BROKER_ARG(num_stores));
+      auto& batch = xs.get_mutable_as<typename peer_trait::batch>(0);
+      metrics_for(peer_actor).received->inc(static_cast<int64_t>(batch.size()));
+      BROKER_PROBE1(peer_receive, batch.size());
       // Only received from other peers. Extract content for to local workers
       // or stores and then forward to other peers.
-      for (auto& msg : xs.get_mutable_as<typename peer_trait::batch>(0)) {
+      for (auto& msg : batch) {
+        if (msg.trace)
+          msg.trace->add(detail::trace_hop::peer_ingress);
         const topic* t;
         // Dispatch to local workers or stores messages.
         if (is_data_message(msg)) {
           auto& dm = get<data_message>(msg.content);
           t = &get_topic(dm);
+          if (local_subscribers_)
+            local_subscribers_->deliver(dm);
           if (num_workers > 0)
             worker_manager().push(dm);
         } else {
@@ -570,6 +773,22 @@ public:
           if (num_stores > 0)
             store_manager().push(cm);
         }
+        if (msg.trace) {
+          msg.trace->add(detail::trace_hop::delivery);
+          // Subscriber workers publish the trace again after adding their
+          // hop. We still publish it here, because subscribers on the fast
+          // path or with a filter that does not match never see the entry.
+          if (inbound_traces_ && num_workers > 0 && is_data_message(msg))
+            inbound_traces_->put(get<data_message>(msg.content), *msg.trace);
+          if (num_workers > 0 || local_subscribers_) {
+            auto tm = make_data_message(topics::traces,
+                                        to_data(*msg.trace, *t));
+            if (local_subscribers_)
+              local_subscribers_->deliver(tm);
+            if (num_workers > 0)
+              worker_manager().push(std::move(tm));
+          }
+        }
         // Check if forwarding is on.
         if (!dref().options().forward)
           continue;
@@ -587,6 +806,8 @@ public:
           continue;
         }
         // Forward to other peers.
+        if (msg.trace)
+          msg.trace->add(detail::trace_hop::forward);
         d.publish(std::move(msg));
       }
       return;
@@ -594,8 +815,16 @@ public:
     auto try_publish = [&](auto trait) {
       using batch_type = typename decltype(trait)::batch;
       if (xs.template match_elements<batch_type>()) {
-        for (auto& x : xs.template get_mutable_as<batch_type>(0))
-          d.publish(x);
+        auto& batch = xs.template get_mutable_as<batch_type>(0);
+        BROKER_PROBE1(core_batch, batch.size());
+        // Only publisher workers sample their messages.
+        if constexpr (std::is_same<decltype(trait), worker_trait>::value) {
+          for (auto& x : batch)
+            publish_sampled_upstream(x);
+        } else {
+          for (auto& x : batch)
+            d.publish(x);
+        }
         return true;
       }
       return false;
@@ -609,6 +838,8 @@ public:
   void handle(caf::inbound_path* path,
               caf::downstream_msg::batch& batch) override {
     handle_batch(path->hdl, batch.xs);
+    tune_peer_batches();
+    count_credit_stalls();
   }
 
   void handle(caf::inbound_path* path, caf::downstream_msg::close& x) override {
@@ -639,6 +870,21 @@ public:
                 std::move(x.reason));
   }
 
+  void handle(caf::stream_slots slots,
+              caf::upstream_msg::ack_batch& x) override {
+    BROKER_TRACE(BROKER_ARG(slots) << BROKER_ARG(x));
+    if (auto i = tuners_.find(slots.receiver); i != tuners_.end()) {
+      i->second.acked(x.acknowledged_id, x.new_capacity, broker::now());
+      if (auto j = ostream_to_peer_.find(slots.receiver);
+          j != ostream_to_peer_.end())
+        metrics_for(j->second).rtt->set(i->second.rtt().count());
+    }
+    caf::stream_manager::handle(slots, x);
+    // The new credit may allow us to send underfull batches.
+    tune_peer_batches();
+    count_credit_stalls();
+  }
+
   bool handle(caf::stream_slots slots,
               caf::upstream_msg::ack_open& x) override {
     BROKER_TRACE(BROKER_ARG(slots) << BROKER_ARG(x));
@@ -793,6 +1039,41 @@ protected:
     return static_cast<ttl>(dref().options().ttl);
   }
 
+  /// Lets spools write messages beyond `broker.peer-spool-size` to
+  /// `broker.peer-spool-directory` if configured.
+  void init_spool_overflow() {
+    auto& cfg = self()->system().config();
+    auto disk_size = caf::get_or(cfg, "broker.peer-spool-disk-size",
+                                 defaults::peer_spool_disk_size);
+    auto dir = caf::get_or(cfg, "broker.peer-spool-directory",
+                           defaults::peer_spool_directory);
+    if (!spool_.enabled() || disk_size == 0 || dir.empty())
+      return;
+    if (!detail::is_directory(dir) && !detail::mkdirs(dir)) {
+      BROKER_ERROR("cannot create spool directory" << dir);
+      return;
+    }
+    // Multiple cores may share the directory, e.g., sharded cores or
+    // endpoints in different processes.
+    auto prefix = dir + "/spool-" + to_string(self()->node()) + "-"
+                  + std::to_string(self()->id()) + "-";
+    spool_.overflow(std::move(prefix), disk_size);
+  }
+
+  /// Starts spooling messages for a peer that lost its connection, beginning
+  /// with the messages that were still buffered for its outbound path.
+  void open_spool(const caf::actor& hdl, caf::stream_slot slot) {
+    BROKER_TRACE(BROKER_ARG(hdl) << BROKER_ARG(slot));
+    auto& mgr = peer_manager();
+    flush_peer_buffer();
+    spool_.open(hdl.node(), mgr.filter(slot).second);
+    auto& states = mgr.states();
+    if (auto i = states.find(slot); i != states.end())
+      for (auto& x : i->second.buf)
+        spool_.add(hdl.node(), x);
+    self()->delayed_send(self(), spool_timeout_, atom::peer_v, atom::clear_v);
+  }
+
   /// Adds entries to `hdl_to_istream_` and `istream_to_hdl_`.
   void add_ipath(caf::stream_slot slot, const caf::actor& peer_hdl) {
     BROKER_TRACE(BROKER_ARG(slot) << BROKER_ARG(peer_hdl));
@@ -843,6 +1124,38 @@ protected:
     remove_peer(peer_hdl, std::move(reason), true, false);
   }
 
+  /// Returns the metrics for `hdl`, creating them on first access.
+  peer_metrics& metrics_for(const caf::actor& hdl) {
+    auto i = peer_metrics_.find(hdl);
+    if (i != peer_metrics_.end())
+      return i->second;
+    auto& reg = dref().metrics();
+    auto labels = dref().peer_metric_labels(hdl.node());
+    peer_metrics x{
+      &reg.counter("broker_peer_received_messages_total", labels),
+      &reg.counter("broker_peer_sent_messages_total", labels),
+      &reg.counter("broker_peer_blocked_nanoseconds_total", labels),
+      &reg.gauge("broker_peer_rtt_nanoseconds", labels),
+      &reg.counter("broker_peer_credit_stalls_total", labels),
+    };
+    return peer_metrics_.emplace(hdl, x).first->second;
+  }
+
+  /// Asks `hdl` whether it reads trace contexts on node messages. Peers that
+  /// run an older version respond with an error and never receive traces.
+  void negotiate_traces(const caf::actor& hdl) {
+    self()
+      ->request(hdl, caf::infinite, atom::peer_v, atom::trace_v)
+      .then(
+        [this, hdl](atom::ok) {
+          if (hdl_to_ostream_.count(hdl) != 0)
+            trace_peers_.emplace(hdl);
+        },
+        [hdl](const caf::error& err) {
+          BROKER_DEBUG("peer" << hdl << "does not read traces:" << err);
+        });
+  }
+
   /// Sends a handshake with filter in step #1.
   auto add(std::true_type send_own_filter, const caf::actor& hdl) {
     auto xs
@@ -884,6 +1197,57 @@ protected:
   /// Messages that are currently buffered.
   std::unordered_map<caf::actor, std::vector<caf::message>> blocked_msgs;
 
+  /// Stores when we started to buffer messages from a blocked peer.
+  std::unordered_map<caf::actor, std::chrono::steady_clock::time_point>
+    blocked_since_;
+
+  /// Caches the metrics for each peer.
+  std::unordered_map<caf::actor, peer_metrics> peer_metrics_;
+
+  /// Scratch space for `flush_peer_buffer`.
+  std::vector<size_t> path_sizes_;
+
+  /// Selects outbound messages for tracing.
+  detail::trace_sampler tracer_;
+
+  /// Stores whether the current message passed a publisher worker that had
+  /// the chance to sample it already.
+  bool sampled_upstream_ = false;
+
+  /// Stores whether the central buffer for peers may contain traced messages,
+  /// i.e., whether `flush_peer_buffer` needs to strip them for some peers.
+  bool strip_traces_ = false;
+
+  /// Stores peers that agreed on receiving trace contexts.
+  std::unordered_set<caf::actor> trace_peers_;
+
+  /// Passes trace contexts from publisher workers to us. Remains null if
+  /// tracing is off.
+  detail::trace_table_ptr outbound_traces_;
+
+  /// Passes trace contexts of messages from peers to subscriber workers.
+  detail::trace_table_ptr inbound_traces_;
+
+  /// Keeps messages for peers that lost their connection until they return.
+  detail::peer_spool<PeerId> spool_;
+
+  /// Configures how long we keep spooling for a disconnected peer.
+  timespan spool_timeout_;
+
+  /// Configures how we trade latency for throughput on peer streams.
+  detail::stream_goal stream_goal_ = detail::stream_goal::throughput;
+
+  /// Decides when to send underfull batches to peers. Remains empty if
+  /// `stream_goal_` is `throughput`.
+  std::unordered_map<caf::stream_slot, detail::batch_tuner> tuners_;
+
+  /// Stores outbound paths to peers that currently wait for credit.
+  std::unordered_set<caf::stream_slot> stalled_paths_;
+
+  /// Delivers data messages directly to local subscribers on the fast path.
+  /// Remains null unless `broker.local-fast-path` is enabled.
+  detail::local_subscriber_table_ptr local_subscribers_;
+
   /// Maps pending peer handles to output IDs. An invalid stream ID indicates
   /// that only "step #0" was performed so far. An invalid stream ID corresponds
   /// to `peer_status::connecting` and a valid stream ID cooresponds to
@@ -891,12 +1255,6 @@ protected:
   /// `peer_status::peered` if `governor->has_peer(x)` returns true.
   std::unordered_map<caf::actor, pending_connection> pending_connections_;
 
-  /// Helper for recording meta data of published messages.
-  detail::generator_file_writer_ptr recorder_;
-
-  /// Counts down when using a `recorder_` to cap maximum file entries.
-  size_t remaining_records_;
-
 private:
   Derived& dref() {
     return static_cast<Derived&>(*this);
@@ -14,6 +14,8 @@
 #include "broker/alm/stream_transport.hh"
 #include "broker/atoms.hh"
 #include "broker/configuration.hh"
+#include "broker/detail/core_recorder.hh"
+#include "broker/detail/metric_registry.hh"
 #include "broker/detail/network_cache.hh"
 #include "broker/detail/radix_tree.hh"
 #include "broker/endpoint.hh"
@@ -50,7 +52,15 @@ public:
   // --- construction ----------------------------------------------------------
 
   core_manager(caf::event_based_actor* ptr, const filter_type& filter,
-               broker_options opts, endpoint::clock* ep_clock);
+               broker_options opts, endpoint::clock* ep_clock,
+               detail::metric_registry_ptr metrics);
+
+  /// Constructs an additional shard of a sharded core. Shards neither record
+  /// messages nor emit status events, since the first shard takes care of
+  /// both.
+  core_manager(caf::event_based_actor* ptr, const filter_type& filter,
+               broker_options opts, endpoint::clock* ep_clock,
+               detail::metric_registry_ptr metrics, size_t shard);
 
   // --- initialization --------------------------------------------------------
 
@@ -70,6 +80,26 @@ public:
     return shutting_down_;
   }
 
+  detail::metric_registry& metrics() noexcept {
+    return *metrics_;
+  }
+
+  /// Returns the index of this core in a sharded core.
+  size_t shard() const noexcept {
+    return shard_;
+  }
+
+  /// Returns the labels for all metrics of this core that refer to `peer`.
+  /// Sharded cores add their index, because all cores of an endpoint share
+  /// one registry but add and remove their peers independently.
+  detail::metric_labels peer_metric_labels(const caf::node_id& peer) const;
+
+  /// Returns all cores of a sharded core or an empty list if the endpoint
+  /// runs a single core.
+  const std::vector<caf::actor>& shards() const noexcept {
+    return shards_;
+  }
+
   // --- filter management -----------------------------------------------------
 
   /// Sends the current filter to all peers.
@@ -94,6 +124,65 @@ public:
 
   void sync_with_status_subscribers(caf::actor new_peer);
 
+  void peer_disconnected(const peer_id_type& peer_id,
+                         const communication_handle_type& hdl,
+                         const error& reason);
+
+  void peer_removed(const peer_id_type& peer_id,
+                    const communication_handle_type& hdl);
+
+  // --- publishing ------------------------------------------------------------
+
+  using super::publish;
+
+  /// Publishes `x` unless another shard owns its topic, in which case this
+  /// core passes the message on to the owning shard.
+  void publish(data_message x);
+
+  void publish(node_message_content x);
+
+  // --- sharding --------------------------------------------------------------
+
+  /// Passes `x` to the shard that owns its topic unless this core owns the
+  /// topic.
+  /// @returns `true` if this core passed `x` on, `false` otherwise.
+  bool forward_to_shard(data_message& x);
+
+  /// Checks whether `ptr` points to one of the shards of our endpoint.
+  bool is_shard(const caf::strong_actor_ptr& ptr) const;
+
+  /// Returns the handles this core exchanges with peers during shard peering,
+  /// i.e., all shards or only this core if the endpoint is not sharded.
+  std::vector<caf::actor> shard_handles();
+
+  /// Asks the remote core `hdl` for its shards and peers each of our
+  /// additional shards with its remote counterpart. Removes the peering with
+  /// `hdl` if both cores run a different number of shards.
+  void connect_shards(const caf::actor& hdl);
+
+  /// Removes the peering with `hdl` after detecting a different number of
+  /// shards.
+  void reject_shards(const caf::actor& hdl);
+
+  /// Drops all peerings between our shards and the shards of `hdl`.
+  void disconnect_shards(const caf::actor& hdl);
+
+  // --- metrics ---------------------------------------------------------------
+
+  /// Updates all metrics that we compute on demand, e.g., buffer sizes.
+  void sample_metrics();
+
+  /// Returns whether at least one local subscriber receives messages on the
+  /// topic `topics::metrics`.
+  bool has_metrics_subscriber();
+
+  /// Starts publishing metrics periodically unless already active or disabled.
+  void start_metrics_timer();
+
+  /// Publishes all metrics to local subscribers and schedules the next tick
+  /// as long as there is at least one subscriber left.
+  void publish_metrics();
+
 private:
   // --- member variables ------------------------------------------------------
 
@@ -112,6 +201,24 @@ private:
   /// Keeps track of all actors that currently wait for handshakes to
   /// complete.
   std::unordered_map<caf::actor, size_t> peers_awaiting_status_sync_;
+
+  /// Collects metrics for this endpoint.
+  detail::metric_registry_ptr metrics_;
+
+  /// Configures how often we publish to `topics::metrics`.
+  timespan metrics_interval_;
+
+  /// Stores whether we have scheduled a tick for publishing metrics.
+  bool metrics_timer_active_ = false;
+
+  /// Stores the position of this core in `shards_`.
+  size_t shard_ = 0;
+
+  /// Stores all cores of the endpoint if it runs more than one core.
+  std::vector<caf::actor> shards_;
+
+  /// Stores the shards of each peer for tearing down shard peerings.
+  std::unordered_map<caf::actor, std::vector<caf::actor>> remote_shards_;
 };
 
 struct core_state {
@@ -129,6 +236,15 @@ struct core_state {
 using core_actor_type = caf::stateful_actor<core_state>;
 
 caf::behavior core_actor(core_actor_type* self, filter_type initial_filter,
-                         broker_options opts, endpoint::clock* clock);
+                         broker_options opts, endpoint::clock* clock,
+                         detail::metric_registry_ptr metrics);
+
+/// Spawns an additional core for a sharded endpoint. The endpoint hands the
+/// handles of all cores to each core via `(atom::shard, std::vector<actor>)`.
+caf::behavior core_shard_actor(core_actor_type* self,
+                               filter_type initial_filter, broker_options opts,
+                               endpoint::clock* clock,
+                               detail::metric_registry_ptr metrics,
+                               size_t shard);
 
 } // namespace broker
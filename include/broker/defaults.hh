@@ -1,7 +1,11 @@
 #pragma once
 
+#include <cstdint>
+
 #include "caf/string_view.hpp"
 
+#include "broker/time.hh"
+
 // This header contains hard-coded default values for various Broker options.
 
 namespace broker {
@@ -11,5 +15,43 @@ extern const caf::string_view recording_directory;
 
 extern const size_t output_generator_file_cap;
 
+extern const size_t recording_queue_size;
+
+extern const size_t flight_recorder_entries;
+
+extern const timespan flight_recorder_duration;
+
+extern const size_t flight_recorder_segments;
+
+extern const size_t flight_recorder_dumps;
+
+extern const timespan flight_recorder_dump_interval;
+
+extern const timespan metrics_interval;
+
+extern const uint16_t metrics_port;
+
+extern const caf::string_view metrics_address;
+
+extern const size_t trace_sample_rate;
+
+extern const size_t core_shards;
+
+extern const bool local_fast_path;
+
+extern const size_t peer_spool_size;
+
+extern const timespan peer_spool_timeout;
+
+extern const size_t peer_spool_disk_size;
+
+extern const caf::string_view peer_spool_directory;
+
+extern const caf::string_view peer_stream_goal;
+
+extern const size_t connect_workers;
+
+extern const timespan max_retry_interval;
+
 } // namespace defaults
 } // namespace broker
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "broker/detail/flight_recorder.hh"
+#include "broker/detail/generator_file_writer.hh"
+#include "broker/detail/spsc_queue.hh"
+#include "broker/time.hh"
+
+namespace broker::detail {
+
+/// Moves all file I/O of a `generator_file_writer` or a `flight_recorder` to a
+/// dedicated thread. The owner (usually the core actor) hands messages to the
+/// writer thread via a lock-free queue and never blocks on the file system.
+/// Messages are copy-on-write tuples, i.e., enqueueing a message only
+/// increments a reference count.
+class async_generator_file_writer {
+public:
+  // -- member types -----------------------------------------------------------
+
+  using value_type = generator_file_writer::data_or_command_message;
+
+  /// An entry in the queue.
+  struct entry {
+    value_type msg;
+    timestamp time;
+  };
+
+  // -- constructors, destructors, and assignment operators --------------------
+
+  /// @param writer Opened writer for the output file.
+  /// @param queue_size Maximum number of pending messages.
+  async_generator_file_writer(generator_file_writer_ptr writer,
+                              size_t queue_size);
+
+  /// @param recorder Flight recorder for storing the most recent messages.
+  /// @param dump_prefix Path prefix for files generated by `dump`.
+  /// @param queue_size Maximum number of pending messages.
+  /// @param max_dumps Removes the oldest file generated by `dump` when
+  ///                  exceeding this many files (0 = unlimited).
+  async_generator_file_writer(flight_recorder_ptr recorder,
+                              std::string dump_prefix, size_t queue_size,
+                              size_t max_dumps = 0);
+
+  async_generator_file_writer(const async_generator_file_writer&) = delete;
+
+  async_generator_file_writer&
+  operator=(const async_generator_file_writer&) = delete;
+
+  /// Writes all pending messages, closes the file and stops the thread.
+  ~async_generator_file_writer();
+
+  // -- properties -------------------------------------------------------------
+
+  /// Returns whether the writer thread encountered an error. A failed writer
+  /// discards all further messages.
+  bool failed() const noexcept {
+    return failed_.load();
+  }
+
+  /// Returns how many messages were discarded because the queue was full.
+  size_t dropped() const noexcept {
+    return dropped_.load();
+  }
+
+  // -- producer interface -----------------------------------------------------
+
+  /// Enqueues `x` with timestamp `t` for writing. Never blocks.
+  /// @returns `false` if the queue was full and the writer dropped `x`.
+  bool push(value_type x, timestamp t);
+
+  /// Asks the writer thread to persist all messages recorded so far. Flushes
+  /// the generator file or dumps the content of the flight recorder into a
+  /// new generator file.
+  void dump();
+
+private:
+  // -- thread interface -------------------------------------------------------
+
+  void run();
+
+  void start();
+
+  void wakeup();
+
+  caf::error do_write(const entry& x);
+
+  void do_dump();
+
+  // -- member variables -------------------------------------------------------
+
+  generator_file_writer_ptr writer_;
+
+  flight_recorder_ptr recorder_;
+
+  std::string dump_prefix_;
+
+  size_t num_dumps_ = 0;
+
+  size_t max_dumps_ = 0;
+
+  /// Stores the files generated by `dump`, from oldest to youngest.
+  std::deque<std::string> dump_files_;
+
+  spsc_queue<entry> queue_;
+
+  std::atomic<bool> failed_{false};
+
+  std::atomic<size_t> dropped_{0};
+
+  std::atomic<bool> sleeping_{false};
+
+  std::atomic<bool> dump_requested_{false};
+
+  bool done_ = false;
+
+  std::mutex mtx_;
+
+  std::condition_variable cv_;
+
+  std::thread thread_;
+};
+
+using async_generator_file_writer_ptr
+  = std::unique_ptr<async_generator_file_writer>;
+
+} // namespace broker::detail
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <utility>
+
+#include "broker/time.hh"
+
+namespace broker::detail {
+
+/// Selects how a core trades latency for throughput on peer streams.
+enum class stream_goal : uint8_t {
+  /// Sends only full batches and leaves underfull batches to CAF's batch
+  /// timeout, i.e., keeps CAF's default policy.
+  throughput,
+  /// Sends all buffered messages as soon as the peer grants credit.
+  latency,
+  /// Picks a batch size per peer from its round-trip time and throughput.
+  adaptive,
+};
+
+/// @relates stream_goal
+const char* to_string(stream_goal x) noexcept;
+
+/// @relates stream_goal
+bool convert(const std::string& src, stream_goal& dst) noexcept;
+
+/// Decides when a core sends an underfull batch to a peer. The tuner measures
+/// the round-trip time (RTT) from sending a batch until the peer acknowledges
+/// it and the rate at which the peer grants credit, i.e., how many messages per
+/// second it consumes. In adaptive mode, the tuner collects at most as many
+/// messages as the peer consumes in half an RTT. Hence, peers on a LAN receive
+/// small batches with little delay while peers on a WAN receive full batches.
+class batch_tuner {
+public:
+  /// Limits how many unacknowledged batches the tuner keeps track of.
+  static constexpr size_t max_in_flight = 64;
+
+  explicit batch_tuner(stream_goal goal = stream_goal::throughput)
+    : goal_(goal) {
+    // nop
+  }
+
+  stream_goal goal() const noexcept {
+    return goal_;
+  }
+
+  /// Returns the smoothed RTT or 0 if the tuner has no sample yet.
+  timespan rtt() const noexcept {
+    return rtt_;
+  }
+
+  /// Returns the smoothed number of messages per second the peer consumes or 0
+  /// if the tuner has no sample yet.
+  double rate() const noexcept {
+    return rate_;
+  }
+
+  /// Records that the path has sent all batches with an ID below `next_id` at
+  /// time `t`.
+  void sent(int64_t next_id, timestamp t);
+
+  /// Records that the peer acknowledged all batches up to `id` at time `t` and
+  /// granted `credit` for new messages.
+  void acked(int64_t id, int32_t credit, timestamp t);
+
+  /// Returns how many buffered messages justify an underfull batch when the
+  /// peer asks for batches of size `desired_batch_size`.
+  size_t target(size_t desired_batch_size) const noexcept;
+
+  /// Returns whether the core should send `buffered` messages right away
+  /// instead of waiting for a full batch.
+  bool flush(size_t buffered, size_t desired_batch_size) const noexcept {
+    return buffered > 0 && buffered >= target(desired_batch_size);
+  }
+
+private:
+  stream_goal goal_;
+
+  /// Stores the ID of the last batch and the time of each call to `sent`.
+  std::deque<std::pair<int64_t, timestamp>> in_flight_;
+
+  /// Stores the argument of the last call to `sent`.
+  int64_t next_id_ = 0;
+
+  /// Stores the time of the last call to `acked`.
+  timestamp last_ack_;
+
+  timespan rtt_{0};
+
+  double rate_ = 0;
+};
+
+} // namespace broker::detail
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+
+#include <caf/binary_serializer.hpp>
+#include <caf/fwd.hpp>
+
+#include "broker/detail/generator_file_writer.hh"
+
+namespace broker::detail {
+
+/// Compression algorithms for generator file blocks.
+using block_compression = generator_file_writer::format::compression;
+
+/// Buffer type for encoded and decoded blocks.
+using block_buffer = caf::binary_serializer::container_type;
+
+/// Checks whether Broker was built with support for `codec`.
+bool has_block_codec(block_compression codec) noexcept;
+
+/// Compresses `size` bytes at `data` into `out`, overriding its content.
+caf::error compress_block(block_compression codec, const void* data,
+                          size_t size, block_buffer& out);
+
+/// Decompresses `size` bytes at `data` into `out`, overriding its content.
+/// @param raw_size The size of the block before compression.
+caf::error decompress_block(block_compression codec, const void* data,
+                            size_t size, size_t raw_size, block_buffer& out);
+
+} // namespace broker::detail
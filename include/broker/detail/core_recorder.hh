@@ -5,21 +5,39 @@
 #include <caf/fwd.hpp>
 
 #include "broker/detail/assert.hh"
-#include "broker/detail/generator_file_writer.hh"
+#include "broker/detail/async_generator_file_writer.hh"
 #include "broker/filter_type.hh"
 #include "broker/logger.hh"
 #include "broker/message.hh"
+#include "broker/time.hh"
 
 namespace broker::detail {
 
+/// Tag type for creating a core without recording.
+struct no_recording_t {};
+
+constexpr auto no_recording = no_recording_t{};
+
 class core_recorder {
 public:
+  /// Constructs a disabled recorder.
+  core_recorder() = default;
+
   explicit core_recorder(caf::local_actor* self);
 
   void record_subscription(const filter_type& what);
 
   void record_peer(const caf::node_id& peer_id);
 
+  /// Persists all recorded messages. In flight recorder mode, this writes the
+  /// most recent messages to a new generator file in the recording directory.
+  void dump();
+
+  /// Dumps the flight recorder after a peering failed unless the recorder
+  /// already dumped automatically within the configured interval. Prevents a
+  /// flapping peer from flooding the recording directory.
+  void dump_on_failure();
+
   explicit operator bool() const noexcept {
     return writer_ != nullptr;
   }
@@ -32,16 +50,32 @@ public:
     return remaining_records_ ;
   }
 
+  /// Returns how many messages the recorder has passed to the writer.
+  size_t recorded() const noexcept {
+    return recorded_;
+  }
+
+  /// Returns how many messages the recorder has dropped because the writer
+  /// was too busy.
+  size_t dropped() const noexcept {
+    return dropped_;
+  }
+
   template <class T>
   bool try_record(const T& x) {
     BROKER_ASSERT(writer_ != nullptr);
     BROKER_ASSERT(remaining_records_ > 0);
-    if (auto err = writer_->write(x)) {
-      BROKER_WARNING("unable to write to generator file:" << err);
+    if (writer_->failed()) {
+      BROKER_WARNING("unable to write to generator file, stop recording");
       writer_ = nullptr;
       remaining_records_ = 0;
       return false;
     }
+    if (!writer_->push(x, now())) {
+      ++dropped_;
+      return false;
+    }
+    ++recorded_;
     if (--remaining_records_ == 0) {
       BROKER_DEBUG("reached recording cap, close file");
       writer_ = nullptr;
@@ -56,12 +90,25 @@ public:
 private:
   bool open_file(std::ofstream& fs, std::string file_name);
 
-  /// Helper for recording meta data of published messages.
-  detail::generator_file_writer_ptr writer_;
+  /// Helper for recording meta data of published messages in the background.
+  detail::async_generator_file_writer_ptr writer_;
 
   /// Counts down when using a `recorder_` to cap maximum file entries.
   size_t remaining_records_ = 0;
 
+  /// Counts messages passed to the writer.
+  size_t recorded_ = 0;
+
+  /// Counts messages that the writer rejected.
+  size_t dropped_ = 0;
+
+  /// Configures the minimum time between two calls to `dump_on_failure` that
+  /// actually dump the flight recorder.
+  timespan min_dump_interval_{0};
+
+  /// Stores when `dump_on_failure` dumped the flight recorder last.
+  timestamp last_failure_dump_;
+
   /// Handle for recording all subscribed topics.
   std::ofstream topics_file_;
 
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "broker/filter_type.hh"
+#include "broker/topic.hh"
+
+namespace broker::detail {
+
+/// Returns the index of the core shard that handles all messages on topic `x`.
+/// Shards own the topic space by the hash of the top-level component, i.e.,
+/// all topics with the same first component map to the same shard. Internal
+/// topics always map to the first shard.
+/// @pre `num_shards > 0`
+size_t shard_of(const topic& x, size_t num_shards);
+
+/// Splits `xs` into one filter per shard. Entries with a complete top-level
+/// component (i.e., entries that contain a separator) go to a single shard,
+/// while all other entries may match topics on any shard and thus go to all
+/// shards.
+/// @pre `num_shards > 0`
+std::vector<filter_type> partition(const filter_type& xs, size_t num_shards);
+
+} // namespace broker::detail
@@ -1,20 +1,34 @@
 #pragma once
 
+#include <cstddef>
 #include <random>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <caf/error.hpp>
 #include <caf/fwd.hpp>
 
 #include "broker/data.hh"
 #include "broker/internal_command.hh"
+#include "broker/message.hh"
+#include "broker/topic.hh"
 
 namespace broker {
 namespace detail {
 
 /// Generates random Broker ::data from recorded meta data.
+///
+/// In *pooled mode*, the generator synthesizes only a limited number of
+/// messages per topic and meta data shape and then cycles through them. Since
+/// messages are copy-on-write, producing a message from the pool merely
+/// increments a reference count.
 class data_generator {
 public:
+  /// Stops adding new pools after reaching this many distinct shapes per
+  /// message type in order to bound memory usage.
+  static constexpr size_t max_pools = 4096;
+
   /// Helper class for filling values with random content.
   struct mixer {
     data_generator& generator;
@@ -27,6 +41,17 @@ public:
 
   data_generator(caf::binary_deserializer& meta_data_source, unsigned seed = 0);
 
+  /// Returns the maximum number of messages per pool.
+  size_t pool_size() const noexcept {
+    return pool_size_;
+  }
+
+  /// Sets the maximum number of messages per pool. Zero (the default)
+  /// disables pooled mode.
+  void pool_size(size_t n) noexcept {
+    pool_size_ = n;
+  }
+
   caf::error operator()(data& x);
 
   caf::error operator()(internal_command& x);
@@ -39,6 +64,13 @@ public:
 
   caf::error generate(internal_command::type tag, internal_command& x);
 
+  /// Generates a message for topic `t` from the next meta data, reusing
+  /// previously generated messages in pooled mode.
+  caf::error generate(const topic& t, data_message& x);
+
+  /// @copydoc generate
+  caf::error generate(const topic& t, command_message& x);
+
   caf::error generate(vector& xs);
 
   caf::error generate(set& xs);
@@ -88,7 +120,26 @@ public:
 
   void shuffle(table& xs);
 
+  /// Consumes the meta data for a value of type `tag` without generating it.
+  caf::error skip(data::type tag);
+
+  /// Consumes the meta data for a command of type `tag` without generating it.
+  caf::error skip(internal_command::type tag);
+
 private:
+  template <class Message>
+  struct message_pool {
+    std::vector<Message> xs;
+    size_t next = 0;
+  };
+
+  template <class Message>
+  using pool_map = std::unordered_map<std::string, message_pool<Message>>;
+
+  template <class Value, class Message>
+  caf::error generate_pooled(pool_map<Message>& pools, const topic& t,
+                             Message& x);
+
   char next_char();
 
   uint8_t next_byte();
@@ -97,6 +148,13 @@ private:
   std::minstd_rand engine_;
   std::uniform_int_distribution<int16_t> char_generator_;
   std::uniform_int_distribution<uint16_t> byte_generator_;
+  size_t pool_size_ = 0;
+  pool_map<data_message> data_pools_;
+  pool_map<command_message> command_pools_;
+
+  /// Buffer for computing pool keys. Reusing the buffer avoids allocations
+  /// when looking up existing pools.
+  std::string key_;
 };
 
 } // namespace detail
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
@@ -106,4 +107,10 @@ std::string read(const path& p);
 /// Generates a path to a unique temporary file.
 std::string make_temp_file_name();
 
+/// Computes the size of a file or the total size of all files in a directory,
+/// recursively.
+/// @param p The path to examine.
+/// @returns the size in bytes or 0 if *p* does not exist.
+size_t disk_usage(const path& p);
+
 } // namespace broker::detail
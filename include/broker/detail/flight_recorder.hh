@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <string>
+
+#include <caf/fwd.hpp>
+
+#include "broker/detail/generator_file_writer.hh"
+#include "broker/time.hh"
+
+namespace broker::detail {
+
+/// Continuously records the most recent messages into a bounded set of
+/// rotating segment files. Unlike recording to a single generator file, the
+/// flight recorder never stops recording and never exceeds its limits. A
+/// `dump` merges all segments into a single generator file, i.e., it captures
+/// the traffic leading up to the dump.
+class flight_recorder {
+public:
+  // -- member types -----------------------------------------------------------
+
+  using value_type = generator_file_writer::data_or_command_message;
+
+  /// Configures how much history the flight recorder keeps.
+  struct limits {
+    /// Keeps (at least) the last `max_entries` entries. Zero disables this
+    /// limit.
+    size_t max_entries = 0;
+
+    /// Keeps (at least) the entries of the last `max_age`. Zero disables this
+    /// limit.
+    timespan max_age{0};
+
+    /// Number of segments for splitting the history. More segments reduce
+    /// disk usage overhead at the cost of more files.
+    size_t num_segments = 4;
+  };
+
+  // -- constructors, destructors, and assignment operators --------------------
+
+  /// @param directory Storage location for the segment files.
+  flight_recorder(std::string directory, limits cfg);
+
+  flight_recorder(const flight_recorder&) = delete;
+
+  flight_recorder& operator=(const flight_recorder&) = delete;
+
+  /// Closes and removes all segment files.
+  ~flight_recorder();
+
+  // -- properties -------------------------------------------------------------
+
+  /// Returns the number of entries in all segments.
+  size_t entries() const noexcept;
+
+  /// Returns the number of segments, including the current segment.
+  size_t num_segments() const noexcept {
+    return closed_.size() + (writer_ != nullptr ? 1 : 0);
+  }
+
+  // -- recording --------------------------------------------------------------
+
+  caf::error write(const value_type& x, timestamp t);
+
+  /// Merges all segments into a single generator file.
+  caf::error dump(const std::string& file_name);
+
+  /// Returns whether we recorded new entries since the last dump.
+  bool has_new_entries() const noexcept {
+    return new_entries_;
+  }
+
+private:
+  // -- member types -----------------------------------------------------------
+
+  struct segment {
+    std::string file_name;
+    size_t entries = 0;
+    timestamp first_time;
+    timestamp last_time;
+  };
+
+  // -- utility functions ------------------------------------------------------
+
+  caf::error close_segment();
+
+  void drop_segments(timestamp now);
+
+  // -- member variables -------------------------------------------------------
+
+  std::string dir_;
+
+  limits cfg_;
+
+  /// Closes the current segment after this many entries (if non-zero).
+  size_t max_segment_entries_;
+
+  /// Closes the current segment after this time span (if non-zero).
+  timespan max_segment_age_;
+
+  /// Stores all segments that we have closed, from oldest to youngest.
+  std::deque<segment> closed_;
+
+  /// Writes to the current segment.
+  generator_file_writer_ptr writer_;
+
+  /// Stores the current segment.
+  segment current_;
+
+  /// Generates unique file names for the segments.
+  size_t next_id_ = 0;
+
+  bool new_entries_ = false;
+};
+
+using flight_recorder_ptr = std::unique_ptr<flight_recorder>;
+
+} // namespace broker::detail
@@ -3,20 +3,29 @@
 #include <cstddef>
 #include <cstdio>
 #include <memory>
+#include <vector>
 
 #include <caf/binary_deserializer.hpp>
+#include <caf/binary_serializer.hpp>
+#include <caf/span.hpp>
 
 #include "broker/config.hh"
 #include "broker/detail/data_generator.hh"
+#include "broker/detail/generator_file_writer.hh"
 #include "broker/fwd.hh"
+#include "broker/time.hh"
 #include "broker/topic.hh"
 
 namespace broker::detail {
 
+/// Reads generator files in version 1 or version 2 of the file format. Only
+/// version 2 supports random access via `seek` and `decode_block`.
 class generator_file_reader {
 public:
   using value_type = caf::variant<data_message, command_message>;
 
+  using format = generator_file_writer::format;
+
 #ifdef BROKER_WINDOWS
   using file_handle = void*;
 #else
@@ -28,7 +37,8 @@ public:
   using mapped_pointer = void*;
 
   generator_file_reader(file_handle fd, mapper_handle mapper,
-                        mapped_pointer addr, size_t file_size);
+                        mapped_pointer addr, size_t file_size,
+                        uint8_t version = format::version);
 
   generator_file_reader(generator_file_reader&&) = delete;
 
@@ -40,17 +50,84 @@ public:
 
   ~generator_file_reader();
 
+  /// Loads the block index of a version 2 file, either from the trailer or
+  /// by scanning all block headers if the file has no (valid) trailer.
+  caf::error init();
+
   bool at_end() const;
 
-  /// @pre `at_end()`
+  /// @pre `at_end()` for version 1 files
   void rewind();
 
   caf::error read(value_type& x);
 
+  /// Reads the next entry into `x` and its recorded timestamp into `t`. Sets
+  /// `t` to the default-constructed timestamp for entries without time.
+  caf::error read(value_type& x, timestamp& t);
+
   caf::error skip();
 
   caf::error skip_to_end();
 
+  /// Positions the reader before the entry at index `n`. For version 2 files,
+  /// this operation only decodes the block containing the entry.
+  caf::error seek(size_t n);
+
+  /// Returns the format version of the file.
+  uint8_t version() const noexcept {
+    return version_;
+  }
+
+  /// Returns the maximum number of messages per pool of the data generator.
+  size_t pool_size() const noexcept {
+    return generator_.pool_size();
+  }
+
+  /// Enables pooled mode for the data generator if `n > 0`. Pools are local
+  /// to a block when calling `decode_block`.
+  /// @pre Nothing is calling `decode_block` concurrently.
+  void pool_size(size_t n) noexcept {
+    generator_.pool_size(n);
+  }
+
+  /// Checks whether the file stores a timestamp for each entry.
+  bool timestamped() const noexcept {
+    return timestamped_;
+  }
+
+  /// Returns the number of blocks in the file (always 0 for version 1).
+  size_t num_blocks() const noexcept {
+    return index_.size();
+  }
+
+  /// Returns the header of the block at index `i`.
+  /// @pre `i < num_blocks()`
+  const format::block_header& block(size_t i) const noexcept {
+    return index_[i].header;
+  }
+
+  /// Returns the serialized header and payload of the block at index `i`.
+  /// @pre `i < num_blocks()`
+  caf::span<const caf::byte> raw_block(size_t i) const noexcept;
+
+  /// Returns the index of the first entry in the block at index `i`.
+  /// @pre `i < num_blocks()`
+  size_t first_entry(size_t i) const noexcept {
+    return offsets_[i];
+  }
+
+  /// Appends all entries of the block at index `i` to `xs`. Safe to call
+  /// concurrently from multiple threads, since this member function does not
+  /// touch the state of the reader.
+  /// @pre `i < num_blocks()`
+  caf::error decode_block(size_t i, std::vector<value_type>& xs) const;
+
+  /// Appends all entries of the block at index `i` to `xs` and their
+  /// timestamps to `ts`.
+  /// @pre `i < num_blocks()`
+  caf::error decode_block(size_t i, std::vector<value_type>& xs,
+                          std::vector<timestamp>& ts) const;
+
   const std::vector<topic>& topics() const noexcept {
     return topic_table_;
   }
@@ -68,6 +145,27 @@ public:
   }
 
 private:
+  using buffer_type = caf::binary_serializer::container_type;
+
+  caf::span<const caf::byte> payload(size_t i, buffer_type& buf,
+                                     caf::error& err) const;
+
+  caf::error load_block(size_t i);
+
+  caf::error read_entry(caf::binary_deserializer& source,
+                        data_generator& generator,
+                        const std::vector<topic>& topics, uint8_t flags,
+                        timestamp& t, value_type& x) const;
+
+  caf::error decode_block_impl(size_t i, std::vector<value_type>& xs,
+                               std::vector<timestamp>* ts) const;
+
+  /// Loads the block index from the trailer.
+  /// @returns `false` if the file has no trailer or if the index is corrupt.
+  bool read_index();
+
+  caf::error scan_blocks();
+
   file_handle fd_;
   mapper_handle mapper_;
   mapped_pointer addr_;
@@ -78,6 +176,37 @@ private:
   size_t data_entries_ = 0;
   size_t command_entries_ = 0;
   bool sealed_ = false;
+
+  // -- version 2 state --------------------------------------------------------
+
+  uint8_t version_;
+
+  // Location and header of all blocks in the file.
+  std::vector<format::block_info> index_;
+
+  // Index of the first entry in each block.
+  std::vector<size_t> offsets_;
+
+  // Index of the next block for read().
+  size_t next_block_ = 0;
+
+  // Number of unread entries in the current block.
+  size_t block_remaining_ = 0;
+
+  // Topic table of the current block.
+  std::vector<topic> block_topics_;
+
+  // Flags of the current block.
+  uint8_t block_flags_ = 0;
+
+  // Timestamp of the last entry we have read from the current block.
+  timestamp block_time_;
+
+  // Stores whether all blocks in the file have timestamps.
+  bool timestamped_ = false;
+
+  // Stores the decompressed payload of the current block.
+  buffer_type block_buf_;
 };
 
 using generator_file_reader_ptr = std::unique_ptr<generator_file_reader>;
@@ -8,28 +8,119 @@
 #include <vector>
 
 #include <caf/binary_serializer.hpp>
+#include <caf/error.hpp>
 #include <caf/fwd.hpp>
+#include <caf/sec.hpp>
 #include <caf/variant.hpp>
 
 #include "broker/fwd.hh"
+#include "broker/time.hh"
+#include "broker/topic.hh"
 
 namespace broker {
 namespace detail {
 
+class generator_file_reader;
+
+/// Writes meta data of published messages to a *generator file*. Version 2 of
+/// the file format groups entries into blocks of (roughly) fixed size:
+///
+/// ~~~
+/// file    := header block* index trailer
+/// header  := magic:u32 version:u8
+/// block   := block_header payload
+/// payload := topic_count:u16 topic:str* entry*
+/// entry   := entry_type:u8 topic_id:u16 time_delta:varint? meta_data
+/// index   := topic:str* block_info*
+/// trailer := index_offset:u64 index_magic:u32
+/// ~~~
+///
+/// Blocks with the flag `timestamped` store for each entry the time since the
+/// previous entry (or since `first_time` for the first entry) in nanoseconds,
+/// encoded as zigzag varint.
+///
+/// Each block carries its own topic table and thus decodes independently of
+/// all other blocks. The index at the end of the file allows readers to seek
+/// to any block without scanning the file. If the index is missing (e.g.,
+/// because the writer crashed), readers can still recover all complete blocks
+/// by walking the block headers.
 class generator_file_writer {
 public:
   struct format {
     static constexpr uint32_t magic = 0x2EECC0DE;
 
-    static constexpr uint8_t version = 1;
+    static constexpr uint8_t version = 2;
 
     static constexpr size_t header_size = sizeof(magic) + sizeof(version);
 
+    /// Marks the end of a valid index.
+    static constexpr uint32_t index_magic = 0x1DEC5E55;
+
+    /// Size of the fixed-length trailer at the end of a file.
+    static constexpr size_t trailer_size = sizeof(uint64_t)
+                                           + sizeof(index_magic);
+
+    /// Default size threshold for closing a block.
+    static constexpr size_t default_block_size = 64 * 1024;
+
     enum class entry_type : uint8_t {
       new_topic,
       data_message,
       command_message,
     };
+
+    /// Flags for the `flags` field of a block header.
+    enum block_flags : uint8_t {
+      /// Each entry in the block carries a time delta.
+      timestamped = 0x01,
+    };
+
+    /// Selects an algorithm for compressing the payload of a block.
+    enum class compression : uint8_t {
+      none,
+      zlib,
+    };
+
+    /// Describes a single block in the file.
+    struct block_header {
+      /// Size of the payload on disk.
+      uint32_t stored_size = 0;
+
+      /// Size of the payload after decompression.
+      uint32_t raw_size = 0;
+
+      /// Number of entries in this block.
+      uint32_t entries = 0;
+
+      /// Number of data messages in this block.
+      uint32_t data_entries = 0;
+
+      /// Time of the first entry in this block.
+      timestamp first_time;
+
+      /// Time of the last entry in this block.
+      timestamp last_time;
+
+      /// Compression algorithm of the payload.
+      compression codec = compression::none;
+
+      /// Bitfield of `block_flags`.
+      uint8_t flags = 0;
+    };
+
+    /// Size of a serialized `block_header`.
+    static constexpr size_t block_header_size = 4 * sizeof(uint32_t)
+                                                + 2 * sizeof(int64_t)
+                                                + 2 * sizeof(uint8_t);
+
+    /// Stores the position of a block alongside its header.
+    struct block_info {
+      /// Offset of the block header from the beginning of the file.
+      uint64_t offset = 0;
+
+      /// Copy of the block header.
+      block_header header;
+    };
   };
 
   using data_or_command_message = caf::variant<data_message, command_message>;
@@ -48,37 +139,138 @@ public:
 
   caf::error open(std::string file_name);
 
+  /// Writes `x` with the current time as timestamp.
   caf::error write(const data_message& x);
 
+  /// Writes `x` with the current time as timestamp.
   caf::error write(const command_message& x);
 
+  /// Writes `x` with the current time as timestamp.
   caf::error write(const data_or_command_message& x);
 
+  /// Writes `x` with timestamp `t`.
+  caf::error write(const data_message& x, timestamp t);
+
+  /// Writes `x` with timestamp `t`.
+  caf::error write(const command_message& x, timestamp t);
+
+  /// Writes `x` with timestamp `t`.
+  caf::error write(const data_or_command_message& x, timestamp t);
+
+  /// Appends all blocks of `src` to the file without decoding them.
+  /// @pre `src.version() >= 2`
+  caf::error append(const generator_file_reader& src);
+
+  /// Writes the current block to the file and flushes the file handle.
   caf::error flush();
 
-  size_t flush_threshold() const noexcept {
-    return flush_threshold_;
+  /// Writes any pending block followed by the index and closes the file.
+  caf::error close();
+
+  size_t block_size() const noexcept {
+    return block_size_;
   }
 
-  void flush_threshold(size_t x) noexcept {
-    flush_threshold_ = x;
+  /// Sets the size threshold for closing blocks.
+  void block_size(size_t x) noexcept {
+    block_size_ = x;
   }
 
+  format::compression compression() const noexcept {
+    return compression_;
+  }
+
+  /// Selects the compression algorithm for all subsequent blocks.
+  /// @returns `false` if Broker was built without support for `x`.
+  bool compression(format::compression x) noexcept;
+
   bool operator!() const;
 
   explicit operator bool() const;
 
 private:
-  caf::error topic_id(const topic& x, uint16_t& id);
+  caf::error write_entry(format::entry_type type, const topic& t,
+                         timestamp ts);
 
+  caf::error write_block();
+
+  uint16_t topic_id(const topic& x);
+
+  // Buffers the entries of the current block.
   caf::binary_serializer::container_type buf_;
   caf::binary_serializer sink_;
+
+  // Scratch space for assembling and compressing blocks.
+  caf::binary_serializer::container_type payload_;
+  caf::binary_serializer::container_type compressed_;
+
   std::ofstream f_;
-  size_t flush_threshold_;
-  std::vector<topic> topic_table_;
   std::string file_name_;
+  size_t block_size_;
+  format::compression compression_;
+
+  // Current position in the file.
+  uint64_t offset_ = 0;
+
+  // Topics of the current block.
+  std::vector<topic> block_topics_;
+
+  // All topics that appear in the file.
+  std::vector<topic> topic_table_;
+
+  // Header of the current block.
+  format::block_header current_;
+
+  // Stores the location of all blocks we have written so far.
+  std::vector<format::block_info> index_;
 };
 
+/// Writes `x` as zigzag-encoded varint.
+template <class Serializer>
+caf::error write_varint(Serializer& sink, int64_t x) {
+  auto y = (static_cast<uint64_t>(x) << 1) ^ static_cast<uint64_t>(x >> 63);
+  while (y > 0x7F) {
+    auto byte = static_cast<uint8_t>((y & 0x7F) | 0x80);
+    if (auto err = sink(byte))
+      return err;
+    y >>= 7;
+  }
+  auto byte = static_cast<uint8_t>(y);
+  return sink(byte);
+}
+
+/// Reads a zigzag-encoded varint into `x`.
+template <class Deserializer>
+caf::error read_varint(Deserializer& source, int64_t& x) {
+  uint64_t y = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    uint8_t byte = 0;
+    if (auto err = source(byte))
+      return err;
+    y |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      x = static_cast<int64_t>(y >> 1) ^ -static_cast<int64_t>(y & 1);
+      return caf::none;
+    }
+  }
+  return caf::make_error(caf::sec::invalid_argument, "malformed varint");
+}
+
+/// @relates generator_file_writer::format::block_header
+template <class Inspector>
+typename Inspector::result_type
+inspect(Inspector& f, generator_file_writer::format::block_header& x) {
+  return f(x.stored_size, x.raw_size, x.entries, x.data_entries, x.first_time,
+           x.last_time, x.codec, x.flags);
+}
+
+/// @relates generator_file_writer::format::block_info
+template <class Inspector>
+typename Inspector::result_type
+inspect(Inspector& f, generator_file_writer::format::block_info& x) {
+  return f(x.offset, x.header);
+}
+
 using generator_file_writer_ptr = std::unique_ptr<generator_file_writer>;
 
 generator_file_writer_ptr make_generator_file_writer(const std::string& fname);
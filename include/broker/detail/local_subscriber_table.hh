@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#include <caf/allowed_unsafe_message_type.hpp>
+#include <caf/intrusive_ptr.hpp>
+#include <caf/ref_counted.hpp>
+
+#include "broker/detail/shared_subscriber_queue.hh"
+#include "broker/filter_type.hh"
+#include "broker/message.hh"
+
+namespace broker::detail {
+
+/// Lets cores write data messages straight into the queues of local
+/// subscribers instead of streaming them to a worker actor first. Cores never
+/// block on these queues, i.e., subscribers on the fast path do not slow down
+/// their peers. Instead, cores drop messages for subscribers with a full
+/// queue.
+class local_subscriber_table : public caf::ref_counted {
+public:
+  using queue_ptr = shared_subscriber_queue_ptr<>;
+
+  using queue_type = shared_subscriber_queue<>;
+
+  /// Registers `queue` for receiving messages that match `filter`. Drops
+  /// messages for `queue` while it holds `max_qsize` messages.
+  void add(queue_ptr queue, filter_type filter, size_t max_qsize);
+
+  /// Replaces the filter of `queue`.
+  void set_filter(const queue_type* queue, filter_type filter);
+
+  /// Stops delivering messages to `queue`.
+  void erase(const queue_type* queue);
+
+  /// Writes `x` into all queues with a matching filter that have room left.
+  /// @returns the number of queues that received `x`.
+  size_t deliver(const data_message& x);
+
+  /// Returns the number of registered queues.
+  size_t size() const noexcept {
+    return size_.load();
+  }
+
+private:
+  struct entry {
+    queue_ptr queue;
+    filter_type filter;
+    size_t max_qsize;
+  };
+
+  /// Guards `entries_`.
+  mutable std::mutex mtx_;
+
+  /// Stores all registered queues with their filter.
+  std::vector<entry> entries_;
+
+  /// Allows cores to skip the lock while no subscriber uses the fast path.
+  std::atomic<size_t> size_{0};
+};
+
+/// @relates local_subscriber_table
+using local_subscriber_table_ptr = caf::intrusive_ptr<local_subscriber_table>;
+
+/// @relates local_subscriber_table
+local_subscriber_table_ptr make_local_subscriber_table();
+
+} // namespace broker::detail
+
+CAF_ALLOW_UNSAFE_MESSAGE_TYPE(broker::detail::local_subscriber_table_ptr)
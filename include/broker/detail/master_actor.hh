@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <unordered_set>
 
 #include <caf/actor.hpp>
@@ -8,6 +9,7 @@
 #include <caf/event_based_actor.hpp>
 
 #include "broker/data.hh"
+#include "broker/detail/metric_registry.hh"
 #include "broker/detail/store_actor.hh"
 #include "broker/endpoint.hh"
 #include "broker/fwd.hh"
@@ -27,9 +29,25 @@ public:
   /// Owning smart pointer to a backend.
   using backend_pointer = std::unique_ptr<abstract_backend>;
 
+  /// Bundles the metrics we keep per type of command.
+  struct command_metrics {
+    /// Counts processed commands.
+    metric* count = nullptr;
+
+    /// Counts nanoseconds spent on processing commands.
+    metric* nanoseconds = nullptr;
+  };
+
   /// Initializes the object.
   void init(caf::event_based_actor* ptr, std::string&& nm,
-            backend_pointer&& bp, caf::actor&& parent, endpoint::clock* clock);
+            backend_pointer&& bp, caf::actor&& parent, endpoint::clock* clock,
+            metric_registry_ptr reg);
+
+  ~master_state();
+
+  /// Returns the metrics for commands of type `x`, creating them on first
+  /// access.
+  command_metrics& metrics_for(internal_command::type x);
 
   /// Sends `x` to all clones.
   void broadcast(internal_command&& x);
@@ -74,6 +92,12 @@ public:
 
   std::unordered_map<caf::actor_addr, caf::actor> clones;
 
+  /// Collects metrics for the endpoint.
+  metric_registry_ptr metrics;
+
+  /// Caches metrics for each type of command.
+  std::array<command_metrics, 10> cmd_metrics;
+
   bool exists(const data& key);
 
   static inline constexpr const char* name = "master_actor";
@@ -82,7 +106,7 @@ public:
 caf::behavior master_actor(caf::stateful_actor<master_state>* self,
                            caf::actor core, std::string id,
                            master_state::backend_pointer backend,
-                           endpoint::clock* clock);
+                           endpoint::clock* clock, metric_registry_ptr reg);
 
 } // namespace detail
 } // namespace broker
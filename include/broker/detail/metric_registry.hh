@@ -0,0 +1,155 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <caf/intrusive_ptr.hpp>
+#include <caf/ref_counted.hpp>
+
+#include "broker/data.hh"
+
+namespace broker::detail {
+
+/// An integer value that multiple threads may update concurrently.
+class metric {
+public:
+  // -- member types -----------------------------------------------------------
+
+  enum class type : uint8_t {
+    /// A value that only goes up, e.g., the number of received messages.
+    counter,
+    /// A value that goes up and down, e.g., the size of a queue.
+    gauge,
+  };
+
+  // -- constructors, destructors, and assignment operators --------------------
+
+  explicit metric(type kind) noexcept : kind_(kind), value_(0) {
+    // nop
+  }
+
+  metric(const metric&) = delete;
+
+  metric& operator=(const metric&) = delete;
+
+  // -- properties -------------------------------------------------------------
+
+  type kind() const noexcept {
+    return kind_;
+  }
+
+  int64_t value() const noexcept {
+    return value_.load(std::memory_order_relaxed);
+  }
+
+  // -- mutators ---------------------------------------------------------------
+
+  void inc(int64_t n = 1) noexcept {
+    value_.fetch_add(n, std::memory_order_relaxed);
+  }
+
+  void dec(int64_t n = 1) noexcept {
+    value_.fetch_sub(n, std::memory_order_relaxed);
+  }
+
+  void set(int64_t x) noexcept {
+    value_.store(x, std::memory_order_relaxed);
+  }
+
+private:
+  type kind_;
+  std::atomic<int64_t> value_;
+};
+
+/// @relates metric
+const char* to_string(metric::type x);
+
+/// Key-value pairs for telling apart metrics with the same name, e.g., the
+/// number of received messages per peer.
+using metric_labels = std::map<std::string, std::string>;
+
+/// The value of a single metric at the time of collecting it.
+struct metric_sample {
+  std::string name;
+  metric_labels labels;
+  metric::type kind;
+  int64_t value;
+};
+
+/// Keeps track of all metrics of an endpoint. Looking up or creating a metric
+/// requires a lock, but updating a metric is lock-free. Hence, instrumented
+/// code should look up its metrics once and then keep the reference.
+class metric_registry : public caf::ref_counted {
+public:
+  // -- member types -----------------------------------------------------------
+
+  using key_type = std::pair<std::string, metric_labels>;
+
+  // -- lookup -----------------------------------------------------------------
+
+  /// Returns the counter with given name and labels, creating it on first
+  /// access. The reference remains valid until removing the metric.
+  metric& counter(std::string name, metric_labels labels = {});
+
+  /// Returns the gauge with given name and labels, creating it on first
+  /// access. The reference remains valid until removing the metric.
+  metric& gauge(std::string name, metric_labels labels = {});
+
+  // -- removal ----------------------------------------------------------------
+
+  /// Removes all metrics that carry the label `key` with value `value`.
+  /// @warning invalidates all references to the removed metrics.
+  void remove(const std::string& key, const std::string& value);
+
+  /// Removes all metrics that carry all of the given `labels`.
+  /// @warning invalidates all references to the removed metrics.
+  void remove(const metric_labels& labels);
+
+  // -- observers --------------------------------------------------------------
+
+  /// Returns the number of registered metrics.
+  size_t size() const;
+
+  /// Returns the current value of all metrics, ordered by name and labels.
+  std::vector<metric_sample> collect() const;
+
+  /// Returns the current value of all metrics as a table that maps rendered
+  /// names to values, e.g., `broker_peer_received_messages{peer="..."}`.
+  table snapshot() const;
+
+private:
+  metric& get_or_add(metric::type kind, std::string name,
+                     metric_labels labels);
+
+  /// Guards `metrics_`.
+  mutable std::mutex mtx_;
+
+  /// Stores all metrics. Using `unique_ptr` keeps references to metrics
+  /// stable while adding new entries.
+  std::map<key_type, std::unique_ptr<metric>> metrics_;
+};
+
+/// @relates metric_registry
+using metric_registry_ptr = caf::intrusive_ptr<metric_registry>;
+
+/// @relates metric_registry
+metric_registry_ptr make_metric_registry();
+
+/// Renders a metric name with labels in the Prometheus text format, e.g.,
+/// `name{key1="value1",key2="value2"}`.
+/// @relates metric_registry
+std::string render_metric_name(const std::string& name,
+                               const metric_labels& labels);
+
+/// Renders `xs` in the Prometheus text exposition format.
+/// @pre `xs` is sorted by name, e.g., the result of `collect()`
+/// @relates metric_registry
+std::string render_prometheus(const std::vector<metric_sample>& xs);
+
+} // namespace broker::detail
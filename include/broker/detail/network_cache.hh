@@ -1,18 +1,25 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <deque>
+#include <functional>
 #include <set>
 #include <string>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include <caf/actor.hpp>
 #include <caf/event_based_actor.hpp>
 #include <caf/io/middleman.hpp>
+#include <caf/io/scribe.hpp>
 #include <caf/openssl/manager.hpp>
+#include <caf/openssl/middleman_actor.hpp>
 #include <caf/optional.hpp>
 #include <caf/result.hpp>
 
+#include "broker/detail/unix_socket.hh"
 #include "broker/fwd.hh"
 #include "broker/logger.hh"
 #include "broker/network_info.hh"
@@ -30,6 +37,24 @@ public:
 
   void set_use_ssl(bool use_ssl_) { use_ssl = use_ssl_; }
 
+  /// Lets up to `n` helper threads establish connections in parallel instead
+  /// of the middleman, which connects to one peer at a time. Attempts beyond
+  /// that limit wait in line. Passing 0 disables the helpers.
+  void set_connect_workers(size_t n) {
+    connect_workers_ = n;
+  }
+
+  /// Returns the number of addresses with a pending connection attempt.
+  size_t pending_connects() const noexcept {
+    return pending_.size();
+  }
+
+  /// Returns the number of connection attempts that currently wait for a
+  /// helper thread.
+  size_t queued_connects() const noexcept {
+    return queued_connects_.size();
+  }
+
   /// Either returns an actor handle immediately if the entry is cached or
   /// queries the middleman actor and responds later via response promise.
   caf::result<caf::actor> fetch(const network_info& x);
@@ -42,27 +67,95 @@ public:
       f(*y);
       return;
     }
+    // Share a single connection attempt, i.e., a single TLS handshake, between
+    // all requests for the same address.
+    auto& waiters = pending_[x];
+    waiters.emplace_back(std::move(f), std::move(g));
+    if (waiters.size() > 1) {
+      BROKER_DEBUG("join pending connection attempt to" << x);
+      return;
+    }
+    auto on_connect = [=](const node_id&, strong_actor_ptr& res,
+                          std::set<std::string>& ifs) {
+      if (!ifs.empty())
+        connect_failed(x, sec::unexpected_actor_messaging_interface);
+      else if (res == nullptr)
+        connect_failed(x, sec::no_actor_published_at_port);
+      else {
+        auto hdl = actor_cast<actor>(std::move(res));
+        hdls_.emplace(x, hdl);
+        addrs_.emplace(hdl, x);
+        connect_succeeded(x, hdl);
+      }
+    };
+    auto on_error = [=](error& err) { connect_failed(x, std::move(err)); };
+    // Addresses with the unix:// scheme name a UNIX domain socket.
+    if (auto path = unix_socket_path_of(x.address)) {
+      auto& sys = self->home_system();
+      auto ptr = connect_unix_socket(sys, *path);
+      if (!ptr) {
+        on_error(ptr.error());
+        return;
+      }
+      BROKER_INFO("initiating connection to" << x << "via" << *path);
+      self
+        ->request(basp_broker(sys), infinite, atom::connect_v, std::move(*ptr),
+                  uint16_t{0})
+        .then(on_connect, on_error);
+      return;
+    }
     BROKER_INFO("initiating connection to"
                 << (x.address + ":" + std::to_string(x.port))
                 << (use_ssl ? "(SSL)" : "(no SSL)"));
+    if (connect_workers_ > 0) {
+      auto start = [=]() mutable {
+        ++active_connects_;
+        auto& sys = self->home_system();
+        if (use_ssl) {
+          // The OpenSSL manager runs a single middleman actor that blocks
+          // while connecting. A private instance of that actor runs on its
+          // own thread and hands the SSL connection to the BASP broker.
+          auto worker = openssl::make_middleman_actor(sys, basp_broker(sys));
+          self->request(worker, infinite, atom::connect_v, x.address, x.port)
+            .then(
+              [=](const node_id& nid, strong_actor_ptr& res,
+                  std::set<std::string>& ifs) mutable {
+                anon_send_exit(worker, exit_reason::user_shutdown);
+                connect_done();
+                on_connect(nid, res, ifs);
+              },
+              [=](error& err) mutable {
+                anon_send_exit(worker, exit_reason::user_shutdown);
+                connect_done();
+                on_error(err);
+              });
+          return;
+        }
+        auto worker = self->spawn<caf::detached>(connect_worker);
+        self->request(worker, infinite, atom::connect_v, x.address, x.port)
+          .then(
+            [=](io::scribe_ptr& ptr) mutable {
+              connect_done();
+              self
+                ->request(basp_broker(sys), infinite, atom::connect_v,
+                          std::move(ptr), x.port)
+                .then(on_connect, on_error);
+            },
+            [=](error& err) mutable {
+              connect_done();
+              on_error(err);
+            });
+      };
+      if (active_connects_ < connect_workers_)
+        start();
+      else
+        queued_connects_.emplace_back(std::move(start));
+      return;
+    }
     auto hdl = (use_ssl ? self->home_system().openssl_manager().actor_handle()
                         : self->home_system().middleman().actor_handle());
     self->request(hdl, infinite, atom::connect_v, x.address, x.port)
-      .then(
-        [=](const node_id&, strong_actor_ptr& res,
-            std::set<std::string>& ifs) mutable {
-          if (!ifs.empty())
-            g(sec::unexpected_actor_messaging_interface);
-          else if (res == nullptr)
-            g(sec::no_actor_published_at_port);
-          else {
-            auto hdl = actor_cast<actor>(std::move(res));
-            hdls_.emplace(x, hdl);
-            addrs_.emplace(hdl, x);
-            f(std::move(hdl));
-          }
-        },
-        [=](error& err) mutable { g(std::move(err)); });
+      .then(on_connect, on_error);
   }
 
   template <class OnResult, class OnError>
@@ -104,15 +197,42 @@ public:
   void remove(const network_info& x);
 
 private:
+  // Establishes a single TCP connection on a dedicated thread.
+  static caf::behavior connect_worker(caf::event_based_actor* self);
+
+  // Starts the next queued connection attempt, if any.
+  void connect_done();
+
+  // Passes `hdl` to all requests that wait for a connection to `x`.
+  void connect_succeeded(const network_info& x, const caf::actor& hdl);
+
+  // Passes `err` to all requests that wait for a connection to `x`.
+  void connect_failed(const network_info& x, caf::error err);
+
+  using waiter = std::pair<std::function<void(caf::actor)>,
+                           std::function<void(caf::error)>>;
+
   // Parent.
   caf::event_based_actor* self;
   bool use_ssl = true;
 
+  // Maximum number of helper threads for establishing TCP connections.
+  size_t connect_workers_ = 0;
+
+  // Number of helper threads that currently establish a TCP connection.
+  size_t active_connects_ = 0;
+
+  // Connection attempts that wait for a helper thread.
+  std::deque<std::function<void()>> queued_connects_;
+
   // Maps remote actor handles to network addresses.
   std::unordered_map<caf::actor, network_info> addrs_;
 
   // Maps network addresses to remote actor handles.
   std::unordered_map<network_info, caf::actor> hdls_;
+
+  // Maps network addresses to requests that wait for a connection attempt.
+  std::unordered_map<network_info, std::vector<waiter>> pending_;
 };
 
 } // namespace detail
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <caf/error.hpp>
+
+#include "broker/detail/generator_file_reader.hh"
+#include "broker/time.hh"
+
+namespace broker::detail {
+
+/// Decodes the blocks of a generator file on multiple threads. Worker threads
+/// claim blocks in file order and decode them into batches ahead of time,
+/// while the consumer receives the batches in file order. Since
+/// `generator_file_reader::decode_block` seeds the data generator per block,
+/// the output does not depend on the number of threads.
+/// @pre `reader->version() >= 2`
+class parallel_generator_file_reader {
+public:
+  // -- member types -----------------------------------------------------------
+
+  using value_type = generator_file_reader::value_type;
+
+  /// All entries of a single block.
+  struct batch {
+    /// Index of the block in the generator file.
+    size_t block = 0;
+
+    /// Decoded messages.
+    std::vector<value_type> xs;
+
+    /// Recorded timestamps, one per message.
+    std::vector<timestamp> ts;
+  };
+
+  // -- constructors, destructors, and assignment operators --------------------
+
+  /// @param reader Initialized reader for the generator file.
+  /// @param num_threads Number of worker threads.
+  /// @param max_pending Maximum number of decoded batches waiting for the
+  ///                    consumer.
+  /// @param cycle Restarts at the first block after reaching the end of the
+  ///              file if `true`, i.e., the reader never reaches the end.
+  parallel_generator_file_reader(generator_file_reader_ptr reader,
+                                 size_t num_threads, size_t max_pending,
+                                 bool cycle);
+
+  parallel_generator_file_reader(const parallel_generator_file_reader&)
+    = delete;
+
+  parallel_generator_file_reader&
+  operator=(const parallel_generator_file_reader&) = delete;
+
+  /// Stops all worker threads.
+  ~parallel_generator_file_reader();
+
+  // -- properties -------------------------------------------------------------
+
+  const generator_file_reader& reader() const noexcept {
+    return *reader_;
+  }
+
+  size_t num_threads() const noexcept {
+    return threads_.size();
+  }
+
+  /// Checks whether the consumer has received all batches.
+  bool at_end() const noexcept;
+
+  // -- consumer interface -----------------------------------------------------
+
+  /// Moves the next batch in file order into `x`, blocking until a worker
+  /// thread has decoded it.
+  /// @pre `!at_end()`
+  caf::error next(batch& x);
+
+private:
+  // -- member types -----------------------------------------------------------
+
+  struct slot {
+    batch content;
+    caf::error err;
+    bool ready = false;
+  };
+
+  // -- thread interface -------------------------------------------------------
+
+  void run();
+
+  // -- member variables -------------------------------------------------------
+
+  generator_file_reader_ptr reader_;
+
+  bool cycle_;
+
+  /// Ring buffer for decoded batches, indexed by sequence number.
+  std::vector<slot> slots_;
+
+  /// Sequence number of the next batch for the consumer.
+  size_t consumed_ = 0;
+
+  /// Sequence number of the next block for the workers.
+  size_t claimed_ = 0;
+
+  bool done_ = false;
+
+  std::mutex mtx_;
+
+  std::condition_variable producer_cv_;
+
+  std::condition_variable consumer_cv_;
+
+  std::vector<std::thread> threads_;
+};
+
+using parallel_generator_file_reader_ptr
+  = std::unique_ptr<parallel_generator_file_reader>;
+
+} // namespace broker::detail
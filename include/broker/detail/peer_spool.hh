@@ -0,0 +1,270 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <ios>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include <caf/binary_deserializer.hpp>
+#include <caf/binary_serializer.hpp>
+
+#include "broker/detail/filesystem.hh"
+#include "broker/detail/prefix_matcher.hh"
+#include "broker/filter_type.hh"
+#include "broker/logger.hh"
+#include "broker/message.hh"
+
+namespace broker::detail {
+
+/// Keeps messages for disconnected peers until they re-peer. Each spool holds
+/// at most `capacity` messages in memory and drops the oldest message when
+/// full. With an overflow directory, each spool serializes up to
+/// `disk_capacity` further messages to a file instead and drops new messages
+/// once that file is full as well.
+template <class PeerId>
+class peer_spool {
+public:
+  // -- member types -----------------------------------------------------------
+
+  using message_type = generic_node_message<PeerId>;
+
+  using clock_type = std::chrono::steady_clock;
+
+  // -- constructors, destructors, and assignment operators --------------------
+
+  explicit peer_spool(size_t capacity = 0) : capacity_(capacity) {
+    // nop
+  }
+
+  peer_spool(const peer_spool&) = delete;
+
+  peer_spool& operator=(const peer_spool&) = delete;
+
+  /// Removes all overflow files.
+  ~peer_spool() {
+    for (auto& kvp : spools_)
+      discard(kvp.second);
+  }
+
+  // -- properties -------------------------------------------------------------
+
+  /// Sets the maximum number of messages per peer. A capacity of 0 disables
+  /// spooling.
+  void capacity(size_t x) noexcept {
+    capacity_ = x;
+  }
+
+  /// Lets each spool write up to `disk_capacity` messages beyond its capacity
+  /// to a file. File names start with `prefix`, e.g., `/var/spool/broker-`.
+  /// A `disk_capacity` of 0 disables the overflow.
+  void overflow(std::string prefix, size_t disk_capacity) {
+    overflow_prefix_ = std::move(prefix);
+    disk_capacity_ = disk_capacity;
+  }
+
+  /// Returns whether spooling is enabled.
+  bool enabled() const noexcept {
+    return capacity_ > 0;
+  }
+
+  /// Returns whether no spool exists.
+  bool empty() const noexcept {
+    return spools_.empty();
+  }
+
+  /// Returns whether a spool exists for `peer`.
+  bool contains(const PeerId& peer) const {
+    return spools_.count(peer) != 0;
+  }
+
+  /// Returns the number of messages in the spool for `peer`, including
+  /// messages in its overflow file.
+  size_t size(const PeerId& peer) const {
+    auto i = spools_.find(peer);
+    return i != spools_.end() ? i->second.buf.size() + i->second.on_disk : 0;
+  }
+
+  // -- spooling ---------------------------------------------------------------
+
+  /// Starts spooling all messages for `peer` that match `filter`.
+  void open(const PeerId& peer, filter_type filter) {
+    if (!enabled())
+      return;
+    auto& e = spools_[peer];
+    e.filter = std::move(filter);
+    e.opened = clock_type::now();
+  }
+
+  /// Adds `x` to the spool of `peer` regardless of its filter, e.g., for
+  /// messages that were still buffered for `peer` when it disconnected.
+  void add(const PeerId& peer, const message_type& x) {
+    if (auto i = spools_.find(peer); i != spools_.end())
+      append(i->second, x);
+  }
+
+  /// Adds `x` to all spools with a matching filter.
+  void add(const message_type& x) {
+    prefix_matcher matches;
+    for (auto& kvp : spools_)
+      if (matches(kvp.second.filter, get_topic(x.content)))
+        append(kvp.second, x);
+  }
+
+  /// Stops spooling for `peer` and appends all spooled messages to `out`.
+  /// @returns the number of messages that the spool dropped.
+  template <class Container>
+  size_t take(const PeerId& peer, Container& out) {
+    auto i = spools_.find(peer);
+    if (i == spools_.end())
+      return 0;
+    auto& e = i->second;
+    out.insert(out.end(), std::make_move_iterator(e.buf.begin()),
+               std::make_move_iterator(e.buf.end()));
+    if (e.on_disk > 0)
+      e.dropped += read_overflow(e, out);
+    auto result = e.dropped;
+    discard(e);
+    spools_.erase(i);
+    return result;
+  }
+
+  /// Discards all spools that exist for longer than `timeout`.
+  /// @returns the number of discarded spools.
+  size_t expire(clock_type::duration timeout) {
+    auto cutoff = clock_type::now() - timeout;
+    size_t result = 0;
+    for (auto i = spools_.begin(); i != spools_.end();) {
+      if (i->second.opened <= cutoff) {
+        discard(i->second);
+        i = spools_.erase(i);
+        ++result;
+      } else {
+        ++i;
+      }
+    }
+    return result;
+  }
+
+private:
+  struct entry {
+    filter_type filter;
+    std::deque<message_type> buf;
+    size_t dropped = 0;
+    clock_type::time_point opened;
+    std::string file_name;
+    std::ofstream file;
+    size_t on_disk = 0;
+  };
+
+  void append(entry& e, const message_type& x) {
+    // Once a spool overflows, all further messages go to disk in order to
+    // keep the order of messages.
+    if (e.on_disk == 0 && e.buf.size() < capacity_) {
+      e.buf.push_back(x);
+      return;
+    }
+    if (e.on_disk < disk_capacity_ && write_overflow(e, x))
+      return;
+    if (e.on_disk > 0) {
+      ++e.dropped;
+      return;
+    }
+    e.buf.pop_front();
+    ++e.dropped;
+    e.buf.push_back(x);
+  }
+
+  bool write_overflow(entry& e, const message_type& x) {
+    if (!e.file.is_open()) {
+      // Never re-open the file after an error, because the message that
+      // failed would be missing in the middle.
+      if (e.on_disk > 0)
+        return false;
+      e.file_name = overflow_prefix_ + std::to_string(next_file_id_++) + ".dat";
+      e.file.open(e.file_name, std::ios::binary | std::ios::trunc);
+      if (!e.file) {
+        BROKER_WARNING("cannot open spool file" << e.file_name);
+        return false;
+      }
+    }
+    scratch_.clear();
+    caf::binary_serializer sink{nullptr, scratch_};
+    if (auto err = sink(x)) {
+      BROKER_WARNING("cannot serialize message for spool file"
+                     << e.file_name << ":" << err);
+      return false;
+    }
+    auto size = static_cast<std::streamsize>(scratch_.size());
+    if (!e.file.write(scratch_.data(), size)) {
+      BROKER_WARNING("cannot write to spool file" << e.file_name);
+      e.file.close();
+      // Without any message on disk, we may start over with a new file.
+      if (e.on_disk == 0) {
+        remove(e.file_name);
+        e.file_name.clear();
+      }
+      return false;
+    }
+    ++e.on_disk;
+    return true;
+  }
+
+  /// Appends all messages from the overflow file of `e` to `out`.
+  /// @returns the number of messages that we failed to read.
+  template <class Container>
+  size_t read_overflow(entry& e, Container& out) {
+    e.file.close();
+    std::ifstream in{e.file_name, std::ios::binary};
+    if (!in) {
+      BROKER_WARNING("cannot open spool file" << e.file_name);
+      return e.on_disk;
+    }
+    scratch_.assign(std::istreambuf_iterator<char>{in},
+                    std::istreambuf_iterator<char>{});
+    // The file contains serialized messages back to back. After a failed
+    // write, it may end with a partial message that we never counted.
+    caf::binary_deserializer source{nullptr, scratch_};
+    size_t num_read = 0;
+    while (num_read < e.on_disk && source.remaining() > 0) {
+      message_type x;
+      if (auto err = source(x)) {
+        BROKER_WARNING("cannot read from spool file" << e.file_name << ":"
+                                                      << err);
+        break;
+      }
+      out.emplace_back(std::move(x));
+      ++num_read;
+    }
+    return e.on_disk - num_read;
+  }
+
+  /// Closes and removes the overflow file of `e`.
+  void discard(entry& e) {
+    e.file.close();
+    if (!e.file_name.empty()) {
+      remove(e.file_name);
+      e.file_name.clear();
+    }
+  }
+
+  size_t capacity_;
+
+  size_t disk_capacity_ = 0;
+
+  std::string overflow_prefix_;
+
+  size_t next_file_id_ = 0;
+
+  /// Scratch space for serializing and deserializing messages.
+  caf::binary_serializer::container_type scratch_;
+
+  std::unordered_map<PeerId, entry> spools_;
+};
+
+} // namespace broker::detail
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "broker/config.hh"
+
+// Static tracepoints (USDT) for attaching tools such as bpftrace, perf, or
+// SystemTap to a running process. Building with BROKER_ENABLE_USDT turns
+// each probe into a single nop instruction plus an ELF note. Otherwise, the
+// macros expand to nothing. Probes only take integers and pointers to
+// existing strings, i.e., evaluating the arguments costs next to nothing.
+//
+// Provider `broker` offers the following probes:
+//
+// | Probe               | Arguments                                    |
+// |---------------------|----------------------------------------------|
+// | publish             | topic (char*), number of messages            |
+// | core_batch          | batch size                                   |
+// | peer_receive        | batch size                                   |
+// | peer_send           | number of messages moved to a peer's buffer  |
+// | subscriber_enqueue  | number of messages, queue size afterwards    |
+// | subscriber_dequeue  | number of messages, queue size afterwards    |
+// | store_command       | store (char*), command type, nanoseconds     |
+// | store_expire        | store (char*)                                |
+//
+// For example, the following bpftrace script counts published messages per
+// topic:
+//
+//   usdt:/path/to/libbroker.so:broker:publish { @[str(arg0)] = sum(arg1); }
+
+#ifdef BROKER_HAS_USDT
+
+#include <sys/sdt.h>
+
+#define BROKER_PROBE1(name, a) DTRACE_PROBE1(broker, name, a)
+#define BROKER_PROBE2(name, a, b) DTRACE_PROBE2(broker, name, a, b)
+#define BROKER_PROBE3(name, a, b, c) DTRACE_PROBE3(broker, name, a, b, c)
+
+#else // BROKER_HAS_USDT
+
+#define BROKER_PROBE1(name, a) static_cast<void>(0)
+#define BROKER_PROBE2(name, a, b) static_cast<void>(0)
+#define BROKER_PROBE3(name, a, b, c) static_cast<void>(0)
+
+#endif // BROKER_HAS_USDT
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <caf/actor.hpp>
+#include <caf/behavior.hpp>
+#include <caf/io/broker.hpp>
+#include <caf/io/connection_handle.hpp>
+
+#include "broker/detail/metric_registry.hh"
+
+namespace broker::detail {
+
+/// Serves the metrics in `reg` in the Prometheus text format via HTTP on
+/// `address:port`, i.e., answers `GET /metrics` requests. Asks `core` to
+/// update all sampled metrics before answering a request.
+caf::behavior prometheus_actor(caf::io::broker* self, uint16_t port,
+                               std::string address, metric_registry_ptr reg,
+                               caf::actor core);
+
+/// Handles a single HTTP connection for the `prometheus_actor`.
+caf::behavior prometheus_connection(caf::io::broker* self,
+                                    caf::io::connection_handle hdl,
+                                    metric_registry_ptr reg, caf::actor core);
+
+} // namespace broker::detail
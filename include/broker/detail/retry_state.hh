@@ -1,11 +1,13 @@
 #pragma once
 
 #include <cstdint>
+#include <random>
 
 #include <caf/allowed_unsafe_message_type.hpp>
 #include <caf/response_promise.hpp>
 
 #include "broker/network_info.hh"
+#include "broker/time.hh"
 
 namespace broker::detail {
 
@@ -15,6 +17,13 @@ struct retry_state {
   uint32_t count;
 };
 
+/// Returns how long to wait before the next connection attempt after `count`
+/// failed attempts. The delay starts at `base` and doubles with each failed
+/// attempt until reaching `max_delay`. A random jitter of up to 50% on top
+/// keeps peers that lost the same node from reconnecting in lockstep.
+timespan retry_delay(timespan base, uint32_t count, timespan max_delay,
+                     std::minstd_rand& rng);
+
 } // namespace broker::detail
 
 CAF_ALLOW_UNSAFE_MESSAGE_TYPE(broker::detail::retry_state)
@@ -55,6 +55,7 @@ public:
       fun(std::move(*i));
     auto old_size = xs.size();
     xs.erase(b, e);
+    this->count_consumed(n);
     auto new_size = xs.size();
     // Extinguish the flare if we reach the capacity or fire it if we drop
     // below the capacity again.
@@ -79,6 +80,7 @@ public:
     BROKER_ASSERT(xs_old_size < capacity_);
     for (; first != last; ++first)
       xs.emplace_back(t, std::move(*first));
+    this->count_produced(xs.size() - xs_old_size);
     if (xs.size() >= capacity_) {
       // Extinguish the flare to cause the *next* produce to block.
       this->fx_.extinguish();
@@ -95,6 +97,7 @@ public:
     auto xs_old_size = xs.size();
     BROKER_ASSERT(xs_old_size < capacity_);
     xs.emplace_back(t, std::move(y));
+    this->count_produced(1);
     if (xs.size() >= capacity_) {
       // Extinguish the flare to cause the *next* produce to block.
       this->fx_.extinguish();
@@ -106,9 +109,19 @@ public:
     return capacity_;
   }
 
+  /// Like `shared_queue::metrics`, but also counts how often producers had
+  /// to wait for the consumer.
+  /// @pre no other thread accesses the queue yet
+  void metrics(metric_registry_ptr reg, const std::string& prefix) {
+    blocked_ = &reg->counter(prefix + "_blocked_total");
+    super::metrics(std::move(reg), prefix);
+  }
+
 private:
   void await_consumer(guard_type& guard) {
     // Block the caller until the consumer catched up.
+    if (blocked_ != nullptr)
+      blocked_->inc();
     guard.unlock();
     this->fx_.await_one();
     guard.lock();
@@ -122,6 +135,9 @@ private:
 
   // Configures the amound of items for xs_.
   const size_t capacity_;
+
+  /// Counts how often producers had to wait for the consumer.
+  metric* blocked_ = nullptr;
 };
 
 template <class ValueType = data_message>
@@ -3,6 +3,7 @@
 #include <atomic>
 #include <deque>
 #include <mutex>
+#include <string>
 #include <thread>
 #include <condition_variable>
 
@@ -13,6 +14,7 @@
 #include "broker/topic.hh"
 
 #include "broker/detail/flare.hh"
+#include "broker/detail/metric_registry.hh"
 
 namespace broker {
 namespace detail {
@@ -74,11 +76,54 @@ public:
     return fx_.await_one(abs_timeout);
   }
 
+  /// Reports the number of queued items, the number of items passing through
+  /// the queue, and the number of discarded items to `reg`.
+  /// Multiple queues with the same `prefix` share their metrics.
+  /// @pre no other thread accesses the queue yet
+  void metrics(metric_registry_ptr reg, const std::string& prefix) {
+    depth_ = &reg->gauge(prefix + "_queued_messages");
+    total_ = &reg->counter(prefix + "_messages_total");
+    dropped_ = &reg->counter(prefix + "_dropped_messages_total");
+    registry_ = std::move(reg);
+  }
+
+  ~shared_queue() override {
+    // Anything left in the queue never reaches its destination.
+    if (depth_ != nullptr && !xs_.empty()) {
+      auto n = static_cast<int64_t>(xs_.size());
+      depth_->dec(n);
+      dropped_->inc(n);
+    }
+  }
+
 protected:
   shared_queue() : pending_(0) {
     // nop
   }
 
+  /// Updates the metrics after adding `n` items.
+  /// @pre `mtx_` is locked
+  void count_produced(size_t n) {
+    if (depth_ != nullptr) {
+      depth_->inc(static_cast<int64_t>(n));
+      total_->inc(static_cast<int64_t>(n));
+    }
+  }
+
+  /// Updates the metrics after discarding `n` items instead of adding them.
+  /// @pre `mtx_` is locked
+  void count_dropped(size_t n) {
+    if (dropped_ != nullptr)
+      dropped_->inc(static_cast<int64_t>(n));
+  }
+
+  /// Updates the metrics after removing `n` items.
+  /// @pre `mtx_` is locked
+  void count_consumed(size_t n) {
+    if (depth_ != nullptr)
+      depth_->dec(static_cast<int64_t>(n));
+  }
+
   /// Guards access to `xs`.
   mutable std::mutex mtx_;
 
@@ -94,6 +139,19 @@ protected:
 
   /// Stores consumption or production rate.
   std::atomic<size_t> rate_;
+
+  /// Keeps the metrics alive while the queue exists.
+  metric_registry_ptr registry_;
+
+  /// Tracks the number of items in all queues sharing the metrics.
+  metric* depth_ = nullptr;
+
+  /// Counts all items added to the queues sharing the metrics.
+  metric* total_ = nullptr;
+
+  /// Counts all items discarded by destroying a non-empty queue or by
+  /// producing into a full queue.
+  metric* dropped_ = nullptr;
 };
 
 } // namespace detail
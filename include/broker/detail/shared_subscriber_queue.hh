@@ -4,6 +4,7 @@
 #include <caf/intrusive_ptr.hpp>
 #include <caf/make_counted.hpp>
 
+#include "broker/detail/probes.hh"
 #include "broker/detail/shared_queue.hh"
 #include "broker/message.hh"
 
@@ -31,6 +32,18 @@ public:
 
   shared_subscriber_queue() = default;
 
+  /// Returns how many items the producer added to the queue in total.
+  size_t produced() const {
+    guard_type guard{this->mtx_};
+    return produced_;
+  }
+
+  /// Returns how many items the queue discarded because it was full.
+  size_t dropped() const {
+    guard_type guard{this->mtx_};
+    return num_dropped_;
+  }
+
   // Called to pull up to `num` items out of the queue. Returns the number of
   // consumed elements.
   template <class F>
@@ -53,6 +66,8 @@ public:
         fun(std::move(*i));
       this->xs_.erase(b, e);
     }
+    this->count_consumed(n);
+    BROKER_PROBE2(subscriber_dequeue, n, this->xs_.size());
     return n;
   }
 
@@ -69,6 +84,8 @@ public:
     for (auto& x : this->xs_)
       rval.emplace_back(std::move(x));
 
+    this->count_consumed(rval.size());
+    BROKER_PROBE2(subscriber_dequeue, rval.size(), 0);
     this->xs_.clear();
     this->fx_.extinguish_one();
 
@@ -83,7 +100,12 @@ public:
     guard_type guard{this->mtx_};
     if (this->xs_.empty())
       this->fx_.fire();
+    auto old_size = this->xs_.size();
     this->xs_.insert(this->xs_.end(), i, e);
+    produced_ += this->xs_.size() - old_size;
+    this->count_produced(this->xs_.size() - old_size);
+    BROKER_PROBE2(subscriber_enqueue, this->xs_.size() - old_size,
+                  this->xs_.size());
   }
 
   // Inserts `x` into the queue.
@@ -92,7 +114,35 @@ public:
     if (this->xs_.empty())
       this->fx_.fire();
     this->xs_.emplace_back(std::move(x));
+    ++produced_;
+    this->count_produced(1);
+    BROKER_PROBE2(subscriber_enqueue, 1, this->xs_.size());
   }
+
+  // Inserts `x` into the queue unless it holds `max_size` items already.
+  // Returns `false` if the queue discarded `x`.
+  bool try_produce(ValueType x, size_t max_size) {
+    guard_type guard{this->mtx_};
+    if (this->xs_.size() >= max_size) {
+      ++num_dropped_;
+      this->count_dropped(1);
+      return false;
+    }
+    if (this->xs_.empty())
+      this->fx_.fire();
+    this->xs_.emplace_back(std::move(x));
+    ++produced_;
+    this->count_produced(1);
+    BROKER_PROBE2(subscriber_enqueue, 1, this->xs_.size());
+    return true;
+  }
+
+private:
+  /// Counts all items added to the queue.
+  size_t produced_ = 0;
+
+  /// Counts all items that `try_produce` discarded.
+  size_t num_dropped_ = 0;
 };
 
 template <class ValueType = data_message>
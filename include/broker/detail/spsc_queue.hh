@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace broker::detail {
+
+/// A bounded, lock-free queue for exactly one producer thread and exactly one
+/// consumer thread.
+template <class T>
+class spsc_queue {
+public:
+  // -- member types -----------------------------------------------------------
+
+  using value_type = T;
+
+  // -- constructors, destructors, and assignment operators --------------------
+
+  /// @param capacity Minimum number of elements the queue can store. Gets
+  ///                 rounded up to the next power of two.
+  explicit spsc_queue(size_t capacity) {
+    size_t n = 2;
+    while (n < capacity)
+      n <<= 1;
+    mask_ = n - 1;
+    slots_.reset(new T[n]);
+  }
+
+  spsc_queue(const spsc_queue&) = delete;
+
+  spsc_queue& operator=(const spsc_queue&) = delete;
+
+  // -- properties -------------------------------------------------------------
+
+  size_t capacity() const noexcept {
+    return mask_ + 1;
+  }
+
+  /// Checks whether the queue is empty. Only accurate on the consumer thread.
+  bool empty() const noexcept {
+    return head_.load(std::memory_order_relaxed)
+           == tail_.load(std::memory_order_acquire);
+  }
+
+  // -- producer interface -----------------------------------------------------
+
+  /// Tries to append `x` to the queue.
+  /// @returns `false` if the queue is full, `true` otherwise.
+  template <class U>
+  bool try_push(U&& x) {
+    auto tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) > mask_)
+      return false;
+    slots_[tail & mask_] = std::forward<U>(x);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // -- consumer interface -----------------------------------------------------
+
+  /// Tries to remove the oldest element from the queue and store it in `x`.
+  /// @returns `false` if the queue is empty, `true` otherwise.
+  bool try_pop(T& x) {
+    auto head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire))
+      return false;
+    auto& slot = slots_[head & mask_];
+    x = std::move(slot);
+    // Release any resources held by the moved-from element.
+    slot = T{};
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+private:
+  // -- member variables -------------------------------------------------------
+
+  /// Index of the next element to read. Written by the consumer only.
+  alignas(64) std::atomic<size_t> head_{0};
+
+  /// Index of the next free slot. Written by the producer only.
+  alignas(64) std::atomic<size_t> tail_{0};
+
+  alignas(64) size_t mask_;
+
+  std::unique_ptr<T[]> slots_;
+};
+
+} // namespace broker::detail
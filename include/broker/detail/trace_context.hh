@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <caf/meta/type_name.hpp>
+
+#include "broker/data.hh"
+#include "broker/time.hh"
+#include "broker/topic.hh"
+
+namespace broker::detail {
+
+/// Identifies a point on the path of a traced message.
+enum class trace_hop : uint8_t {
+  /// The worker of a publisher takes the message out of the publisher queue
+  /// and streams it to the core.
+  publisher_worker,
+  /// The core of the publisher hands the message to its peers.
+  origin,
+  /// A core receives the message from a peer.
+  peer_ingress,
+  /// A core forwards the message to its peers.
+  forward,
+  /// A core hands the message to local subscribers and stores.
+  delivery,
+  /// The worker of a subscriber puts the message into the subscriber queue.
+  subscriber_sink,
+};
+
+/// @relates trace_hop
+const char* to_string(trace_hop x);
+
+/// Records when a message passed a single hop.
+struct trace_point {
+  trace_hop hop;
+  timestamp time;
+};
+
+/// @relates trace_point
+template <class Inspector>
+typename Inspector::result_type inspect(Inspector& f, trace_point& x) {
+  return f(x.hop, x.time);
+}
+
+/// Travels with a sampled message and collects a timestamp at each hop.
+struct trace_context {
+  /// Identifies the trace, i.e., stays the same on all nodes.
+  uint64_t id = 0;
+
+  /// Lists all hops in the order the message passed them.
+  std::vector<trace_point> points;
+
+  /// Appends a point for `hop` with the current (wall clock) time.
+  void add(trace_hop hop) {
+    points.emplace_back(trace_point{hop, broker::now()});
+  }
+};
+
+/// @relates trace_context
+template <class Inspector>
+typename Inspector::result_type inspect(Inspector& f, trace_context& x) {
+  return f(caf::meta::type_name("trace"), x.id, x.points);
+}
+
+/// Converts a trace for a message on topic `t` to the form that we publish
+/// on `topics::traces`, i.e., `[id, topic, [[hop, time], ...]]`.
+/// @relates trace_context
+data to_data(const trace_context& x, const topic& t);
+
+/// Decides which messages to trace.
+class trace_sampler {
+public:
+  /// Traces one in `rate` messages or none if `rate == 0`.
+  explicit trace_sampler(size_t rate = 0);
+
+  /// Returns a new ID if the next message should carry a trace, otherwise 0.
+  uint64_t next() noexcept {
+    if (rate_ == 0 || ++counter_ < rate_)
+      return 0;
+    counter_ = 0;
+    return ++last_id_;
+  }
+
+private:
+  size_t rate_;
+  size_t counter_ = 0;
+  uint64_t last_id_;
+};
+
+} // namespace broker::detail
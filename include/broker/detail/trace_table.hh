@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <caf/allowed_unsafe_message_type.hpp>
+#include <caf/intrusive_ptr.hpp>
+#include <caf/ref_counted.hpp>
+
+#include "broker/detail/trace_context.hh"
+#include "broker/message.hh"
+#include "broker/optional.hh"
+
+namespace broker::detail {
+
+/// Hands trace contexts from one local actor to another, e.g., from publisher
+/// workers to cores. The streams between these actors only carry plain data
+/// messages, so the table identifies messages by the address of their shared
+/// content, which stays the same while a message travels through the streams
+/// of a single endpoint. Each entry keeps its message alive, i.e., the address
+/// cannot refer to another message while the entry exists.
+class trace_table : public caf::ref_counted {
+public:
+  using clock_type = std::chrono::steady_clock;
+
+  /// Number of entries the table keeps by default.
+  static constexpr size_t default_capacity = 1024;
+
+  /// Drops entries after this long by default.
+  static constexpr clock_type::duration default_max_age
+    = std::chrono::seconds(10);
+
+  explicit trace_table(size_t capacity = default_capacity,
+                       clock_type::duration max_age = default_max_age);
+
+  /// Stores `ctx` for `msg`. Drops the oldest entry if the table is full.
+  void put(const data_message& msg, trace_context ctx);
+
+  /// Returns the context for `msg` and removes it from the table.
+  optional<trace_context> take(const data_message& msg);
+
+  /// Returns a copy of the context for `msg`, keeping the entry for other
+  /// subscribers that receive the same message.
+  optional<trace_context> find(const data_message& msg);
+
+  /// Looks up all messages in `xs` while locking the table only once. Returns
+  /// the positions of messages with an entry along with a copy of the context.
+  std::vector<std::pair<size_t, trace_context>>
+  find_all(const std::vector<data_message>& xs);
+
+  /// Returns whether the table has no entries. Safe to call without locking
+  /// for skipping lookups on the hot path.
+  bool empty() const noexcept {
+    return size_.load() == 0;
+  }
+
+private:
+  struct entry {
+    data_message msg;
+    trace_context ctx;
+    uint64_t seq;
+  };
+
+  /// Remembers when we have added an entry.
+  struct insertion {
+    const void* key;
+    uint64_t seq;
+    clock_type::time_point added;
+  };
+
+  /// Drops entries that are too old or exceed the capacity.
+  /// @pre `mtx_` is locked
+  void shrink(clock_type::time_point now, size_t max_size);
+
+  /// Guards all other member variables except `size_`.
+  std::mutex mtx_;
+
+  /// Maps the address of message contents to their entry.
+  std::unordered_map<const void*, entry> entries_;
+
+  /// Stores all insertions in order. May contain insertions of entries that
+  /// `take` removed already.
+  std::deque<insertion> order_;
+
+  /// Mirrors `entries_.size()`.
+  std::atomic<size_t> size_{0};
+
+  /// Tags each insertion.
+  uint64_t next_seq_ = 0;
+
+  /// Limits the number of entries.
+  size_t capacity_;
+
+  /// Limits how long we keep entries.
+  clock_type::duration max_age_;
+};
+
+/// @relates trace_table
+using trace_table_ptr = caf::intrusive_ptr<trace_table>;
+
+/// @relates trace_table
+trace_table_ptr make_trace_table();
+
+} // namespace broker::detail
+
+CAF_ALLOW_UNSAFE_MESSAGE_TYPE(broker::detail::trace_table_ptr)
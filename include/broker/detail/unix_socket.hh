@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <caf/actor.hpp>
+#include <caf/error.hpp>
+#include <caf/expected.hpp>
+#include <caf/fwd.hpp>
+#include <caf/io/fwd.hpp>
+#include <caf/optional.hpp>
+
+namespace broker::detail {
+
+/// Returns the path in `address` if it uses the `unix://` scheme, e.g.,
+/// `unix:///var/run/broker.sock`.
+caf::optional<std::string> unix_socket_path_of(const std::string& address);
+
+/// Returns a path for a UNIX domain socket of a node that would listen on
+/// `port` when placing sockets into `dir`.
+std::string unix_socket_path(const std::string& dir, uint16_t port);
+
+/// Returns the BASP broker of `sys`, i.e., the broker that manages all
+/// connections to remote CAF nodes.
+caf::actor basp_broker(caf::actor_system& sys);
+
+/// Binds a new UNIX domain socket to `path` and lets the BASP broker of `sys`
+/// accept connections on it for `whom`. Only the current user may connect to
+/// the socket. Replaces a stale socket at `path`, but fails if another process
+/// still listens on `path` or if `path` refers to something else.
+caf::error publish_unix_socket(caf::actor_system& sys, const caf::actor& whom,
+                               const std::string& path);
+
+/// Connects to the UNIX domain socket at `path`. Users pass the result to the
+/// BASP broker via `(atom::connect, scribe, uint16_t{0})`.
+caf::expected<caf::io::scribe_ptr>
+connect_unix_socket(caf::actor_system& sys, const std::string& path);
+
+} // namespace broker::detail
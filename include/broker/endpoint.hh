@@ -22,6 +22,10 @@
 #include "broker/backend.hh"
 #include "broker/backend_options.hh"
 #include "broker/configuration.hh"
+#include "broker/detail/core_shards.hh"
+#include "broker/detail/local_subscriber_table.hh"
+#include "broker/detail/metric_registry.hh"
+#include "broker/detail/trace_table.hh"
 #include "broker/endpoint_info.hh"
 #include "broker/expected.hh"
 #include "broker/frontend.hh"
@@ -58,9 +62,26 @@ public:
 
     using lock_type = std::unique_lock<mutex_type>;
 
-    using pending_msg_type = std::pair<caf::actor, caf::message>;
-
-    using pending_msgs_map_type = std::multimap<timestamp, pending_msg_type>;
+    /// A message that the clock delivers once the simulated time reaches
+    /// `due`. The sequence number `seq` delivers messages with the same `due`
+    /// in the order of their scheduling.
+    struct pending_msg_type {
+      timestamp due;
+      uint64_t seq;
+      caf::actor dest;
+      caf::message msg;
+    };
+
+    /// Orders pending messages for a min-heap, i.e., the message that is due
+    /// first goes to the front.
+    struct pending_msg_order {
+      bool operator()(const pending_msg_type& x,
+                      const pending_msg_type& y) const noexcept {
+        return x.due != y.due ? x.due > y.due : x.seq > y.seq;
+      }
+    };
+
+    using pending_msgs_heap_type = std::vector<pending_msg_type>;
 
     // --- construction and destruction ----------------------------------------
 
@@ -90,11 +111,16 @@ public:
     /// Nanoseconds since start of the epoch.
     std::atomic<timespan> time_since_epoch_;
 
-    /// Guards pending_.
+    /// Guards pending_ and seq_.
     mutex_type mtx_;
 
-    /// Stores pending messages until they time out.
-    pending_msgs_map_type pending_;
+    /// Stores pending messages until they time out as binary heap. Unlike a
+    /// map, the heap does not allocate per message and keeps all entries in a
+    /// single block of memory.
+    pending_msgs_heap_type pending_;
+
+    /// Stores the sequence number for the next pending message.
+    uint64_t seq_ = 0;
 
     /// Stores number of items in pending_.  We track it separately as
     /// a micro-optimization -- checking pending_.size() would require
@@ -136,9 +162,18 @@ public:
   /// @returns The port the endpoint bound to or 0 on failure.
   uint16_t listen(const std::string& address = {}, uint16_t port = 0);
 
+  /// Listens at a UNIX domain socket to accept peers on the same host.
+  /// Connections over UNIX domain sockets never use SSL.
+  /// @param path The file system path of the socket.
+  /// @returns True if the endpoint listens at `path`, false otherwise.
+  /// @note Peers connect by passing `unix://<path>` as address to `peer`.
+  bool listen_unix(const std::string& path);
+
   /// Initiates a peering with a remote endpoint.
-  /// @param address The IP address of the remote endpoint.
-  /// @param port The TCP port of the remote endpoint.
+  /// @param address The IP address of the remote endpoint or `unix://<path>`
+  ///                for connecting to a UNIX domain socket.
+  /// @param port The TCP port of the remote endpoint (ignored for UNIX domain
+  ///             sockets).
   /// @param retry If non-zero, seconds after which to retry if connection
   ///        cannot be established, or breaks.
   /// @returns True if connection was successfulluy set up.
@@ -182,6 +217,11 @@ public:
   /// Retrieves a list of topics that peers have subscribed to on this endpoint.
   std::vector<topic> peer_subscriptions() const;
 
+  /// Retrieves the current value of all metrics of this endpoint, e.g., the
+  /// number of messages sent to each peer or the depth of subscriber queues.
+  /// Subscribing to `topics::metrics` delivers the same table periodically.
+  table metrics() const;
+
   // --- publishing ------------------------------------------------------------
 
   /// Publishes a message.
@@ -210,7 +250,8 @@ public:
 
   /// Starts a background worker from the given set of functions that publishes
   /// a series of messages. The worker will run in the background, but `init`
-  /// is guaranteed to be called before the function returns.
+  /// is guaranteed to be called before the function returns. On a sharded
+  /// endpoint, the first core passes messages on to the owning shards.
   template <class Init, class GetNext, class AtEnd>
   caf::actor publish_all(Init init, GetNext f, AtEnd pred) {
     std::mutex mx;
@@ -245,6 +286,13 @@ public:
   // Forward remote events for given topics even if no local subscriber.
   void forward(std::vector<topic> ts);
 
+  // --- recording -------------------------------------------------------------
+
+  /// Persists all messages recorded so far. Requires a non-empty
+  /// `broker.recording-directory`. In flight recorder mode, writes the most
+  /// recent messages to a new generator file in the recording directory.
+  void dump_recording();
+
   // --- subscribing data ------------------------------------------------------
 
   /// Returns a subscriber connected to this endpoint for the topics `ts`.
@@ -259,11 +307,7 @@ public:
     std::mutex mx;
     std::condition_variable cv;
     auto res = make_actor([=,&mx,&cv](caf::event_based_actor* self) {
-      self->send(self * core(), atom::join_v, std::move(topics));
-      self->become([=](const stream_type& in) {
-        caf::attach_stream_sink(self, in, init, f, cleanup);
-        self->unbecome();
-      });
+      join_shards(self, topics, init, f, cleanup);
       std::unique_lock<std::mutex> guard{mx};
       cv.notify_one();
     });
@@ -278,11 +322,7 @@ public:
   caf::actor subscribe_nosync(std::vector<topic> topics, Init init,
                               HandleMessage f, Cleanup cleanup) {
     return make_actor([=](caf::event_based_actor* self) {
-      self->send(self * core(), atom::join_v, std::move(topics));
-      self->become([=](const stream_type& in) {
-        caf::attach_stream_sink(self, in, init, f, cleanup);
-        self->unbecome();
-      });
+      join_shards(self, topics, init, f, cleanup);
     });
   }
 
@@ -368,25 +408,84 @@ public:
     return core_;
   }
 
+  /// Returns all cores of this endpoint. The first element is always `core()`.
+  const std::vector<caf::actor>& shards() const {
+    return shards_;
+  }
+
+  /// Returns the core that handles messages on topic `t`.
+  const caf::actor& core_for(const topic& t) const {
+    return shards_[detail::shard_of(t, shards_.size())];
+  }
+
+  /// Returns the table for delivering messages directly into subscriber
+  /// queues or `nullptr` if `broker.local-fast-path` is disabled.
+  const detail::local_subscriber_table_ptr& local_subscribers() const {
+    return local_subscribers_;
+  }
+
+  /// Returns the table for handing trace contexts from publisher workers to
+  /// cores or `nullptr` if `broker.trace-sample-rate` is 0.
+  const detail::trace_table_ptr& outbound_traces() const {
+    return outbound_traces_;
+  }
+
+  /// Returns the table for handing trace contexts of messages from peers to
+  /// subscriber workers.
+  const detail::trace_table_ptr& inbound_traces() const {
+    return inbound_traces_;
+  }
+
   const configuration& config() const {
     return config_;
   }
 
+  const detail::metric_registry_ptr& metrics_registry() const {
+    return metrics_;
+  }
+
 protected:
   caf::actor subscriber_;
 
 private:
   caf::actor make_actor(actor_init_fun f);
 
+  /// Subscribes `self` to `topics` on all cores and attaches a single sink to
+  /// the resulting streams.
+  template <class Init, class HandleMessage, class Cleanup>
+  void join_shards(caf::event_based_actor* self,
+                   const std::vector<topic>& topics, Init init,
+                   HandleMessage f, Cleanup cleanup) {
+    auto filters = detail::partition(topics, shards_.size());
+    for (size_t i = 0; i < shards_.size(); ++i)
+      self->send(self * shards_[i], atom::join_v, std::move(filters[i]));
+    auto pending = shards_.size();
+    caf::stream_manager_ptr mgr;
+    self->become([=](const stream_type& in) mutable {
+      if (mgr == nullptr)
+        mgr = caf::attach_stream_sink(self, in, init, f, cleanup).ptr();
+      else
+        mgr->add_unchecked_inbound_path(in);
+      if (--pending == 0)
+        self->unbecome();
+    });
+  }
+
   configuration config_;
   union {
     mutable caf::actor_system system_;
   };
   caf::actor core_;
+  std::vector<caf::actor> shards_;
+  detail::local_subscriber_table_ptr local_subscribers_;
+  detail::trace_table_ptr outbound_traces_;
+  detail::trace_table_ptr inbound_traces_;
+  std::vector<std::string> unix_sockets_;
   bool await_stores_on_shutdown_;
   std::vector<caf::actor> children_;
   bool destroyed_;
   clock* clock_;
+  detail::metric_registry_ptr metrics_;
 };
 
 } // namespace broker
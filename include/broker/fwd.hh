@@ -108,7 +108,12 @@ namespace broker::detail {
 struct retry_state;
 
 class flare_actor;
+class local_subscriber_table;
 class mailbox;
+class trace_table;
+
+using local_subscriber_table_ptr = caf::intrusive_ptr<local_subscriber_table>;
+using trace_table_ptr = caf::intrusive_ptr<trace_table>;
 
 } // namespace broker::detail
 
@@ -198,9 +203,13 @@ CAF_BEGIN_TYPE_ID_BLOCK(broker, caf::first_custom_type_id)
 
   // -- atoms for communciation with the core actor ----------------------------
 
+  BROKER_ADD_ATOM(dump, "dump")
+  BROKER_ADD_ATOM(metrics, "metrics")
   BROKER_ADD_ATOM(no_events, "noEvents")
+  BROKER_ADD_ATOM(shard, "shard")
   BROKER_ADD_ATOM(snapshot, "snapshot")
   BROKER_ADD_ATOM(subscriptions, "subs")
+  BROKER_ADD_ATOM(trace, "trace")
 
   // -- Broker type announcements ----------------------------------------------
 
@@ -210,7 +219,9 @@ CAF_BEGIN_TYPE_ID_BLOCK(broker, caf::first_custom_type_id)
   BROKER_ADD_TYPE_ID((broker::command_message))
   BROKER_ADD_TYPE_ID((broker::data))
   BROKER_ADD_TYPE_ID((broker::data_message))
+  BROKER_ADD_TYPE_ID((broker::detail::local_subscriber_table_ptr))
   BROKER_ADD_TYPE_ID((broker::detail::retry_state))
+  BROKER_ADD_TYPE_ID((broker::detail::trace_table_ptr))
   BROKER_ADD_TYPE_ID((broker::ec))
   BROKER_ADD_TYPE_ID((broker::endpoint_info))
   BROKER_ADD_TYPE_ID((broker::enum_value))
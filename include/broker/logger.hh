@@ -2,20 +2,56 @@
 
 #include <caf/logger.hpp>
 
-#define BROKER_LOG(level, ...) CAF_LOG_IMPL("broker", level, __VA_ARGS__)
-
-#define BROKER_TRACE(...)                                                      \
-  BROKER_LOG(CAF_LOG_LEVEL_TRACE, "ENTRY" << __VA_ARGS__);                     \
-  auto CAF_UNIFYN(broker_log_trace_guard_) = ::caf::detail::make_scope_guard(  \
-    [=] { BROKER_LOG(CAF_LOG_LEVEL_TRACE, "EXIT"); })
-
-#define BROKER_DEBUG(...) BROKER_LOG(CAF_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#include "broker/config.hh"
+
+// Broker logs everything that CAF's log level allows unless users configured a
+// lower maximum via BROKER_LOG_LEVEL. Log statements above the maximum expand
+// to nothing, i.e., the compiler never sees their arguments. Enabled log
+// statements only evaluate their arguments if the logger accepts the level at
+// runtime (see CAF_LOG_IMPL).
+#ifndef BROKER_LOG_LEVEL
+#  ifdef CAF_LOG_LEVEL
+#    define BROKER_LOG_LEVEL CAF_LOG_LEVEL
+#  else
+#    define BROKER_LOG_LEVEL CAF_LOG_LEVEL_QUIET
+#  endif
+#endif
 
-#define BROKER_INFO(...) BROKER_LOG(CAF_LOG_LEVEL_INFO, __VA_ARGS__)
-
-#define BROKER_WARNING(...) BROKER_LOG(CAF_LOG_LEVEL_WARNING, __VA_ARGS__)
+#define BROKER_LOG(level, ...) CAF_LOG_IMPL("broker", level, __VA_ARGS__)
 
-#define BROKER_ERROR(...) BROKER_LOG(CAF_LOG_LEVEL_ERROR, __VA_ARGS__)
+#if BROKER_LOG_LEVEL >= CAF_LOG_LEVEL_TRACE
+#  define BROKER_TRACE(...)                                                    \
+    BROKER_LOG(CAF_LOG_LEVEL_TRACE, "ENTRY" << __VA_ARGS__);                   \
+    auto CAF_UNIFYN(broker_log_trace_guard_)                                   \
+      = ::caf::detail::make_scope_guard(                                       \
+        [=] { BROKER_LOG(CAF_LOG_LEVEL_TRACE, "EXIT"); })
+#else
+#  define BROKER_TRACE(...) CAF_VOID_STMT
+#endif
+
+#if BROKER_LOG_LEVEL >= CAF_LOG_LEVEL_DEBUG
+#  define BROKER_DEBUG(...) BROKER_LOG(CAF_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#  define BROKER_DEBUG(...) CAF_VOID_STMT
+#endif
+
+#if BROKER_LOG_LEVEL >= CAF_LOG_LEVEL_INFO
+#  define BROKER_INFO(...) BROKER_LOG(CAF_LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#  define BROKER_INFO(...) CAF_VOID_STMT
+#endif
+
+#if BROKER_LOG_LEVEL >= CAF_LOG_LEVEL_WARNING
+#  define BROKER_WARNING(...) BROKER_LOG(CAF_LOG_LEVEL_WARNING, __VA_ARGS__)
+#else
+#  define BROKER_WARNING(...) CAF_VOID_STMT
+#endif
+
+#if BROKER_LOG_LEVEL >= CAF_LOG_LEVEL_ERROR
+#  define BROKER_ERROR(...) BROKER_LOG(CAF_LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#  define BROKER_ERROR(...) CAF_VOID_STMT
+#endif
 
 #define BROKER_ARG CAF_ARG
 
@@ -6,7 +6,9 @@
 #include <caf/variant.hpp>
 
 #include "broker/data.hh"
+#include "broker/detail/trace_context.hh"
 #include "broker/internal_command.hh"
+#include "broker/optional.hh"
 #include "broker/topic.hh"
 
 namespace broker {
@@ -35,8 +37,18 @@ struct generic_node_message {
 
   /// Receivers of this message.
   receiver_list receivers;
+
+  /// Collects per-hop timestamps for sampled messages. Only travels to peers
+  /// that agreed on exchanging traces during the handshake.
+  optional<detail::trace_context> trace;
 };
 
+/// Marks node messages that carry a trace context on the wire. Since only
+/// peers that agreed on exchanging traces ever receive such messages, the
+/// wire format for all other messages stays the same. TTLs never get close to
+/// this bit, so we clear it on the wire rather than misreading a message.
+constexpr uint16_t traced_ttl_flag = 0x8000;
+
 /// Value type of `node_message`.
 using node_message_content = caf::variant<data_message, command_message>;
 
@@ -68,7 +80,23 @@ inline bool is_command_message(const node_message& x) {
 template <class Inspector, class PeerId>
 typename Inspector::result_type
 inspect(Inspector& f, generic_node_message<PeerId>& x) {
-  return f(x.content, x.ttl, x.receivers);
+  if constexpr (Inspector::reads_state) {
+    auto ttl = static_cast<uint16_t>(x.ttl & ~traced_ttl_flag);
+    if (!x.trace)
+      return f(x.content, ttl, x.receivers);
+    ttl = static_cast<uint16_t>(ttl | traced_ttl_flag);
+    return f(x.content, ttl, x.receivers, *x.trace);
+  } else {
+    if (auto err = f(x.content, x.ttl, x.receivers))
+      return err;
+    if ((x.ttl & traced_ttl_flag) == 0) {
+      x.trace = caf::none;
+      return caf::none;
+    }
+    x.ttl = static_cast<uint16_t>(x.ttl & ~traced_ttl_flag);
+    x.trace = detail::trace_context{};
+    return f(*x.trace);
+  }
 }
 
 /// Generates a ::data_message.
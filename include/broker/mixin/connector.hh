@@ -1,9 +1,13 @@
 #pragma once
 
+#include <random>
+
 #include <caf/allowed_unsafe_message_type.hpp>
 #include <caf/response_promise.hpp>
+#include <caf/settings.hpp>
 
 #include "broker/atoms.hh"
+#include "broker/defaults.hh"
 #include "broker/detail/lift.hh"
 #include "broker/detail/network_cache.hh"
 #include "broker/detail/retry_state.hh"
@@ -34,8 +38,14 @@ public:
 
   template <class... Ts>
   explicit connector(Ts&&... xs)
-    : super(std::forward<Ts>(xs)...), cache_(super::self()) {
-    // nop
+    : super(std::forward<Ts>(xs)...),
+      cache_(super::self()),
+      rng_(std::random_device{}()) {
+    auto& cfg = super::self()->config();
+    cache_.set_connect_workers(caf::get_or(cfg, "broker.connect-workers",
+                                           defaults::connect_workers));
+    max_retry_interval_ = caf::get_or(cfg, "broker.max-retry-interval",
+                                      defaults::max_retry_interval);
   }
 
   void try_peering(const network_info& addr, caf::response_promise rp,
@@ -50,11 +60,14 @@ public:
       },
       [=](error err) mutable {
         dref().peer_unavailable(addr);
-        if (addr.retry.count() == 0 && ++count < 10) {
+        if (addr.retry.count() == 0) {
           rp.deliver(std::move(err));
         } else {
-          self->delayed_send(self, addr.retry,
-                             detail::retry_state{addr, std::move(rp), count});
+          auto delay = retry_delay(addr.retry, count);
+          BROKER_DEBUG("retry connecting to" << addr << "in" << delay);
+          self->delayed_send(self, delay,
+                             detail::retry_state{addr, std::move(rp),
+                                                 count + 1});
         }
       });
   }
@@ -77,10 +90,11 @@ public:
     if (!dref().shutting_down()) {
       auto x = cache_.find(hdl);
       if (x && x->retry != timeout::seconds(0)) {
+        auto delay = retry_delay(x->retry, 0);
         BROKER_INFO("will try reconnecting to" << *x << "in"
-                                               << to_string(x->retry));
+                                               << to_string(delay));
         auto self = super::self();
-        self->delayed_send(self, x->retry, atom::peer_v, atom::retry_v, *x);
+        self->delayed_send(self, delay, atom::peer_v, atom::retry_v, *x);
       }
     }
     super::peer_disconnected(peer_id, hdl, reason);
@@ -121,8 +135,18 @@ private:
     return static_cast<Subtype&>(*this);
   }
 
+  timespan retry_delay(timespan base, uint32_t count) {
+    return detail::retry_delay(base, count, max_retry_interval_, rng_);
+  }
+
   /// Associates network addresses to remote actor handles and vice versa.
   detail::network_cache cache_;
+
+  /// Adds jitter to retry intervals.
+  std::minstd_rand rng_;
+
+  /// Limits how far retry intervals grow after failed connection attempts.
+  timespan max_retry_interval_;
 };
 
 } // namespace broker::mixin
@@ -78,8 +78,10 @@ public:
     BROKER_ASSERT(ptr != nullptr);
     BROKER_INFO("spawning new master:" << name);
     auto self = super::self();
+    detail::metric_registry_ptr reg{&dref().metrics()};
     auto ms = self->template spawn<spawn_flags>(detail::master_actor, self,
-                                                name, std::move(ptr), clock_);
+                                                name, std::move(ptr), clock_,
+                                                std::move(reg));
     filter_type filter{name / topics::master_suffix};
     if (auto err = dref().add_store(ms, filter))
       return err;
@@ -1,6 +1,11 @@
 #pragma once
 
+#include <caf/behavior.hpp>
+
+#include "broker/atoms.hh"
 #include "broker/detail/core_recorder.hh"
+#include "broker/detail/lift.hh"
+#include "broker/error.hh"
 #include "broker/filter_type.hh"
 
 namespace broker::mixin {
@@ -24,6 +29,14 @@ public:
     // nop
   }
 
+  /// Constructs the mixin with a disabled recorder. Only one core per endpoint
+  /// may write to the recording directory.
+  template <class... Ts>
+  explicit recorder(detail::no_recording_t, Ts&&... xs)
+    : super(std::forward<Ts>(xs)...) {
+    // nop
+  }
+
   template <class T>
   void ship(T& msg) {
     if (rec_)
@@ -49,7 +62,47 @@ public:
     super::peer_connected(remote_id, hdl);
   }
 
+  void peer_disconnected(const peer_id_type& peer_id,
+                         const communication_handle_type& hdl,
+                         const error& reason) {
+    // Capture the traffic leading up to an abnormal disconnect.
+    if (rec_ && reason)
+      rec_.dump_on_failure();
+    super::peer_disconnected(peer_id, hdl, reason);
+  }
+
+  using super::peer_unavailable;
+
+  void peer_unavailable(const peer_id_type& peer_id,
+                        const communication_handle_type& hdl,
+                        const error& reason) {
+    if (rec_)
+      rec_.dump_on_failure();
+    super::peer_unavailable(peer_id, hdl, reason);
+  }
+
+  const detail::core_recorder& recorder() const noexcept {
+    return rec_;
+  }
+
+  void dump_recording() {
+    if (rec_)
+      rec_.dump();
+  }
+
+  template <class... Fs>
+  caf::behavior make_behavior(Fs... fs) {
+    using detail::lift;
+    auto& d = dref();
+    return super::make_behavior(
+      std::move(fs)..., lift<atom::dump>(d, &Subtype::dump_recording));
+  }
+
 private:
+  Subtype& dref() {
+    return *static_cast<Subtype*>(this);
+  }
+
   detail::core_recorder rec_;
 };
 
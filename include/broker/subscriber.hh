@@ -11,6 +11,7 @@
 #include "broker/subscriber_base.hh"
 #include "broker/topic.hh"
 
+#include "broker/detail/local_subscriber_table.hh"
 #include "broker/detail/shared_subscriber_queue.hh"
 
 namespace broker {
@@ -62,6 +63,10 @@ private:
   caf::actor worker_;
   std::vector<topic> filter_;
   std::reference_wrapper<endpoint> ep_;
+
+  /// Points to the table of the endpoint if cores write directly into our
+  /// queue, `nullptr` otherwise.
+  detail::local_subscriber_table_ptr fast_path_;
 };
 
 } // namespace broker
@@ -92,6 +92,8 @@ const topic clone_suffix = reserved / clone;
 const topic errors = reserved / "local/data/errors";
 const topic statuses = reserved / "local/data/statuses";
 const topic store_events = reserved / "local/data/store-events";
+const topic metrics = reserved / "local/metrics";
+const topic traces = reserved / "local/traces";
 
 } // namespace topics
 } // namespace broker
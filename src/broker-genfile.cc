@@ -0,0 +1,404 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <caf/binary_serializer.hpp>
+#include <caf/config_option_adder.hpp>
+#include <caf/deep_to_string.hpp>
+#include <caf/term.hpp>
+
+#include "broker/configuration.hh"
+#include "broker/data.hh"
+#include "broker/detail/generator_file_reader.hh"
+#include "broker/detail/generator_file_writer.hh"
+#include "broker/detail/prefix_matcher.hh"
+#include "broker/error.hh"
+#include "broker/internal_command.hh"
+#include "broker/message.hh"
+#include "broker/topic.hh"
+
+using std::string;
+
+using broker::data;
+using broker::topic;
+
+// -- I/O utility --------------------------------------------------------------
+
+namespace detail {
+
+int print_impl(std::ostream& ostr, const char* x) {
+  ostr << x;
+  return 0;
+}
+
+int print_impl(std::ostream& ostr, const string& x) {
+  ostr << x;
+  return 0;
+}
+
+int print_impl(std::ostream& ostr, const caf::term& x) {
+  ostr << x;
+  return 0;
+}
+
+template <class T>
+int print_impl(std::ostream& ostr, const T& x) {
+  return print_impl(ostr, caf::deep_to_string(x));
+}
+
+template <class... Ts>
+void println(std::ostream& ostr, Ts&&... xs) {
+  std::initializer_list<int>{print_impl(ostr, std::forward<Ts>(xs))...};
+  ostr << caf::term::reset_endl;
+}
+
+} // namespace detail
+
+namespace out {
+
+template <class... Ts>
+void println(Ts&&... xs) {
+  ::detail::println(std::cout, std::forward<Ts>(xs)...);
+}
+
+} // namespace out
+
+namespace err {
+
+template <class... Ts>
+void println(Ts&&... xs) {
+  ::detail::println(std::cerr, caf::term::red, std::forward<Ts>(xs)...);
+}
+
+} // namespace err
+
+namespace {
+
+// -- type aliases -------------------------------------------------------------
+
+using string_list = std::vector<string>;
+
+using reader_ptr = broker::detail::generator_file_reader_ptr;
+
+using value_type = broker::detail::generator_file_reader::value_type;
+
+// -- program options ----------------------------------------------------------
+
+class config : public broker::configuration {
+public:
+  using super = broker::configuration;
+
+  config() : super(skip_init) {
+    opt_group{custom_options_, "global"}
+      .add<string>("mode,m", "'stats', 'slice', or 'merge'")
+      .add<string_list>("input-files,i", "generator files for reading")
+      .add<string>("output-file,o",
+                   "generator file for writing ('slice' and 'merge' mode)")
+      .add<string_list>("topics,t",
+                        "keeps only entries with a matching topic prefix "
+                        "('slice' and 'merge' mode)");
+  }
+
+  using super::init;
+};
+
+// -- statistics ---------------------------------------------------------------
+
+/// Names for all types of `internal_command`, in the order of the variant.
+constexpr const char* command_names[] = {
+  "none",     "put",      "put_unique",    "erase", "add",
+  "subtract", "snapshot", "snapshot_sync", "set",   "clear",
+};
+
+/// Counts values in buckets of exponentially growing size, i.e., the bucket
+/// at index `i` counts all values in the range `[2^(i-1), 2^i)`.
+struct histogram {
+  std::array<size_t, 64> buckets{};
+
+  void add(size_t x) {
+    size_t index = 0;
+    while (x > 0) {
+      ++index;
+      x >>= 1;
+    }
+    ++buckets[index];
+  }
+
+  void print(const char* unit) const {
+    for (size_t i = 0; i < buckets.size(); ++i)
+      if (buckets[i] > 0)
+        out::println("    < ", size_t{1} << i, " ", unit, ": ", buckets[i]);
+  }
+};
+
+struct topic_stats {
+  size_t data_entries = 0;
+
+  size_t command_entries = 0;
+
+  size_t total_bytes = 0;
+
+  size_t max_bytes = 0;
+
+  size_t max_depth = 0;
+};
+
+struct file_stats {
+  std::map<topic, topic_stats> topics;
+
+  /// Counts how often each type of data occurs at any nesting level.
+  std::map<string, size_t> types;
+
+  std::array<size_t, std::size(command_names)> commands{};
+
+  histogram sizes;
+
+  histogram depths;
+
+  /// Adds `x` and all of its nested values to the type histogram and returns
+  /// the nesting depth of `x`.
+  size_t add_shape(const data& x) {
+    ++types[x.get_type_name()];
+    return caf::visit([this](const auto& y) { return nested_depth(y); }, x);
+  }
+
+  template <class T>
+  size_t nested_depth(const T&) {
+    return 1;
+  }
+
+  size_t nested_depth(const broker::vector& xs) {
+    size_t result = 0;
+    for (const auto& x : xs)
+      result = std::max(result, add_shape(x));
+    return result + 1;
+  }
+
+  size_t nested_depth(const broker::set& xs) {
+    size_t result = 0;
+    for (const auto& x : xs)
+      result = std::max(result, add_shape(x));
+    return result + 1;
+  }
+
+  size_t nested_depth(const broker::table& xs) {
+    size_t result = 0;
+    for (const auto& kvp : xs)
+      result = std::max({result, add_shape(kvp.first), add_shape(kvp.second)});
+    return result + 1;
+  }
+
+  void add(const value_type& x) {
+    caf::binary_serializer::container_type buf;
+    caf::binary_serializer sink{nullptr, buf};
+    auto& st = topics[get_topic(x)];
+    size_t depth = 0;
+    if (is_data_message(x)) {
+      auto& val = get_data(caf::get<broker::data_message>(x));
+      static_cast<void>(sink(val));
+      depth = add_shape(val);
+      ++st.data_entries;
+    } else {
+      auto& cmd = get_command(caf::get<broker::command_message>(x));
+      static_cast<void>(sink(cmd));
+      ++commands[cmd.content.index()];
+      ++st.command_entries;
+    }
+    sizes.add(buf.size());
+    depths.add(depth);
+    st.total_bytes += buf.size();
+    st.max_bytes = std::max(st.max_bytes, buf.size());
+    st.max_depth = std::max(st.max_depth, depth);
+  }
+
+  void print() const {
+    out::println("  topics:");
+    for (const auto& [key, st] : topics) {
+      auto n = st.data_entries + st.command_entries;
+      out::println("    ", key.string(), ":");
+      out::println("      data-entries: ", st.data_entries);
+      out::println("      command-entries: ", st.command_entries);
+      auto avg = st.total_bytes / std::max(n, size_t{1});
+      out::println("      avg-bytes: ", avg);
+      out::println("      max-bytes: ", st.max_bytes);
+      out::println("      max-depth: ", st.max_depth);
+    }
+    out::println("  sizes:");
+    sizes.print("bytes");
+    out::println("  nesting-depths:");
+    depths.print("levels");
+    out::println("  data-types:");
+    for (const auto& [name, n] : types)
+      out::println("    ", name, ": ", n);
+    out::println("  command-types:");
+    for (size_t i = 0; i < commands.size(); ++i)
+      if (commands[i] > 0)
+        out::println("    ", command_names[i], ": ", commands[i]);
+  }
+};
+
+int stats_mode(const string_list& file_names) {
+  for (const auto& file_name : file_names) {
+    auto reader = broker::detail::make_generator_file_reader(file_name);
+    if (reader == nullptr) {
+      err::println("unable to open generator file: ", file_name);
+      return EXIT_FAILURE;
+    }
+    file_stats st;
+    value_type x;
+    broker::timestamp t;
+    broker::timestamp first_time;
+    broker::timestamp last_time;
+    while (!reader->at_end()) {
+      if (auto err = reader->read(x, t)) {
+        err::println("error while parsing ", file_name, ": ", err);
+        return EXIT_FAILURE;
+      }
+      if (first_time == broker::timestamp{})
+        first_time = t;
+      last_time = t;
+      st.add(x);
+    }
+    out::println(file_name, ":");
+    out::println("  version: ", static_cast<int>(reader->version()));
+    out::println("  blocks: ", reader->num_blocks());
+    out::println("  entries: ", reader->entries());
+    out::println("  data-entries: ", reader->data_entries());
+    out::println("  command-entries: ", reader->command_entries());
+    if (reader->timestamped())
+      out::println("  duration: ", last_time - first_time);
+    st.print();
+  }
+  return EXIT_SUCCESS;
+}
+
+// -- slicing and merging ------------------------------------------------------
+
+/// Copies all entries with a topic matching `filter` from `inputs` to
+/// `file_name`. Interleaves entries by their timestamps if all inputs have
+/// timestamps, otherwise concatenates the inputs.
+int copy_mode(const string_list& inputs, const string& file_name,
+              const std::vector<topic>& filter) {
+  auto out = broker::detail::make_generator_file_writer(file_name);
+  if (out == nullptr) {
+    err::println("unable to open file for writing: ", file_name);
+    return EXIT_FAILURE;
+  }
+  struct source {
+    string file_name;
+    reader_ptr reader;
+    value_type next;
+    broker::timestamp time;
+    bool has_next = false;
+  };
+  std::vector<source> sources;
+  bool timestamped = true;
+  for (const auto& input : inputs) {
+    auto reader = broker::detail::make_generator_file_reader(input);
+    if (reader == nullptr) {
+      err::println("unable to open generator file: ", input);
+      return EXIT_FAILURE;
+    }
+    timestamped = timestamped && reader->timestamped();
+    sources.emplace_back(source{input, std::move(reader), {}, {}, false});
+  }
+  broker::detail::prefix_matcher matches;
+  auto advance = [&](source& src) -> caf::error {
+    src.has_next = false;
+    while (!src.reader->at_end()) {
+      BROKER_TRY(src.reader->read(src.next, src.time));
+      if (filter.empty() || matches(filter, src.next)) {
+        src.has_next = true;
+        break;
+      }
+    }
+    return caf::none;
+  };
+  for (auto& src : sources) {
+    if (auto err = advance(src)) {
+      err::println("error while parsing ", src.file_name, ": ", err);
+      return EXIT_FAILURE;
+    }
+  }
+  auto earlier = [timestamped](const source& x, const source& y) {
+    if (!y.has_next)
+      return x.has_next;
+    return x.has_next && timestamped && x.time < y.time;
+  };
+  size_t written = 0;
+  for (;;) {
+    auto i = std::min_element(sources.begin(), sources.end(), earlier);
+    if (i == sources.end() || !i->has_next)
+      break;
+    if (auto err = out->write(i->next, i->time)) {
+      err::println("unable to write to ", file_name, ": ", err);
+      return EXIT_FAILURE;
+    }
+    ++written;
+    if (auto err = advance(*i)) {
+      err::println("error while parsing ", i->file_name, ": ", err);
+      return EXIT_FAILURE;
+    }
+  }
+  if (auto err = out->close()) {
+    err::println("unable to close ", file_name, ": ", err);
+    return EXIT_FAILURE;
+  }
+  out::println("wrote ", written, " entries to ", file_name);
+  return EXIT_SUCCESS;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  broker::configuration::init_global_state();
+  // Parse CLI parameters using our config.
+  config cfg;
+  try {
+    cfg.init(argc, argv);
+  } catch (std::exception& ex) {
+    err::println(ex.what());
+    return EXIT_FAILURE;
+  }
+  if (cfg.cli_helptext_printed)
+    return EXIT_SUCCESS;
+  auto mode = caf::get_or(cfg, "mode", string{});
+  auto inputs = caf::get_or(cfg, "input-files", string_list{});
+  if (inputs.empty()) {
+    err::println("no input files specified");
+    return EXIT_FAILURE;
+  }
+  if (mode == "stats")
+    return stats_mode(inputs);
+  if (mode != "slice" && mode != "merge") {
+    err::println("invalid mode: ", mode);
+    return EXIT_FAILURE;
+  }
+  auto output = caf::get_or(cfg, "output-file", string{});
+  if (output.empty()) {
+    err::println("no output file specified");
+    return EXIT_FAILURE;
+  }
+  std::vector<topic> filter;
+  for (auto& str : caf::get_or(cfg, "topics", string_list{}))
+    filter.emplace_back(std::move(str));
+  if (mode == "slice") {
+    if (inputs.size() != 1) {
+      err::println("'slice' mode requires exactly one input file");
+      return EXIT_FAILURE;
+    }
+    if (filter.empty()) {
+      err::println("'slice' mode requires at least one topic");
+      return EXIT_FAILURE;
+    }
+  }
+  return copy_mode(inputs, output, filter);
+}
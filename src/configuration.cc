@@ -117,7 +117,45 @@ configuration::configuration(skip_init_t) {
     .add<std::string>("recording-directory",
                       "path for storing recorded meta information")
     .add<size_t>("output-generator-file-cap",
-                 "maximum number of entries when recording published messages");
+                 "maximum number of entries when recording published messages")
+    .add<size_t>("recording-queue-size",
+                 "maximum number of messages waiting for the recording thread")
+    .add<size_t>("flight-recorder-entries",
+                 "records only the last N published messages (0 = off)")
+    .add<timespan>("flight-recorder-duration",
+                   "records only recently published messages (0 = off)")
+    .add<size_t>("flight-recorder-segments",
+                 "number of rotating files for the flight recorder")
+    .add<size_t>("flight-recorder-dumps",
+                 "keeps only the last N flight recorder dumps (0 = all)")
+    .add<timespan>("flight-recorder-dump-interval",
+                   "minimum time between dumps after peering failures")
+    .add<timespan>("metrics-interval",
+                   "publishing interval for the local metrics topic (0 = off)")
+    .add<uint16_t>("metrics-port",
+                   "serves metrics in the Prometheus format via HTTP (0 = off)")
+    .add<std::string>("metrics-address",
+                      "bind address for the metrics port (default: 127.0.0.1)")
+    .add<size_t>("trace-sample-rate",
+                 "traces one in N messages to peers (0 = off)")
+    .add<size_t>("core-shards",
+                 "number of core actors that split the topic space")
+    .add<bool>("local-fast-path",
+               "lets cores write directly into local subscriber queues")
+    .add<size_t>("peer-spool-size",
+                 "messages to keep per disconnected peer (0 = off)")
+    .add<timespan>("peer-spool-timeout",
+                   "how long to keep messages for a disconnected peer")
+    .add<size_t>("peer-spool-disk-size",
+                 "messages per disconnected peer to keep on disk (0 = off)")
+    .add<std::string>("peer-spool-directory",
+                      "directory for spooled messages that exceed memory")
+    .add<std::string>("peer-stream-goal",
+                      "batching for peers: throughput, latency or adaptive")
+    .add<size_t>("connect-workers",
+                 "threads for establishing connections (0 = middleman)")
+    .add<timespan>("max-retry-interval",
+                   "upper bound for the backoff between peering attempts");
   // Override CAF defaults.
 #if CAF_VERSION < 1800
   using caf::atom;
@@ -217,6 +255,45 @@ caf::settings configuration::dump_content() const {
     put_missing(grp, "recording-directory", *path);
   if (auto cap = get_if<size_t>(&content, "broker.output-generator-file-cap"))
     put_missing(grp, "output-generator-file-cap", *cap);
+  if (auto n = get_if<size_t>(&content, "broker.recording-queue-size"))
+    put_missing(grp, "recording-queue-size", *n);
+  if (auto n = get_if<size_t>(&content, "broker.flight-recorder-entries"))
+    put_missing(grp, "flight-recorder-entries", *n);
+  if (auto t = get_if<timespan>(&content, "broker.flight-recorder-duration"))
+    put_missing(grp, "flight-recorder-duration", *t);
+  if (auto n = get_if<size_t>(&content, "broker.flight-recorder-segments"))
+    put_missing(grp, "flight-recorder-segments", *n);
+  if (auto n = get_if<size_t>(&content, "broker.flight-recorder-dumps"))
+    put_missing(grp, "flight-recorder-dumps", *n);
+  if (auto t = get_if<timespan>(&content,
+                                "broker.flight-recorder-dump-interval"))
+    put_missing(grp, "flight-recorder-dump-interval", *t);
+  if (auto t = get_if<timespan>(&content, "broker.metrics-interval"))
+    put_missing(grp, "metrics-interval", *t);
+  if (auto port = get_if<uint16_t>(&content, "broker.metrics-port"))
+    put_missing(grp, "metrics-port", *port);
+  if (auto addr = get_if<std::string>(&content, "broker.metrics-address"))
+    put_missing(grp, "metrics-address", *addr);
+  if (auto n = get_if<size_t>(&content, "broker.trace-sample-rate"))
+    put_missing(grp, "trace-sample-rate", *n);
+  if (auto n = get_if<size_t>(&content, "broker.core-shards"))
+    put_missing(grp, "core-shards", *n);
+  if (auto flag = get_if<bool>(&content, "broker.local-fast-path"))
+    put_missing(grp, "local-fast-path", *flag);
+  if (auto n = get_if<size_t>(&content, "broker.peer-spool-size"))
+    put_missing(grp, "peer-spool-size", *n);
+  if (auto t = get_if<timespan>(&content, "broker.peer-spool-timeout"))
+    put_missing(grp, "peer-spool-timeout", *t);
+  if (auto n = get_if<size_t>(&content, "broker.peer-spool-disk-size"))
+    put_missing(grp, "peer-spool-disk-size", *n);
+  if (auto dir = get_if<std::string>(&content, "broker.peer-spool-directory"))
+    put_missing(grp, "peer-spool-directory", *dir);
+  if (auto goal = get_if<std::string>(&content, "broker.peer-stream-goal"))
+    put_missing(grp, "peer-stream-goal", *goal);
+  if (auto n = get_if<size_t>(&content, "broker.connect-workers"))
+    put_missing(grp, "connect-workers", *n);
+  if (auto t = get_if<timespan>(&content, "broker.max-retry-interval"))
+    put_missing(grp, "max-retry-interval", *t);
   return result;
 }
 
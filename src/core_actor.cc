@@ -1,5 +1,7 @@
 #include "broker/core_actor.hh"
 
+#include <algorithm>
+
 #include <caf/actor.hpp>
 #include <caf/actor_cast.hpp>
 #include <caf/allowed_unsafe_message_type.hpp>
@@ -27,6 +29,7 @@
 #include "broker/convert.hh"
 #include "broker/defaults.hh"
 #include "broker/detail/assert.hh"
+#include "broker/detail/core_shards.hh"
 #include "broker/detail/filesystem.hh"
 #include "broker/detail/make_backend.hh"
 #include "broker/endpoint.hh"
@@ -42,11 +45,34 @@ namespace broker {
 
 core_manager::core_manager(caf::event_based_actor* ptr,
                            const filter_type& initial_filter,
-                           broker_options opts, endpoint::clock* ep_clock)
+                           broker_options opts, endpoint::clock* ep_clock,
+                           detail::metric_registry_ptr metrics)
   : super(ep_clock, ptr, initial_filter),
     options_(opts),
-    filter_(initial_filter) {
+    filter_(initial_filter),
+    metrics_(std::move(metrics)) {
   cache().set_use_ssl(!options_.disable_ssl);
+  if (metrics_ == nullptr)
+    metrics_ = detail::make_metric_registry();
+  metrics_interval_ = get_or(ptr->config(), "broker.metrics-interval",
+                             defaults::metrics_interval);
+}
+
+core_manager::core_manager(caf::event_based_actor* ptr,
+                           const filter_type& initial_filter,
+                           broker_options opts, endpoint::clock* ep_clock,
+                           detail::metric_registry_ptr metrics, size_t shard)
+  : super(detail::no_recording, ep_clock, ptr, initial_filter),
+    options_(opts),
+    filter_(initial_filter),
+    metrics_(std::move(metrics)),
+    shard_(shard) {
+  cache().set_use_ssl(!options_.disable_ssl);
+  if (metrics_ == nullptr)
+    metrics_ = detail::make_metric_registry();
+  // Only the first shard publishes metrics.
+  metrics_interval_ = timespan{0};
+  disable_notifications();
 }
 
 void core_manager::update_filter_on_peers() {
@@ -58,10 +84,18 @@ void core_manager::update_filter_on_peers() {
 
 void core_manager::subscribe(filter_type xs) {
   BROKER_TRACE(BROKER_ARG(xs));
-  // Status and error topics are internal topics.
+  // Only explicit subscriptions enable the metrics topic, i.e., subscribing
+  // to "<$>" does not.
+  auto wants_metrics = [](const topic& x) {
+    return x.prefix_of(topics::metrics) && !x.prefix_of(topics::reserved);
+  };
+  if (std::any_of(xs.begin(), xs.end(), wants_metrics))
+    start_metrics_timer();
+  // Status, error, metrics, and trace topics are internal topics.
   auto internal_only = [](const topic& x) {
     return x == topics::errors || x == topics::statuses
-           || x == topics::store_events;
+           || x == topics::store_events || x == topics::metrics
+           || x == topics::traces;
   };
   xs.erase(std::remove_if(xs.begin(), xs.end(), internal_only), xs.end());
   if (xs.empty())
@@ -112,6 +146,164 @@ void core_manager::peer_connected(const peer_id_type& peer_id,
   }
 }
 
+void core_manager::peer_disconnected(const peer_id_type& peer_id,
+                                     const communication_handle_type& hdl,
+                                     const error& reason) {
+  disconnect_shards(hdl);
+  super::peer_disconnected(peer_id, hdl, reason);
+}
+
+void core_manager::peer_removed(const peer_id_type& peer_id,
+                                const communication_handle_type& hdl) {
+  disconnect_shards(hdl);
+  super::peer_removed(peer_id, hdl);
+}
+
+void core_manager::publish(data_message x) {
+  if (!forward_to_shard(x))
+    super::publish(std::move(x));
+}
+
+void core_manager::publish(node_message_content x) {
+  if (auto dm = caf::get_if<data_message>(&x); dm && forward_to_shard(*dm))
+    return;
+  super::publish(std::move(x));
+}
+
+bool core_manager::forward_to_shard(data_message& x) {
+  if (shards_.empty())
+    return false;
+  auto index = detail::shard_of(get_topic(x), shards_.size());
+  if (index == shard_)
+    return false;
+  BROKER_DEBUG("pass message to shard" << index << ":" << x);
+  self()->send(shards_[index], atom::publish_v, std::move(x));
+  return true;
+}
+
+bool core_manager::is_shard(const caf::strong_actor_ptr& ptr) const {
+  if (ptr == nullptr || shards_.empty())
+    return false;
+  auto hdl = caf::actor_cast<caf::actor>(ptr);
+  return std::find(shards_.begin(), shards_.end(), hdl) != shards_.end();
+}
+
+std::vector<caf::actor> core_manager::shard_handles() {
+  if (shards_.empty())
+    return {caf::actor{self()}};
+  return shards_;
+}
+
+void core_manager::connect_shards(const caf::actor& hdl) {
+  // Non-sharded cores run the exchange as well, because the peer may run
+  // multiple shards.
+  if (shard_ != 0)
+    return;
+  BROKER_DEBUG("peer" << shards_.size() << "shards with" << hdl);
+  self()
+    ->request(hdl, caf::infinite, atom::peer_v, atom::shard_v, shard_handles())
+    .then(
+      [=](std::vector<caf::actor>& remote_shards) {
+        if (remote_shards.size() != std::max(shards_.size(), size_t{1})) {
+          reject_shards(hdl);
+          return;
+        }
+        if (shards_.empty())
+          return;
+        for (size_t i = 1; i < shards_.size(); ++i)
+          self()->send(shards_[i], atom::peer_v, remote_shards[i]);
+        remote_shards_[hdl] = std::move(remote_shards);
+      },
+      [=](const caf::error& err) {
+        if (err == ec::peer_incompatible)
+          reject_shards(hdl);
+        else
+          BROKER_ERROR("unable to peer shards with" << hdl << ":" << err);
+      });
+}
+
+void core_manager::reject_shards(const caf::actor& hdl) {
+  BROKER_ERROR("drop peer" << hdl << "with a different number of shards");
+  // A graceful removal neither spools messages nor schedules reconnects, since
+  // retrying cannot resolve the mismatch.
+  remove_peer(hdl,
+              make_error(ec::peer_incompatible,
+                         "peers must use the same number of core shards"),
+              false, true);
+}
+
+void core_manager::disconnect_shards(const caf::actor& hdl) {
+  auto i = remote_shards_.find(hdl);
+  if (i == remote_shards_.end())
+    return;
+  auto& remote_shards = i->second;
+  for (size_t index = 1; index < shards_.size(); ++index)
+    self()->send(shards_[index], atom::unpeer_v, remote_shards[index]);
+  remote_shards_.erase(i);
+}
+
+detail::metric_labels
+core_manager::peer_metric_labels(const caf::node_id& peer) const {
+  detail::metric_labels result{{"peer", to_string(peer)}};
+  if (shards_.size() > 1)
+    result.emplace("shard", std::to_string(shard_));
+  return result;
+}
+
+void core_manager::sample_metrics() {
+  auto& reg = *metrics_;
+  for (auto& [slot, hdl] : ostream_to_peer_) {
+    auto labels = peer_metric_labels(hdl.node());
+    auto buffered = static_cast<int64_t>(peer_manager().buffered(slot));
+    reg.gauge("broker_peer_buffered_messages", labels).set(buffered);
+    if (auto path = out().path(slot)) {
+      auto credit = static_cast<int64_t>(path->open_credit);
+      reg.gauge("broker_peer_open_credit", labels).set(credit);
+    }
+  }
+  reg.gauge("broker_core_peers")
+    .set(static_cast<int64_t>(ostream_to_peer_.size()));
+  reg.gauge("broker_core_subscribers")
+    .set(static_cast<int64_t>(worker_manager().num_paths()));
+  reg.gauge("broker_core_stores")
+    .set(static_cast<int64_t>(store_manager().num_paths()));
+  auto& rec = recorder();
+  reg.counter("broker_recorder_messages_total")
+    .set(static_cast<int64_t>(rec.recorded()));
+  reg.counter("broker_recorder_dropped_messages_total")
+    .set(static_cast<int64_t>(rec.dropped()));
+}
+
+bool core_manager::has_metrics_subscriber() {
+  for (auto& kvp : worker_manager().states()) {
+    auto& filter = kvp.second.filter;
+    auto matches = [](const topic& x) { return x.prefix_of(topics::metrics); };
+    if (std::any_of(filter.begin(), filter.end(), matches))
+      return true;
+  }
+  return false;
+}
+
+void core_manager::start_metrics_timer() {
+  if (metrics_timer_active_ || metrics_interval_.count() <= 0)
+    return;
+  BROKER_DEBUG("start publishing metrics every" << metrics_interval_);
+  metrics_timer_active_ = true;
+  self()->delayed_send(self(), metrics_interval_, atom::tick_v,
+                       atom::metrics_v);
+}
+
+void core_manager::publish_metrics() {
+  metrics_timer_active_ = false;
+  if (shutting_down_ || !has_metrics_subscriber()) {
+    BROKER_DEBUG("stop publishing metrics: no subscriber left");
+    return;
+  }
+  sample_metrics();
+  local_push(make_data_message(topics::metrics, metrics_->snapshot()));
+  start_metrics_timer();
+}
+
 caf::behavior core_manager::make_behavior(){
   return super::make_behavior(
     // --- filter manipulation -------------------------------------------------
@@ -169,6 +361,8 @@ caf::behavior core_manager::make_behavior(){
       if (i != pending_connections().end()) {
         i->second.rp.deliver(peer_hdl);
         pending_connections().erase(i);
+        // As initiator, we also connect the remaining shards.
+        connect_shards(peer_hdl);
       }
     },
     // Step #3: - A establishes a stream to B
@@ -188,6 +382,46 @@ caf::behavior core_manager::make_behavior(){
       peer_connected(peer_hdl.node(), peer_hdl);
       ack_peering(in, peer_hdl);
     },
+    // --- peering between the shards of two sharded cores ---------------------
+    [=](atom::peer, atom::shard,
+        std::vector<caf::actor>& remote_shards)
+      -> caf::result<std::vector<caf::actor>> {
+      auto num_shards = std::max(shards_.size(), size_t{1});
+      if (remote_shards.size() != num_shards) {
+        BROKER_ERROR("cannot peer" << remote_shards.size() << "shards with"
+                                   << num_shards << "local shards");
+        return make_error(ec::peer_incompatible,
+                          "peers must use the same number of core shards");
+      }
+      auto hdl = caf::actor_cast<caf::actor>(self()->current_sender());
+      if (hdl != nullptr && !shards_.empty())
+        remote_shards_[hdl] = std::move(remote_shards);
+      return shard_handles();
+    },
+    [=](atom::shard, std::vector<caf::actor>& all_shards) {
+      BROKER_ASSERT(shard_ < all_shards.size());
+      shards_ = std::move(all_shards);
+    },
+    // --- spooling for disconnected peers -------------------------------------
+    [=](atom::peer, atom::clear) {
+      expire_spools();
+    },
+    // --- fast path into the queues of local subscribers ----------------------
+    [=](atom::local, detail::local_subscriber_table_ptr& tbl) {
+      BROKER_TRACE("");
+      local_subscribers(std::move(tbl));
+    },
+    // --- tracing -------------------------------------------------------------
+    [=](atom::trace, detail::trace_table_ptr& outbound,
+        detail::trace_table_ptr& inbound) {
+      BROKER_TRACE("");
+      traces(std::move(outbound), std::move(inbound));
+    },
+    [=](atom::peer, atom::trace) {
+      // Peers send this request during the handshake. Replying at all tells
+      // them that we read trace contexts on node messages.
+      return atom::ok_v;
+    },
     // --- asynchronous communication to peers ---------------------------------
     [=](atom::update, filter_type f) {
       BROKER_TRACE(BROKER_ARG(f));
@@ -230,7 +464,11 @@ caf::behavior core_manager::make_behavior(){
     },
     [=](atom::publish, data_message& x) {
       BROKER_TRACE(BROKER_ARG(x));
-      publish(std::move(x));
+      // Other shards only pass on messages from publisher workers and peers.
+      if (is_shard(self()->current_sender()))
+        publish_sampled_upstream(std::move(x));
+      else
+        publish(std::move(x));
     },
     [=](atom::publish, command_message& x) {
       BROKER_TRACE(BROKER_ARG(x));
@@ -291,6 +529,11 @@ caf::behavior core_manager::make_behavior(){
           add(hdl, peer_status::connecting);
       return result;
     },
+    [=](atom::get, atom::metrics) {
+      sample_metrics();
+      return metrics_->snapshot();
+    },
+    [=](atom::tick, atom::metrics) { publish_metrics(); },
     [=](atom::get, atom::peer, atom::subscriptions) {
       std::vector<topic> result;
       // Collect filters for all peers.
@@ -351,10 +594,9 @@ caf::behavior core_manager::make_behavior(){
     });
 }
 
-caf::behavior core_actor(core_actor_type* self, filter_type filter,
-                         broker_options options, endpoint::clock* clock) {
-  auto& st = self->state;
-  st.mgr = caf::make_counted<core_manager>(self, filter, options, clock);
+namespace {
+
+caf::behavior make_core_behavior(core_actor_type* self) {
   // We monitor remote inbound peerings and local outbound peerings.
   self->set_down_handler([self](const caf::down_msg& down) {
     if (!down.source) {
@@ -376,7 +618,27 @@ caf::behavior core_actor(core_actor_type* self, filter_type filter,
       mgr.pending_connections().erase(i);
     }
   });
-  return st.mgr->make_behavior();
+  return self->state.mgr->make_behavior();
+}
+
+} // namespace
+
+caf::behavior core_actor(core_actor_type* self, filter_type filter,
+                         broker_options options, endpoint::clock* clock,
+                         detail::metric_registry_ptr metrics) {
+  self->state.mgr = caf::make_counted<core_manager>(self, filter, options,
+                                                    clock, std::move(metrics));
+  return make_core_behavior(self);
+}
+
+caf::behavior core_shard_actor(core_actor_type* self, filter_type filter,
+                               broker_options options, endpoint::clock* clock,
+                               detail::metric_registry_ptr metrics,
+                               size_t shard) {
+  self->state.mgr = caf::make_counted<core_manager>(self, filter, options,
+                                                    clock, std::move(metrics),
+                                                    shard);
+  return make_core_behavior(self);
 }
 
 } // namespace broker
@@ -1,5 +1,6 @@
 #include "broker/defaults.hh"
 
+#include <chrono>
 #include <limits>
 
 namespace broker {
@@ -9,5 +10,43 @@ const caf::string_view recording_directory = "";
 
 const size_t output_generator_file_cap = std::numeric_limits<size_t>::max();
 
+const size_t recording_queue_size = 8192;
+
+const size_t flight_recorder_entries = 0;
+
+const timespan flight_recorder_duration = timespan{0};
+
+const size_t flight_recorder_segments = 4;
+
+const size_t flight_recorder_dumps = 10;
+
+const timespan flight_recorder_dump_interval = std::chrono::seconds(60);
+
+const timespan metrics_interval = std::chrono::seconds(1);
+
+const uint16_t metrics_port = 0;
+
+const caf::string_view metrics_address = "127.0.0.1";
+
+const size_t trace_sample_rate = 0;
+
+const size_t core_shards = 1;
+
+const bool local_fast_path = false;
+
+const size_t peer_spool_size = 0;
+
+const timespan peer_spool_timeout = std::chrono::seconds(60);
+
+const size_t peer_spool_disk_size = 0;
+
+const caf::string_view peer_spool_directory = "";
+
+const caf::string_view peer_stream_goal = "throughput";
+
+const size_t connect_workers = 4;
+
+const timespan max_retry_interval = std::chrono::seconds(30);
+
 } // namespace defaults
 } // namespace broker
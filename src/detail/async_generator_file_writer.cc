@@ -0,0 +1,137 @@
+#include "broker/detail/async_generator_file_writer.hh"
+
+#include <chrono>
+
+#include "broker/detail/filesystem.hh"
+#include "broker/logger.hh"
+#include "broker/message.hh"
+
+namespace broker::detail {
+
+async_generator_file_writer::async_generator_file_writer(
+  generator_file_writer_ptr writer, size_t queue_size)
+  : writer_(std::move(writer)), queue_(queue_size) {
+  start();
+}
+
+async_generator_file_writer::async_generator_file_writer(
+  flight_recorder_ptr recorder, std::string dump_prefix, size_t queue_size,
+  size_t max_dumps)
+  : recorder_(std::move(recorder)),
+    dump_prefix_(std::move(dump_prefix)),
+    max_dumps_(max_dumps),
+    queue_(queue_size) {
+  start();
+}
+
+async_generator_file_writer::~async_generator_file_writer() {
+  {
+    std::unique_lock<std::mutex> guard{mtx_};
+    done_ = true;
+  }
+  cv_.notify_one();
+  thread_.join();
+  if (auto n = dropped())
+    BROKER_WARNING("dropped" << n << "messages while recording");
+}
+
+bool async_generator_file_writer::push(value_type x, timestamp t) {
+  if (!queue_.try_push(entry{std::move(x), t})) {
+    ++dropped_;
+    return false;
+  }
+  wakeup();
+  return true;
+}
+
+void async_generator_file_writer::dump() {
+  dump_requested_ = true;
+  wakeup();
+}
+
+void async_generator_file_writer::start() {
+  thread_ = std::thread{[this] { run(); }};
+}
+
+void async_generator_file_writer::wakeup() {
+  // Pairs with the store to `sleeping_` in run(): either we see the flag or
+  // the writer thread sees the new element before going to sleep.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (sleeping_.load()) {
+    std::unique_lock<std::mutex> guard{mtx_};
+    cv_.notify_one();
+  }
+}
+
+caf::error async_generator_file_writer::do_write(const entry& x) {
+  if (writer_ != nullptr)
+    return writer_->write(x.msg, x.time);
+  return recorder_->write(x.msg, x.time);
+}
+
+void async_generator_file_writer::do_dump() {
+  if (writer_ != nullptr) {
+    if (auto err = writer_->flush())
+      BROKER_ERROR("unable to flush generator file:" << err);
+    return;
+  }
+  if (!recorder_->has_new_entries())
+    return;
+  auto file_name = dump_prefix_ + std::to_string(num_dumps_++) + ".dat";
+  if (auto err = recorder_->dump(file_name)) {
+    BROKER_ERROR("unable to dump flight recorder:" << err);
+    return;
+  }
+  BROKER_INFO("dumped flight recorder to" << file_name);
+  dump_files_.emplace_back(std::move(file_name));
+  if (max_dumps_ > 0) {
+    while (dump_files_.size() > max_dumps_) {
+      BROKER_DEBUG("remove old flight recorder dump" << dump_files_.front());
+      remove(dump_files_.front());
+      dump_files_.pop_front();
+    }
+  }
+}
+
+void async_generator_file_writer::run() {
+  entry x;
+  auto write_all = [&] {
+    size_t n = 0;
+    while (queue_.try_pop(x)) {
+      ++n;
+      if (failed_)
+        continue;
+      if (auto err = do_write(x)) {
+        BROKER_ERROR("unable to write to generator file:" << err);
+        failed_ = true;
+      }
+    }
+    return n;
+  };
+  for (;;) {
+    if (write_all() > 0)
+      continue;
+    if (dump_requested_.exchange(false) && !failed_)
+      do_dump();
+    std::unique_lock<std::mutex> guard{mtx_};
+    if (done_)
+      break;
+    sleeping_ = true;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    cv_.wait_for(guard, std::chrono::milliseconds(100), [this] {
+      return done_ || dump_requested_ || !queue_.empty();
+    });
+    sleeping_ = false;
+  }
+  // The producer may not push after setting done_, but may have pushed
+  // right before.
+  write_all();
+  if (writer_ != nullptr) {
+    if (auto err = writer_->close())
+      BROKER_ERROR("unable to close generator file:" << err);
+  } else if (dump_requested_ && !failed_) {
+    do_dump();
+  }
+}
+
+} // namespace broker::detail
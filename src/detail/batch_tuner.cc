@@ -0,0 +1,89 @@
+#include "broker/detail/batch_tuner.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+
+namespace broker::detail {
+
+namespace {
+
+constexpr const char* goal_strings[] = {
+  "throughput",
+  "latency",
+  "adaptive",
+};
+
+// Uses the same weight for new samples as TCP for its smoothed RTT.
+template <class T>
+T smooth(T old_value, T sample) {
+  return old_value + (sample - old_value) / 8;
+}
+
+} // namespace
+
+const char* to_string(stream_goal x) noexcept {
+  return goal_strings[static_cast<uint8_t>(x)];
+}
+
+bool convert(const std::string& src, stream_goal& dst) noexcept {
+  auto begin = std::begin(goal_strings);
+  auto end = std::end(goal_strings);
+  auto i = std::find(begin, end, src);
+  if (i != end) {
+    dst = static_cast<stream_goal>(std::distance(begin, i));
+    return true;
+  }
+  return false;
+}
+
+void batch_tuner::sent(int64_t next_id, timestamp t) {
+  if (next_id <= next_id_)
+    return;
+  next_id_ = next_id;
+  if (in_flight_.size() == max_in_flight)
+    in_flight_.pop_front();
+  in_flight_.emplace_back(next_id - 1, t);
+}
+
+void batch_tuner::acked(int64_t id, int32_t credit, timestamp t) {
+  // Acks are cumulative, i.e., the youngest batch up to `id` gives the most
+  // accurate sample.
+  auto sent_at = timestamp{};
+  while (!in_flight_.empty() && in_flight_.front().first <= id) {
+    sent_at = in_flight_.front().second;
+    in_flight_.pop_front();
+  }
+  if (sent_at != timestamp{} && t > sent_at) {
+    auto sample = t - sent_at;
+    rtt_ = rtt_.count() == 0 ? sample : smooth(rtt_, sample);
+  }
+  if (last_ack_ != timestamp{} && t > last_ack_ && credit > 0) {
+    using fractional_seconds = std::chrono::duration<double>;
+    auto dt = std::chrono::duration_cast<fractional_seconds>(t - last_ack_);
+    auto sample = credit / dt.count();
+    rate_ = rate_ == 0 ? sample : smooth(rate_, sample);
+  }
+  last_ack_ = t;
+}
+
+size_t batch_tuner::target(size_t desired_batch_size) const noexcept {
+  auto upper_bound = std::max(desired_batch_size, size_t{1});
+  switch (goal_) {
+    case stream_goal::latency:
+      return 1;
+    case stream_goal::adaptive: {
+      // Without samples, we pick low latency until the first acks arrive.
+      if (rtt_.count() == 0 || rate_ == 0)
+        return 1;
+      using fractional_seconds = std::chrono::duration<double>;
+      auto half_rtt = std::chrono::duration_cast<fractional_seconds>(rtt_) / 2;
+      auto n = static_cast<size_t>(rate_ * half_rtt.count());
+      return std::clamp(n, size_t{1}, upper_bound);
+    }
+    default:
+      return upper_bound;
+  }
+}
+
+} // namespace broker::detail
@@ -0,0 +1,85 @@
+#include "broker/detail/block_codec.hh"
+
+#include <cstring>
+
+#include <caf/error.hpp>
+#include <caf/none.hpp>
+#include <caf/sec.hpp>
+
+#include "broker/config.hh"
+#include "broker/error.hh"
+
+#ifdef BROKER_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace broker::detail {
+
+bool has_block_codec(block_compression codec) noexcept {
+  switch (codec) {
+    case block_compression::none:
+      return true;
+    case block_compression::zlib:
+#ifdef BROKER_HAVE_ZLIB
+      return true;
+#else
+      return false;
+#endif
+  }
+  return false;
+}
+
+caf::error compress_block(block_compression codec, const void* data,
+                          size_t size, block_buffer& out) {
+  switch (codec) {
+    case block_compression::none: {
+      auto first = reinterpret_cast<const block_buffer::value_type*>(data);
+      out.assign(first, first + size);
+      return caf::none;
+    }
+#ifdef BROKER_HAVE_ZLIB
+    case block_compression::zlib: {
+      auto bound = compressBound(static_cast<uLong>(size));
+      out.resize(bound);
+      auto res = compress2(reinterpret_cast<Bytef*>(out.data()), &bound,
+                           reinterpret_cast<const Bytef*>(data),
+                           static_cast<uLong>(size), Z_DEFAULT_COMPRESSION);
+      if (res != Z_OK)
+        return make_error(ec::invalid_data, "zlib compression failed");
+      out.resize(bound);
+      return caf::none;
+    }
+#endif
+    default:
+      return caf::make_error(caf::sec::unsupported_operation);
+  }
+}
+
+caf::error decompress_block(block_compression codec, const void* data,
+                            size_t size, size_t raw_size, block_buffer& out) {
+  switch (codec) {
+    case block_compression::none: {
+      if (size != raw_size)
+        return make_error(ec::invalid_data, "block size mismatch");
+      auto first = reinterpret_cast<const block_buffer::value_type*>(data);
+      out.assign(first, first + size);
+      return caf::none;
+    }
+#ifdef BROKER_HAVE_ZLIB
+    case block_compression::zlib: {
+      out.resize(raw_size);
+      auto len = static_cast<uLongf>(raw_size);
+      auto res = uncompress(reinterpret_cast<Bytef*>(out.data()), &len,
+                            reinterpret_cast<const Bytef*>(data),
+                            static_cast<uLong>(size));
+      if (res != Z_OK || len != raw_size)
+        return make_error(ec::invalid_data, "zlib decompression failed");
+      return caf::none;
+    }
+#endif
+    default:
+      return caf::make_error(caf::sec::unsupported_operation);
+  }
+}
+
+} // namespace broker::detail
@@ -1,5 +1,8 @@
 #include "broker/detail/core_recorder.hh"
 
+#include <chrono>
+#include <limits>
+
 #include <caf/actor_system_config.hpp>
 #include <caf/config_value.hpp>
 #include <caf/local_actor.hpp>
@@ -24,12 +27,48 @@ core_recorder::core_recorder(caf::local_actor* self) {
     if (!open_file(id_file, meta_dir + "/id.txt"))
       return;
     id_file << to_string(self->node()) << '\n';
+    auto queue_size = get_or(cfg, "broker.recording-queue-size",
+                             defaults::recording_queue_size);
+    flight_recorder::limits limits;
+    limits.max_entries = get_or(cfg, "broker.flight-recorder-entries",
+                                defaults::flight_recorder_entries);
+    limits.max_age = get_or(cfg, "broker.flight-recorder-duration",
+                            defaults::flight_recorder_duration);
+    limits.num_segments = get_or(cfg, "broker.flight-recorder-segments",
+                                 defaults::flight_recorder_segments);
+    if (limits.max_entries > 0 || limits.max_age.count() > 0) {
+      auto segments_dir = meta_dir + "/segments";
+      if (!is_directory(segments_dir) && !mkdirs(segments_dir)) {
+        BROKER_WARNING("cannot create directory" << segments_dir);
+        return;
+      }
+      // Include the start time in the file names to not override dumps from
+      // previous runs.
+      auto secs = std::chrono::duration_cast<std::chrono::seconds>(
+        now().time_since_epoch());
+      auto prefix = meta_dir + "/flight-recording-"
+                    + std::to_string(secs.count()) + "-";
+      BROKER_DEBUG("start flight recorder in" << segments_dir);
+      auto max_dumps = get_or(cfg, "broker.flight-recorder-dumps",
+                              defaults::flight_recorder_dumps);
+      min_dump_interval_ = get_or(cfg, "broker.flight-recorder-dump-interval",
+                                  defaults::flight_recorder_dump_interval);
+      flight_recorder_ptr recorder{new flight_recorder(segments_dir, limits)};
+      writer_.reset(new async_generator_file_writer(std::move(recorder),
+                                                    std::move(prefix),
+                                                    queue_size, max_dumps));
+      // The flight recorder never stops recording.
+      remaining_records_ = std::numeric_limits<size_t>::max();
+      return;
+    }
     auto messages_file_name = meta_dir + "/messages.dat";
-    writer_ = make_generator_file_writer(messages_file_name);
-    if (writer_ == nullptr) {
+    auto writer = make_generator_file_writer(messages_file_name);
+    if (writer == nullptr) {
       BROKER_WARNING("cannot open recording file" << messages_file_name);
     } else {
       BROKER_DEBUG("opened file for recording:" << messages_file_name);
+      writer_.reset(
+        new async_generator_file_writer(std::move(writer), queue_size));
       remaining_records_ = get_or(cfg, "broker.output-generator-file-cap",
                                   defaults::output_generator_file_cap);
     }
@@ -58,6 +97,25 @@ void core_recorder::record_peer(const caf::node_id& peer_id) {
     peers_file_ << to_string(peer_id) << std::endl;
 }
 
+void core_recorder::dump() {
+  if (writer_)
+    writer_->dump();
+}
+
+void core_recorder::dump_on_failure() {
+  if (!writer_)
+    return;
+  auto t = now();
+  if (last_failure_dump_ != timestamp{}
+      && t - last_failure_dump_ < min_dump_interval_) {
+    BROKER_DEBUG("skip dump: last automatic dump was less than"
+                 << to_string(min_dump_interval_) << "ago");
+    return;
+  }
+  last_failure_dump_ = t;
+  writer_->dump();
+}
+
 bool core_recorder::open_file(std::ofstream& fs, std::string file_name) {
   fs.open(file_name);
   if (fs.is_open()) {
@@ -0,0 +1,63 @@
+#include "broker/detail/core_shards.hh"
+
+#include <cstdint>
+
+#include <caf/string_view.hpp>
+
+#include "broker/detail/assert.hh"
+
+namespace broker::detail {
+
+namespace {
+
+// Returns the top-level component of `str` if `str` contains a separator.
+caf::string_view top_level_component(const std::string& str, bool& complete) {
+  auto pos = str.find(topic::sep);
+  complete = pos != std::string::npos;
+  return caf::string_view{str.data(), complete ? pos : str.size()};
+}
+
+// All peers must agree on the mapping, hence we use FNV-1a instead of
+// std::hash, which differs between standard library implementations.
+uint64_t fnv1a(caf::string_view str) {
+  uint64_t result = 14695981039346656037ull;
+  for (auto c : str) {
+    result ^= static_cast<uint8_t>(c);
+    result *= 1099511628211ull;
+  }
+  return result;
+}
+
+size_t shard_of_component(caf::string_view component, size_t num_shards) {
+  if (num_shards < 2 || component == caf::string_view{topic::reserved})
+    return 0;
+  return static_cast<size_t>(fnv1a(component) % num_shards);
+}
+
+} // namespace
+
+size_t shard_of(const topic& x, size_t num_shards) {
+  BROKER_ASSERT(num_shards > 0);
+  bool complete = false;
+  return shard_of_component(top_level_component(x.string(), complete),
+                            num_shards);
+}
+
+std::vector<filter_type> partition(const filter_type& xs, size_t num_shards) {
+  BROKER_ASSERT(num_shards > 0);
+  std::vector<filter_type> result;
+  result.resize(num_shards);
+  for (auto& x : xs) {
+    bool complete = false;
+    auto component = top_level_component(x.string(), complete);
+    if (complete) {
+      result[shard_of_component(component, num_shards)].emplace_back(x);
+    } else {
+      for (auto& f : result)
+        f.emplace_back(x);
+    }
+  }
+  return result;
+}
+
+} // namespace broker::detail
@@ -179,6 +179,69 @@ caf::error data_generator::generate(internal_command::type tag,
   return caf::none;
 }
 
+template <class Value, class Message>
+caf::error data_generator::generate_pooled(pool_map<Message>& pools,
+                                           const topic& t, Message& x) {
+  // Parse the meta data once without generating anything to find the bytes
+  // that describe the shape of the next value.
+  auto first = source_.current();
+  typename Value::type tag{};
+  READ(tag);
+  BROKER_TRY(skip(tag));
+  auto last = source_.current();
+  auto shape = caf::make_span(first, static_cast<size_t>(last - first));
+  auto make = [&] {
+    caf::binary_deserializer source{nullptr, shape};
+    unsigned seed = 0;
+    shuffle(seed);
+    data_generator g{source, seed};
+    Value value;
+    BROKER_TRY(g.generate(value));
+    x = Message(t, std::move(value));
+    return caf::error{};
+  };
+  // Prefix the topic with its size to make keys unambiguous.
+  auto& str = t.string();
+  auto len = static_cast<uint32_t>(str.size());
+  key_.assign(reinterpret_cast<const char*>(&len), sizeof(len));
+  key_ += str;
+  key_.append(reinterpret_cast<const char*>(first),
+              reinterpret_cast<const char*>(last));
+  auto i = pools.find(key_);
+  if (i == pools.end()) {
+    if (pools.size() >= max_pools)
+      return make();
+    i = pools.emplace(key_, message_pool<Message>{}).first;
+  }
+  auto& pool = i->second;
+  if (pool.xs.size() < pool_size_) {
+    BROKER_TRY(make());
+    pool.xs.emplace_back(x);
+    return caf::none;
+  }
+  x = pool.xs[pool.next];
+  pool.next = (pool.next + 1) % pool.xs.size();
+  return caf::none;
+}
+
+caf::error data_generator::generate(const topic& t, data_message& x) {
+  if (pool_size_ > 0)
+    return generate_pooled<data>(data_pools_, t, x);
+  data value;
+  GENERATE(value);
+  x = make_data_message(t, std::move(value));
+  return caf::none;
+}
+
+caf::error data_generator::generate(const topic& t, command_message& x) {
+  if (pool_size_ > 0)
+    return generate_pooled<internal_command>(command_pools_, t, x);
+  internal_command cmd;
+  GENERATE(cmd);
+  x = make_command_message(t, std::move(cmd));
+  return caf::none;
+}
+
 caf::error data_generator::generate(vector& xs) {
   uint32_t size = 0;
   READ(size);
@@ -244,6 +307,83 @@ caf::error data_generator::generate(enum_value& x) {
   return caf::none;
 }
 
+caf::error data_generator::skip(data::type tag) {
+  uint32_t size = 0;
+  data::type nested{};
+  switch (tag) {
+    case data::type::none:
+    case data::type::boolean:
+    case data::type::count:
+    case data::type::integer:
+    case data::type::real:
+    case data::type::address:
+    case data::type::subnet:
+    case data::type::port:
+    case data::type::timestamp:
+    case data::type::timespan:
+      return caf::none;
+    case data::type::string:
+    case data::type::enum_value:
+      READ(size);
+      return caf::none;
+    case data::type::set:
+    case data::type::vector:
+      READ(size);
+      for (size_t i = 0; i < size; ++i) {
+        READ(nested);
+        BROKER_TRY(skip(nested));
+      }
+      return caf::none;
+    case data::type::table:
+      READ(size);
+      for (size_t i = 0; i < size * 2; ++i) {
+        READ(nested);
+        BROKER_TRY(skip(nested));
+      }
+      return caf::none;
+    default:
+      return caf::sec::invalid_argument;
+  }
+}
+
+caf::error data_generator::skip(internal_command::type tag) {
+  using tag_type = internal_command::type;
+  auto skip_data = [this](size_t n) -> caf::error {
+    data::type nested{};
+    for (size_t i = 0; i < n; ++i) {
+      READ(nested);
+      BROKER_TRY(skip(nested));
+    }
+    return caf::none;
+  };
+  switch (tag) {
+    case tag_type::none:
+    case tag_type::snapshot_command:
+    case tag_type::snapshot_sync_command:
+    case tag_type::clear_command:
+      return caf::none;
+    case tag_type::erase_command:
+      return skip_data(1);
+    case tag_type::put_command:
+    case tag_type::put_unique_command:
+    case tag_type::subtract_command:
+      return skip_data(2);
+    case tag_type::add_command: {
+      BROKER_TRY(skip_data(2));
+      data::type init_type{};
+      READ(init_type);
+      return caf::none;
+    }
+    case tag_type::set_command: {
+      uint32_t size = 0;
+      READ(size);
+      return skip_data(size * size_t{2});
+    }
+    default:
+      return ec::invalid_tag;
+  }
+}
+
 void data_generator::shuffle(none&) {
   // nop
 }
@@ -141,6 +141,50 @@ bool remove_all(const path& p) {
     return ::remove(p.c_str()) == 0;
 }
 
+namespace {
+
+thread_local size_t disk_usage_total;
+
+int add_file_size(const char*, const struct stat* st, int flag, FTW*) {
+  if (flag == FTW_F)
+    disk_usage_total += static_cast<size_t>(st->st_size);
+  return 0;
+}
+
+} // namespace
+
+size_t disk_usage(const path& p) {
+  struct stat st;
+  if (::lstat(p.c_str(), &st) != 0)
+    return 0;
+  if (!S_ISDIR(st.st_mode))
+    return static_cast<size_t>(st.st_size);
+  disk_usage_total = 0;
+  ::nftw(p.c_str(), add_file_size, open_max(), FTW_PHYS);
+  return disk_usage_total;
+}
+
+} // namespace broker::detail
+
+#else // BROKER_HAS_STD_FILESYSTEM
+
+namespace broker::detail {
+
+size_t disk_usage(const path& p) {
+  std::error_code ec;
+  auto file_size = [&ec](const path& x) -> size_t {
+    auto result = std::filesystem::file_size(x, ec);
+    return ec ? 0 : static_cast<size_t>(result);
+  };
+  if (!std::filesystem::is_directory(p, ec))
+    return is_file(p) ? file_size(p) : 0;
+  size_t result = 0;
+  for (auto& entry : std::filesystem::recursive_directory_iterator(p, ec))
+    if (entry.is_regular_file(ec))
+      result += file_size(entry.path());
+  return result;
+}
+
 } // namespace broker::detail
 
 #endif // BROKER_HAS_STD_FILESYSTEM
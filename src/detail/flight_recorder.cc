@@ -0,0 +1,109 @@
+#include "broker/detail/flight_recorder.hh"
+
+#include <algorithm>
+
+#include <caf/error.hpp>
+#include <caf/none.hpp>
+
+#include "broker/detail/filesystem.hh"
+#include "broker/detail/generator_file_reader.hh"
+#include "broker/error.hh"
+#include "broker/logger.hh"
+
+namespace broker::detail {
+
+flight_recorder::flight_recorder(std::string directory, limits cfg)
+  : dir_(std::move(directory)), cfg_(cfg) {
+  cfg_.num_segments = std::max(cfg_.num_segments, size_t{1});
+  auto n = cfg_.num_segments;
+  // Round up to make sure that n segments hold at least max_entries.
+  max_segment_entries_ = (cfg_.max_entries + n - 1) / n;
+  max_segment_age_ = cfg_.max_age / static_cast<int64_t>(n);
+}
+
+flight_recorder::~flight_recorder() {
+  if (writer_ != nullptr) {
+    writer_ = nullptr;
+    remove(current_.file_name);
+  }
+  for (auto& x : closed_)
+    remove(x.file_name);
+}
+
+size_t flight_recorder::entries() const noexcept {
+  size_t result = writer_ != nullptr ? current_.entries : 0;
+  for (auto& x : closed_)
+    result += x.entries;
+  return result;
+}
+
+caf::error flight_recorder::write(const value_type& x, timestamp t) {
+  if (writer_ == nullptr) {
+    current_ = segment{};
+    current_.file_name = dir_ + "/segment-" + std::to_string(next_id_++)
+                         + ".dat";
+    current_.first_time = t;
+    writer_ = make_generator_file_writer(current_.file_name);
+    if (writer_ == nullptr)
+      return make_error(ec::cannot_open_file, current_.file_name);
+  }
+  BROKER_TRY(writer_->write(x, t));
+  ++current_.entries;
+  current_.last_time = t;
+  new_entries_ = true;
+  if ((max_segment_entries_ > 0 && current_.entries >= max_segment_entries_)
+      || (max_segment_age_.count() > 0
+          && t - current_.first_time >= max_segment_age_))
+    BROKER_TRY(close_segment());
+  drop_segments(t);
+  return caf::none;
+}
+
+caf::error flight_recorder::dump(const std::string& file_name) {
+  BROKER_TRY(close_segment());
+  auto out = make_generator_file_writer(file_name);
+  if (out == nullptr)
+    return make_error(ec::cannot_open_file, file_name);
+  for (auto& x : closed_) {
+    auto in = make_generator_file_reader(x.file_name);
+    if (in == nullptr)
+      return make_error(ec::cannot_open_file, x.file_name);
+    BROKER_TRY(out->append(*in));
+  }
+  BROKER_TRY(out->close());
+  BROKER_DEBUG("dumped" << entries() << "entries to" << file_name);
+  new_entries_ = false;
+  return caf::none;
+}
+
+caf::error flight_recorder::close_segment() {
+  if (writer_ == nullptr)
+    return caf::none;
+  auto err = writer_->close();
+  writer_ = nullptr;
+  closed_.emplace_back(std::move(current_));
+  current_ = segment{};
+  return err;
+}
+
+void flight_recorder::drop_segments(timestamp now) {
+  auto drop_oldest = [this] {
+    remove(closed_.front().file_name);
+    closed_.pop_front();
+  };
+  // Dumps close partial segments. Hence, we cannot simply keep the last N
+  // segments but must count the entries that remain after dropping one.
+  if (cfg_.max_entries > 0) {
+    auto total = entries();
+    while (!closed_.empty()
+           && total - closed_.front().entries >= cfg_.max_entries) {
+      total -= closed_.front().entries;
+      drop_oldest();
+    }
+  }
+  if (cfg_.max_age.count() > 0)
+    while (!closed_.empty() && now - closed_.front().last_time > cfg_.max_age)
+      drop_oldest();
+}
+
+} // namespace broker::detail
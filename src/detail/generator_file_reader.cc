@@ -1,5 +1,6 @@
 #include "broker/detail/generator_file_reader.hh"
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 
@@ -10,6 +11,7 @@
 
 #include "broker/config.hh"
 #include "broker/detail/assert.hh"
+#include "broker/detail/block_codec.hh"
 #include "broker/detail/generator_file_writer.hh"
 #include "broker/error.hh"
 #include "broker/logger.hh"
@@ -105,20 +107,38 @@ void* make_file_view(void* addr, size_t) {
 
 namespace broker::detail {
 
+namespace {
+
+caf::error read_topics(caf::binary_deserializer& source,
+                       std::vector<topic>& topics) {
+  uint16_t num_topics = 0;
+  BROKER_TRY(source(num_topics));
+  topics.clear();
+  topics.reserve(num_topics);
+  for (uint16_t i = 0; i < num_topics; ++i) {
+    std::string str;
+    BROKER_TRY(source(str));
+    topics.emplace_back(std::move(str));
+  }
+  return caf::none;
+}
+
+} // namespace
+
 generator_file_reader::generator_file_reader(file_handle fd,
                                              mapper_handle mapper,
                                              mapped_pointer addr,
-                                             size_t file_size)
+                                             size_t file_size, uint8_t version)
   : fd_(fd),
     mapper_(mapper),
     addr_(addr),
     file_size_(file_size),
     source_(nullptr,
             caf::make_span(reinterpret_cast<caf::byte*>(addr), file_size)),
-    generator_(source_) {
+    generator_(source_),
+    version_(version) {
   // We've already verified the file header in make_generator_file_reader.
-  source_.skip(sizeof(generator_file_writer::format::magic)
-               + sizeof(generator_file_writer::format::version));
+  source_.skip(format::header_size);
 }
 
 generator_file_reader::~generator_file_reader() {
@@ -126,22 +146,231 @@ generator_file_reader::~generator_file_reader() {
   close_file(fd_);
 }
 
+caf::error generator_file_reader::init() {
+  if (version_ < 2)
+    return caf::none;
+  if (!read_index()) {
+    BROKER_WARNING("generator file has no valid index, scanning all blocks");
+    BROKER_TRY(scan_blocks());
+  }
+  offsets_.clear();
+  offsets_.reserve(index_.size());
+  size_t total = 0;
+  for (auto& info : index_) {
+    auto& hdr = info.header;
+    offsets_.emplace_back(total);
+    total += hdr.entries;
+    data_entries_ += hdr.data_entries;
+    command_entries_ += hdr.entries - hdr.data_entries;
+  }
+  // The index already tells us everything about the file.
+  sealed_ = true;
+  timestamped_ = !index_.empty()
+                 && std::all_of(index_.begin(), index_.end(), [](auto& x) {
+                      return (x.header.flags & format::timestamped) != 0;
+                    });
+  return caf::none;
+}
+
+bool generator_file_reader::read_index() {
+  index_.clear();
+  topic_table_.clear();
+  if (file_size_ < format::header_size + format::trailer_size)
+    return false;
+  auto bytes = reinterpret_cast<const caf::byte*>(addr_);
+  auto trailer_offset = file_size_ - format::trailer_size;
+  caf::binary_deserializer trailer{
+    nullptr, caf::make_span(bytes + trailer_offset, format::trailer_size)};
+  uint64_t index_offset = 0;
+  uint32_t magic = 0;
+  if (trailer(index_offset, magic) || magic != format::index_magic
+      || index_offset < format::header_size || index_offset > trailer_offset)
+    return false;
+  caf::binary_deserializer source{
+    nullptr,
+    caf::make_span(bytes + index_offset, trailer_offset - index_offset)};
+  uint32_t num_topics = 0;
+  auto valid = [&] {
+    if (source(num_topics))
+      return false;
+    for (uint32_t i = 0; i < num_topics; ++i) {
+      std::string str;
+      if (source(str))
+        return false;
+      topic_table_.emplace_back(std::move(str));
+    }
+    if (source(index_))
+      return false;
+    // Empty blocks never occur in valid files and would break read(), which
+    // assumes that each block yields at least one entry.
+    return std::all_of(index_.begin(), index_.end(), [&](auto& info) {
+      auto& hdr = info.header;
+      return info.offset >= format::header_size && info.offset <= index_offset
+             && index_offset - info.offset
+                  >= format::block_header_size + uint64_t{hdr.stored_size}
+             && hdr.entries > 0 && hdr.data_entries <= hdr.entries;
+    });
+  };
+  if (valid())
+    return true;
+  BROKER_WARNING("generator file has a corrupt index");
+  index_.clear();
+  topic_table_.clear();
+  return false;
+}
+
+caf::error generator_file_reader::scan_blocks() {
+  index_.clear();
+  topic_table_.clear();
+  auto bytes = reinterpret_cast<const caf::byte*>(addr_);
+  auto pos = format::header_size;
+  buffer_type buf;
+  std::vector<topic> topics;
+  while (file_size_ - pos >= format::block_header_size) {
+    format::block_info info;
+    info.offset = pos;
+    caf::binary_deserializer source{
+      nullptr, caf::make_span(bytes + pos, format::block_header_size)};
+    auto& hdr = info.header;
+    auto max_size = file_size_ - pos - format::block_header_size;
+    if (source(hdr) || hdr.entries == 0 || hdr.data_entries > hdr.entries
+        || hdr.codec > format::compression::zlib || hdr.stored_size > max_size)
+      break;
+    // Stop at the first block that fails to decode, since this is most likely
+    // a partially written block or the beginning of a truncated index.
+    index_.emplace_back(info);
+    caf::error err;
+    caf::binary_deserializer payload_source{nullptr,
+                                            payload(index_.size() - 1, buf,
+                                                    err)};
+    if (err || read_topics(payload_source, topics)) {
+      index_.pop_back();
+      break;
+    }
+    for (auto& x : topics)
+      if (std::find(topic_table_.begin(), topic_table_.end(), x)
+          == topic_table_.end())
+        topic_table_.emplace_back(x);
+    pos += format::block_header_size + hdr.stored_size;
+  }
+  return caf::none;
+}
+
+caf::span<const caf::byte>
+generator_file_reader::payload(size_t i, buffer_type& buf,
+                               caf::error& err) const {
+  auto& info = index_[i];
+  auto& hdr = info.header;
+  auto first = reinterpret_cast<const caf::byte*>(addr_) + info.offset
+               + format::block_header_size;
+  if (hdr.codec == format::compression::none) {
+    // Uncompressed blocks are readable directly from the mapped file.
+    if (hdr.stored_size != hdr.raw_size) {
+      err = make_error(ec::invalid_data, "block size mismatch");
+      return {};
+    }
+    return caf::make_span(first, hdr.stored_size);
+  }
+  err = decompress_block(hdr.codec, first, hdr.stored_size, hdr.raw_size, buf);
+  if (err)
+    return {};
+  return caf::make_span(reinterpret_cast<const caf::byte*>(buf.data()),
+                        buf.size());
+}
+
+caf::span<const caf::byte>
+generator_file_reader::raw_block(size_t i) const noexcept {
+  auto& info = index_[i];
+  auto first = reinterpret_cast<const caf::byte*>(addr_) + info.offset;
+  return caf::make_span(first,
+                        format::block_header_size + info.header.stored_size);
+}
+
+caf::error generator_file_reader::load_block(size_t i) {
+  caf::error err;
+  auto bytes = payload(i, block_buf_, err);
+  if (err)
+    return err;
+  source_.reset(bytes);
+  BROKER_TRY(read_topics(source_, block_topics_));
+  next_block_ = i + 1;
+  block_remaining_ = index_[i].header.entries;
+  block_flags_ = index_[i].header.flags;
+  block_time_ = index_[i].header.first_time;
+  return caf::none;
+}
+
+caf::error generator_file_reader::read_entry(caf::binary_deserializer& source,
+                                             data_generator& generator,
+                                             const std::vector<topic>& topics,
+                                             uint8_t flags, timestamp& t,
+                                             value_type& x) const {
+  using entry_type = format::entry_type;
+  entry_type entry{};
+  uint16_t topic_id = 0;
+  BROKER_TRY(source(entry, topic_id));
+  if (topic_id >= topics.size())
+    return ec::invalid_topic_key;
+  if ((flags & format::timestamped) != 0) {
+    int64_t delta = 0;
+    BROKER_TRY(read_varint(source, delta));
+    t += timespan{delta};
+  }
+  switch (entry) {
+    case entry_type::data_message: {
+      data_message msg;
+      BROKER_TRY(generator.generate(topics[topic_id], msg));
+      x = std::move(msg);
+      return caf::none;
+    }
+    case entry_type::command_message: {
+      command_message msg;
+      BROKER_TRY(generator.generate(topics[topic_id], msg));
+      x = std::move(msg);
+      return caf::none;
+    }
+    default:
+      return ec::invalid_tag;
+  }
+}
+
 bool generator_file_reader::at_end() const {
-  return source_.remaining() == 0;
+  if (version_ < 2)
+    return source_.remaining() == 0;
+  return block_remaining_ == 0 && next_block_ >= index_.size();
 }
 
 void generator_file_reader::rewind() {
+  if (version_ >= 2) {
+    next_block_ = 0;
+    block_remaining_ = 0;
+    return;
+  }
   BROKER_ASSERT(at_end());
   sealed_ = true;
   source_.reset({reinterpret_cast<caf::byte*>(addr_), file_size_});
-  source_.skip(sizeof(generator_file_writer::format::magic)
-               + sizeof(generator_file_writer::format::version));
+  source_.skip(format::header_size);
 }
 
 caf::error generator_file_reader::read(value_type& x) {
+  timestamp t;
+  return read(x, t);
+}
+
+caf::error generator_file_reader::read(value_type& x, timestamp& t) {
   if (at_end())
     return ec::end_of_file;
-  using entry_type = generator_file_writer::format::entry_type;
+  if (version_ >= 2) {
+    if (block_remaining_ == 0)
+      BROKER_TRY(load_block(next_block_));
+    --block_remaining_;
+    BROKER_TRY(read_entry(source_, generator_, block_topics_, block_flags_,
+                          block_time_, x));
+    t = (block_flags_ & format::timestamped) != 0 ? block_time_ : timestamp{};
+    return caf::none;
+  }
+  t = timestamp{};
+  using entry_type = format::entry_type;
   // Read until we got a data_message, a command_message, or an error.
   for (;;) {
     entry_type entry{};
@@ -159,9 +388,9 @@ caf::error generator_file_reader::read(value_type& x) {
         BROKER_TRY(source_(topic_id));
         if (topic_id >= topic_table_.size())
           return ec::invalid_topic_key;
-        data value;
-        BROKER_TRY(generator_(value));
-        x = make_data_message(topic_table_[topic_id], std::move(value));
+        data_message msg;
+        BROKER_TRY(generator_.generate(topic_table_[topic_id], msg));
+        x = std::move(msg);
         if (!sealed_)
           ++data_entries_;
         return caf::none;
@@ -171,9 +400,9 @@ caf::error generator_file_reader::read(value_type& x) {
         BROKER_TRY(source_(topic_id));
         if (topic_id >= topic_table_.size())
           return ec::invalid_topic_key;
-        internal_command cmd;
-        BROKER_TRY(generator_(cmd));
-        x = make_command_message(topic_table_[topic_id], std::move(cmd));
+        command_message msg;
+        BROKER_TRY(generator_.generate(topic_table_[topic_id], msg));
+        x = std::move(msg);
         if (!sealed_)
           ++command_entries_;
         return caf::none;
@@ -190,12 +419,79 @@ caf::error generator_file_reader::skip() {
 }
 
 caf::error generator_file_reader::skip_to_end() {
+  if (version_ >= 2) {
+    next_block_ = index_.size();
+    block_remaining_ = 0;
+    return caf::none;
+  }
   while (!at_end())
     if (auto err = skip())
       return err;
   return caf::none;
 }
 
+caf::error generator_file_reader::seek(size_t n) {
+  if (version_ < 2) {
+    // Version 1 files only support sequential access.
+    BROKER_TRY(skip_to_end());
+    rewind();
+    for (; n > 0; --n)
+      BROKER_TRY(skip());
+    return caf::none;
+  }
+  if (n >= entries()) {
+    skip_to_end();
+    return n == entries() ? caf::none : caf::error{ec::end_of_file};
+  }
+  auto i = std::upper_bound(offsets_.begin(), offsets_.end(), n);
+  auto block_index = static_cast<size_t>(std::distance(offsets_.begin(), i))
+                     - 1;
+  BROKER_TRY(load_block(block_index));
+  for (auto k = n - offsets_[block_index]; k > 0; --k)
+    BROKER_TRY(skip());
+  return caf::none;
+}
+
+caf::error generator_file_reader::decode_block(size_t i,
+                                               std::vector<value_type>& xs) const {
+  return decode_block_impl(i, xs, nullptr);
+}
+
+caf::error
+generator_file_reader::decode_block(size_t i, std::vector<value_type>& xs,
+                                    std::vector<timestamp>& ts) const {
+  return decode_block_impl(i, xs, &ts);
+}
+
+caf::error
+generator_file_reader::decode_block_impl(size_t i, std::vector<value_type>& xs,
+                                         std::vector<timestamp>* ts) const {
+  buffer_type buf;
+  caf::error err;
+  auto bytes = payload(i, buf, err);
+  if (err)
+    return err;
+  caf::binary_deserializer source{nullptr, bytes};
+  data_generator generator{source, static_cast<unsigned>(i)};
+  generator.pool_size(generator_.pool_size());
+  std::vector<topic> topics;
+  BROKER_TRY(read_topics(source, topics));
+  auto& hdr = index_[i].header;
+  auto timestamped = (hdr.flags & format::timestamped) != 0;
+  auto t = hdr.first_time;
+  xs.reserve(xs.size() + hdr.entries);
+  if (ts != nullptr)
+    ts->reserve(ts->size() + hdr.entries);
+  for (size_t j = 0; j < hdr.entries; ++j) {
+    value_type x;
+    BROKER_TRY(read_entry(source, generator, topics, hdr.flags, t, x));
+    xs.emplace_back(std::move(x));
+    if (ts != nullptr)
+      ts->emplace_back(timestamped ? t : timestamp{});
+  }
+  return caf::none;
+}
+
 generator_file_reader_ptr make_generator_file_reader(const std::string& fname) {
   // Get a file handle for the file.
   auto [fd, fd_ok] = open_file(fname.c_str());
@@ -239,15 +535,20 @@ generator_file_reader_ptr make_generator_file_reader(const std::string& fname) {
     BROKER_ERROR("unexpected file header (magic mismatch):" << fname);
     return nullptr;
   }
-  if (version != generator_file_writer::format::version) {
+  if (version == 0 || version > generator_file_writer::format::version) {
     BROKER_ERROR("unexpected file header (version mismatch):" << fname);
     return nullptr;
   }
   // Done.
-  auto ptr = new generator_file_reader(fd, mapper, addr, fsize);
+  generator_file_reader_ptr result{
+    new generator_file_reader(fd, mapper, addr, fsize, version)};
   guard1.disable();
   guard2.disable();
-  return generator_file_reader_ptr{ptr};
+  if (auto err = result->init()) {
+    BROKER_ERROR("unable to read the block index:" << fname << err);
+    return nullptr;
+  }
+  return result;
 }
 
 } // namespace broker::detail
@@ -1,8 +1,13 @@
 #include "broker/detail/generator_file_writer.hh"
 
+#include <algorithm>
+
 #include <caf/error.hpp>
 #include <caf/sec.hpp>
 
+#include "broker/detail/assert.hh"
+#include "broker/detail/block_codec.hh"
+#include "broker/detail/generator_file_reader.hh"
 #include "broker/detail/meta_command_writer.hh"
 #include "broker/detail/meta_data_writer.hh"
 #include "broker/error.hh"
@@ -13,19 +18,21 @@ namespace broker {
 namespace detail {
 
 generator_file_writer::generator_file_writer()
-  : sink_(nullptr, buf_), flush_threshold_(1024) {
-  buf_.reserve(2028);
+  : sink_(nullptr, buf_),
+    block_size_(format::default_block_size),
+    compression_(format::compression::none) {
+  buf_.reserve(block_size_ + 1024);
 }
 
 generator_file_writer::~generator_file_writer() {
-  if (auto err = flush())
-    BROKER_ERROR("flushing file in destructor failed:" << err);
+  if (auto err = close())
+    BROKER_ERROR("closing file in destructor failed:" << err);
 }
 
 caf::error generator_file_writer::open(std::string file_name) {
-  if (auto err = flush()) {
+  if (auto err = close()) {
     // Log the error, but ignore it otherwise.
-    BROKER_ERROR("flushing previous file failed:" << err);
+    BROKER_ERROR("closing previous file failed:" << err);
   }
   f_.open(file_name, std::ofstream::binary);
   if (!f_.is_open())
@@ -46,63 +53,193 @@ caf::error generator_file_writer::open(std::string file_name) {
     return make_error(ec::cannot_write_file, file_name);
   }
   file_name_ = std::move(file_name);
+  offset_ = format::header_size;
   return caf::none;
 }
 
 caf::error generator_file_writer::flush() {
-  if (!f_.is_open() || buf_.empty())
+  if (!f_.is_open())
     return caf::none;
-  if (!f_.write(reinterpret_cast<const char*>(buf_.data()), buf_.size()))
+  BROKER_TRY(write_block());
+  if (!f_.flush())
     return make_error(ec::cannot_write_file, file_name_);
-  buf_.clear();
-  sink_.seek(0);
   return caf::none;
 }
 
+caf::error generator_file_writer::close() {
+  if (!f_.is_open())
+    return caf::none;
+  auto cleanup = [this] {
+    f_.close();
+    buf_.clear();
+    sink_.seek(0);
+    offset_ = 0;
+    block_topics_.clear();
+    topic_table_.clear();
+    current_ = format::block_header{};
+    index_.clear();
+  };
+  if (auto err = write_block()) {
+    cleanup();
+    return err;
+  }
+  // Append the index, followed by the trailer that points to it.
+  payload_.clear();
+  caf::binary_serializer sink{nullptr, payload_};
+  auto index_offset = offset_;
+  auto num_topics = static_cast<uint32_t>(topic_table_.size());
+  auto err = sink(num_topics);
+  for (auto i = topic_table_.begin(); !err && i != topic_table_.end(); ++i)
+    err = sink(i->string());
+  if (!err)
+    err = sink(index_, index_offset, format::index_magic);
+  if (!err && !f_.write(reinterpret_cast<const char*>(payload_.data()),
+                        payload_.size()))
+    err = make_error(ec::cannot_write_file, file_name_);
+  cleanup();
+  return err;
+}
+
+caf::error generator_file_writer::append(const generator_file_reader& src) {
+  if (!f_.is_open())
+    return make_error(ec::cannot_write_file, file_name_);
+  if (src.version() < 2)
+    return caf::make_error(caf::sec::unsupported_operation,
+                           "cannot append version 1 generator files");
+  // Blocks are self-contained, so we can simply copy them byte by byte.
+  BROKER_TRY(write_block());
+  for (size_t i = 0; i < src.num_blocks(); ++i) {
+    auto bytes = src.raw_block(i);
+    if (!f_.write(reinterpret_cast<const char*>(bytes.data()), bytes.size()))
+      return make_error(ec::cannot_write_file, file_name_);
+    index_.emplace_back(format::block_info{offset_, src.block(i)});
+    offset_ += bytes.size();
+  }
+  for (auto& x : src.topics())
+    if (std::find(topic_table_.begin(), topic_table_.end(), x)
+        == topic_table_.end())
+      topic_table_.emplace_back(x);
+  return caf::none;
+}
+
+bool generator_file_writer::compression(format::compression x) noexcept {
+  if (!has_block_codec(x))
+    return false;
+  compression_ = x;
+  return true;
+}
+
 caf::error generator_file_writer::write(const data_message& x) {
+  return write(x, now());
+}
+
+caf::error generator_file_writer::write(const command_message& x) {
+  return write(x, now());
+}
+
+caf::error generator_file_writer::write(const data_or_command_message& x) {
+  return write(x, now());
+}
+
+caf::error generator_file_writer::write(const data_message& x, timestamp t) {
   meta_data_writer writer{sink_};
-  uint16_t tid;
   auto entry = format::entry_type::data_message;
-  BROKER_TRY(topic_id(get_topic(x), tid), sink_(entry, tid),
-             writer(get_data(x)));
-  if (buf_.size() >= flush_threshold())
-    return flush();
+  BROKER_TRY(write_entry(entry, get_topic(x), t), writer(get_data(x)));
+  ++current_.data_entries;
+  if (buf_.size() >= block_size_)
+    return write_block();
   return caf::none;
 }
 
-caf::error generator_file_writer::write(const command_message& x) {
+caf::error generator_file_writer::write(const command_message& x,
+                                        timestamp t) {
   meta_command_writer writer{sink_};
-  uint16_t tid;
   auto entry = format::entry_type::command_message;
-  BROKER_TRY(topic_id(get_topic(x), tid), sink_(entry, tid),
-             writer(get_command(x)));
-  if (buf_.size() >= flush_threshold())
-    return flush();
+  BROKER_TRY(write_entry(entry, get_topic(x), t), writer(get_command(x)));
+  if (buf_.size() >= block_size_)
+    return write_block();
   return caf::none;
 }
 
-caf::error generator_file_writer::write(const data_or_command_message& x) {
+caf::error generator_file_writer::write(const data_or_command_message& x,
+                                        timestamp t) {
   if (caf::holds_alternative<data_message>(x))
-    return write(caf::get<data_message>(x));
-  return write(caf::get<command_message>(x));
-}
-
-caf::error generator_file_writer::topic_id(const topic& x, uint16_t& id) {
-  auto e = topic_table_.end();
-  auto i = std::find(topic_table_.begin(), e, x);
-  if (i == e) {
-    // Write the new topic to file first.
-    auto entry = format::entry_type::new_topic;
-    if (auto err = sink_(entry, x.string()))
-      return err;
-    id = static_cast<uint16_t>(topic_table_.size());
-    topic_table_.emplace_back(x);
+    return write(caf::get<data_message>(x), t);
+  return write(caf::get<command_message>(x), t);
+}
+
+caf::error generator_file_writer::write_entry(format::entry_type type,
+                                              const topic& t, timestamp ts) {
+  if (!f_.is_open())
+    return make_error(ec::cannot_write_file, file_name_);
+  if (current_.entries == 0) {
+    current_.first_time = ts;
+    current_.last_time = ts;
+    current_.flags = format::timestamped;
+  }
+  auto delta = ts - current_.last_time;
+  current_.last_time = ts;
+  ++current_.entries;
+  auto tid = topic_id(t);
+  BROKER_TRY(sink_(type, tid));
+  return write_varint(sink_, delta.count());
+}
+
+caf::error generator_file_writer::write_block() {
+  if (current_.entries == 0)
     return caf::none;
+  // Assemble the payload: block-local topic table, followed by all entries.
+  payload_.clear();
+  caf::binary_serializer payload_sink{nullptr, payload_};
+  auto num_topics = static_cast<uint16_t>(block_topics_.size());
+  BROKER_TRY(payload_sink(num_topics));
+  for (auto& x : block_topics_)
+    BROKER_TRY(payload_sink(x.string()));
+  payload_.insert(payload_.end(), buf_.begin(), buf_.end());
+  current_.raw_size = static_cast<uint32_t>(payload_.size());
+  // Only store the compressed payload if it actually saves space.
+  auto* payload = &payload_;
+  current_.codec = format::compression::none;
+  if (compression_ != format::compression::none) {
+    BROKER_TRY(compress_block(compression_, payload_.data(), payload_.size(),
+                              compressed_));
+    if (compressed_.size() < payload_.size()) {
+      payload = &compressed_;
+      current_.codec = compression_;
+    }
   }
-  id = static_cast<uint16_t>(std::distance(topic_table_.begin(), i));
+  current_.stored_size = static_cast<uint32_t>(payload->size());
+  // Write block header and payload.
+  caf::binary_serializer::container_type header;
+  caf::binary_serializer header_sink{nullptr, header};
+  BROKER_TRY(header_sink(current_));
+  BROKER_ASSERT(header.size() == format::block_header_size);
+  if (!f_.write(reinterpret_cast<const char*>(header.data()), header.size())
+      || !f_.write(reinterpret_cast<const char*>(payload->data()),
+                   payload->size()))
+    return make_error(ec::cannot_write_file, file_name_);
+  index_.emplace_back(format::block_info{offset_, current_});
+  offset_ += header.size() + payload->size();
+  // Start a new block.
+  buf_.clear();
+  sink_.seek(0);
+  block_topics_.clear();
+  current_ = format::block_header{};
   return caf::none;
 }
 
+uint16_t generator_file_writer::topic_id(const topic& x) {
+  auto e = block_topics_.end();
+  auto i = std::find(block_topics_.begin(), e, x);
+  if (i != e)
+    return static_cast<uint16_t>(std::distance(block_topics_.begin(), i));
+  if (std::find(topic_table_.begin(), topic_table_.end(), x)
+      == topic_table_.end())
+    topic_table_.emplace_back(x);
+  block_topics_.emplace_back(x);
+  return static_cast<uint16_t>(block_topics_.size() - 1);
+}
+
 bool generator_file_writer::operator!() const {
   return !f_;
 }
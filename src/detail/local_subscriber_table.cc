@@ -0,0 +1,51 @@
+#include "broker/detail/local_subscriber_table.hh"
+
+#include <algorithm>
+
+#include <caf/make_counted.hpp>
+
+#include "broker/detail/prefix_matcher.hh"
+
+namespace broker::detail {
+
+void local_subscriber_table::add(queue_ptr queue, filter_type filter,
+                                 size_t max_qsize) {
+  std::unique_lock<std::mutex> guard{mtx_};
+  entries_.emplace_back(entry{std::move(queue), std::move(filter), max_qsize});
+  size_ = entries_.size();
+}
+
+void local_subscriber_table::set_filter(const queue_type* queue,
+                                        filter_type filter) {
+  std::unique_lock<std::mutex> guard{mtx_};
+  for (auto& x : entries_)
+    if (x.queue.get() == queue)
+      x.filter = std::move(filter);
+}
+
+void local_subscriber_table::erase(const queue_type* queue) {
+  std::unique_lock<std::mutex> guard{mtx_};
+  auto pred = [&](const entry& x) { return x.queue.get() == queue; };
+  entries_.erase(std::remove_if(entries_.begin(), entries_.end(), pred),
+                 entries_.end());
+  size_ = entries_.size();
+}
+
+size_t local_subscriber_table::deliver(const data_message& x) {
+  if (size_ == 0)
+    return 0;
+  prefix_matcher matches;
+  size_t result = 0;
+  std::unique_lock<std::mutex> guard{mtx_};
+  for (auto& e : entries_) {
+    if (matches(e.filter, x) && e.queue->try_produce(x, e.max_qsize))
+      ++result;
+  }
+  return result;
+}
+
+local_subscriber_table_ptr make_local_subscriber_table() {
+  return caf::make_counted<local_subscriber_table>();
+}
+
+} // namespace broker::detail
@@ -1,5 +1,7 @@
 #include "broker/logger.hh" // Needs to come before CAF includes.
 
+#include <chrono>
+
 #include <caf/actor.hpp>
 #include <caf/attach_stream_sink.hpp>
 #include <caf/behavior.hpp>
@@ -21,10 +23,21 @@
 #include "broker/detail/abstract_backend.hh"
 #include "broker/detail/die.hh"
 #include "broker/detail/master_actor.hh"
+#include "broker/detail/probes.hh"
 
 namespace broker {
 namespace detail {
 
+namespace {
+
+/// Names for all types of `internal_command`, in the order of the variant.
+constexpr const char* command_names[] = {
+  "none",     "put",      "put_unique",    "erase", "add",
+  "subtract", "snapshot", "snapshot_sync", "set",   "clear",
+};
+
+} // namespace
+
 static optional<timestamp> to_opt_timestamp(timestamp ts,
                                             optional<timespan> span) {
   return span ? ts + *span : optional<timestamp>();
@@ -32,10 +45,11 @@ static optional<timestamp> to_opt_timestamp(timestamp ts,
 
 void master_state::init(caf::event_based_actor* ptr, std::string&& nm,
                         backend_pointer&& bp, caf::actor&& parent,
-                        endpoint::clock* ep_clock) {
+                        endpoint::clock* ep_clock, metric_registry_ptr reg) {
   super::init(ptr, ep_clock, std::move(nm), std::move(parent));
   clones_topic = id / topics::clone_suffix;
   backend = std::move(bp);
+  metrics = reg != nullptr ? std::move(reg) : make_metric_registry();
   if (auto es = backend->expiries()) {
     for (auto& e : *es) {
       auto& key = e.first;
@@ -50,6 +64,26 @@ void master_state::init(caf::event_based_actor* ptr, std::string&& nm,
   }
 }
 
+master_state::~master_state() {
+  if (metrics != nullptr)
+    metrics->remove("store", id);
+}
+
+master_state::command_metrics&
+master_state::metrics_for(internal_command::type x) {
+  static_assert(std::size(command_names)
+                == std::tuple_size<decltype(cmd_metrics)>::value);
+  auto& result = cmd_metrics[static_cast<size_t>(x)];
+  if (result.count == nullptr) {
+    metric_labels labels{{"store", id},
+                         {"command", command_names[static_cast<size_t>(x)]}};
+    result.count = &metrics->counter("broker_store_commands_total", labels);
+    result.nanoseconds = &metrics->counter(
+      "broker_store_command_nanoseconds_total", std::move(labels));
+  }
+  return result;
+}
+
 void master_state::broadcast(internal_command&& x) {
   self->send(core, atom::publish_v,
              make_command_message(clones_topic, std::move(x)));
@@ -62,6 +96,7 @@ void master_state::remind(timespan expiry, const data& key) {
 
 void master_state::expire(data& key) {
   BROKER_INFO("EXPIRE" << key);
+  BROKER_PROBE1(store_expire, id.c_str());
   if (auto result = backend->expire(key, clock->now()); !result) {
     BROKER_ERROR("failed to expire key:" << to_string(result.error()));
   } else if (!*result) {
@@ -78,7 +113,14 @@ void master_state::command(internal_command& cmd) {
 }
 
 void master_state::command(internal_command::variant_type& cmd) {
+  auto& cm = metrics_for(static_cast<internal_command::type>(cmd.index()));
+  auto t0 = std::chrono::steady_clock::now();
   caf::visit(*this, cmd);
+  auto dt = std::chrono::steady_clock::now() - t0;
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(dt).count();
+  cm.count->inc();
+  cm.nanoseconds->inc(ns);
+  BROKER_PROBE3(store_command, id.c_str(), cmd.index(), ns);
 }
 
 void master_state::operator()(none) {
@@ -267,10 +309,10 @@ bool master_state::exists(const data& key) {
 caf::behavior master_actor(caf::stateful_actor<master_state>* self,
                            caf::actor core, std::string id,
                            master_state::backend_pointer backend,
-                           endpoint::clock* clock) {
+                           endpoint::clock* clock, metric_registry_ptr reg) {
   self->monitor(core);
   self->state.init(self, std::move(id), std::move(backend),
-                   std::move(core), clock);
+                   std::move(core), clock, std::move(reg));
   self->set_down_handler(
     [=](const caf::down_msg& msg) {
       if (msg.source == core) {
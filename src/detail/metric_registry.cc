@@ -0,0 +1,153 @@
+#include "broker/detail/metric_registry.hh"
+
+#include <algorithm>
+
+#include <caf/make_counted.hpp>
+
+#include "broker/logger.hh"
+
+namespace broker::detail {
+
+const char* to_string(metric::type x) {
+  switch (x) {
+    case metric::type::counter:
+      return "counter";
+    case metric::type::gauge:
+      return "gauge";
+  }
+  return "???";
+}
+
+metric& metric_registry::counter(std::string name, metric_labels labels) {
+  return get_or_add(metric::type::counter, std::move(name), std::move(labels));
+}
+
+metric& metric_registry::gauge(std::string name, metric_labels labels) {
+  return get_or_add(metric::type::gauge, std::move(name), std::move(labels));
+}
+
+void metric_registry::remove(const std::string& key,
+                             const std::string& value) {
+  std::unique_lock<std::mutex> guard{mtx_};
+  for (auto i = metrics_.begin(); i != metrics_.end();) {
+    auto& labels = i->first.second;
+    auto j = labels.find(key);
+    if (j != labels.end() && j->second == value)
+      i = metrics_.erase(i);
+    else
+      ++i;
+  }
+}
+
+void metric_registry::remove(const metric_labels& labels) {
+  auto has_all_labels = [&labels](const metric_labels& xs) {
+    return std::all_of(labels.begin(), labels.end(), [&xs](const auto& kvp) {
+      auto i = xs.find(kvp.first);
+      return i != xs.end() && i->second == kvp.second;
+    });
+  };
+  std::unique_lock<std::mutex> guard{mtx_};
+  for (auto i = metrics_.begin(); i != metrics_.end();) {
+    if (has_all_labels(i->first.second))
+      i = metrics_.erase(i);
+    else
+      ++i;
+  }
+}
+
+size_t metric_registry::size() const {
+  std::unique_lock<std::mutex> guard{mtx_};
+  return metrics_.size();
+}
+
+std::vector<metric_sample> metric_registry::collect() const {
+  std::vector<metric_sample> result;
+  std::unique_lock<std::mutex> guard{mtx_};
+  result.reserve(metrics_.size());
+  for (auto& [key, ptr] : metrics_)
+    result.emplace_back(
+      metric_sample{key.first, key.second, ptr->kind(), ptr->value()});
+  return result;
+}
+
+table metric_registry::snapshot() const {
+  table result;
+  for (auto& x : collect())
+    result.emplace(render_metric_name(x.name, x.labels), integer{x.value});
+  return result;
+}
+
+metric& metric_registry::get_or_add(metric::type kind, std::string name,
+                                    metric_labels labels) {
+  std::unique_lock<std::mutex> guard{mtx_};
+  key_type key{std::move(name), std::move(labels)};
+  auto i = metrics_.find(key);
+  if (i == metrics_.end()) {
+    auto ptr = std::make_unique<metric>(kind);
+    i = metrics_.emplace(std::move(key), std::move(ptr)).first;
+  } else if (i->second->kind() != kind) {
+    BROKER_WARNING("metric" << i->first.first << "registered as"
+                            << to_string(i->second->kind()));
+  }
+  return *i->second;
+}
+
+metric_registry_ptr make_metric_registry() {
+  return caf::make_counted<metric_registry>();
+}
+
+std::string render_metric_name(const std::string& name,
+                               const metric_labels& labels) {
+  if (labels.empty())
+    return name;
+  auto result = name;
+  result += '{';
+  auto first = true;
+  for (auto& [key, value] : labels) {
+    if (!first)
+      result += ',';
+    first = false;
+    result += key;
+    result += "=\"";
+    for (auto ch : value) {
+      switch (ch) {
+        case '\\':
+          result += "\\\\";
+          break;
+        case '"':
+          result += "\\\"";
+          break;
+        case '\n':
+          result += "\\n";
+          break;
+        default:
+          result += ch;
+      }
+    }
+    result += '"';
+  }
+  result += '}';
+  return result;
+}
+
+std::string render_prometheus(const std::vector<metric_sample>& xs) {
+  std::string result;
+  const std::string* last_name = nullptr;
+  for (auto& x : xs) {
+    if (last_name == nullptr || *last_name != x.name) {
+      result += "# TYPE ";
+      result += x.name;
+      result += ' ';
+      result += to_string(x.kind);
+      result += '\n';
+      last_name = &x.name;
+    }
+    result += render_metric_name(x.name, x.labels);
+    result += ' ';
+    result += std::to_string(x.value);
+    result += '\n';
+  }
+  return result;
+}
+
+} // namespace broker::detail
@@ -1,5 +1,6 @@
 #include "broker/detail/network_cache.hh"
 
+#include "broker/atoms.hh"
 #include "broker/logger.hh"
 
 namespace broker {
@@ -21,6 +22,50 @@ caf::result<caf::actor> network_cache::fetch(const network_info& x) {
   return rp;
 }
 
+caf::behavior network_cache::connect_worker(caf::event_based_actor* self) {
+  return {
+    [=](atom::connect, const std::string& host,
+        uint16_t port) -> caf::expected<caf::io::scribe_ptr> {
+      self->quit();
+      // Blocks this thread only.
+      return self->home_system().middleman().backend().new_tcp_scribe(host,
+                                                                      port);
+    },
+  };
+}
+
+void network_cache::connect_done() {
+  --active_connects_;
+  if (!queued_connects_.empty() && active_connects_ < connect_workers_) {
+    auto f = std::move(queued_connects_.front());
+    queued_connects_.pop_front();
+    f();
+  }
+}
+
+void network_cache::connect_succeeded(const network_info& x,
+                                      const caf::actor& hdl) {
+  auto i = pending_.find(x);
+  if (i == pending_.end())
+    return;
+  // Callbacks may call `fetch` again, so we must not touch the map entry
+  // while calling them.
+  auto waiters = std::move(i->second);
+  pending_.erase(i);
+  for (auto& w : waiters)
+    w.first(hdl);
+}
+
+void network_cache::connect_failed(const network_info& x, caf::error err) {
+  auto i = pending_.find(x);
+  if (i == pending_.end())
+    return;
+  auto waiters = std::move(i->second);
+  pending_.erase(i);
+  for (auto& w : waiters)
+    w.second(err);
+}
+
 caf::optional<caf::actor> network_cache::find(const network_info& x) {
   auto i = hdls_.find(x);
   if (i != hdls_.end())
@@ -0,0 +1,86 @@
+#include "broker/detail/parallel_generator_file_reader.hh"
+
+#include <algorithm>
+
+#include "broker/detail/assert.hh"
+#include "broker/error.hh"
+#include "broker/logger.hh"
+#include "broker/message.hh"
+
+namespace broker::detail {
+
+parallel_generator_file_reader::parallel_generator_file_reader(
+  generator_file_reader_ptr reader, size_t num_threads, size_t max_pending,
+  bool cycle)
+  : reader_(std::move(reader)),
+    cycle_(cycle),
+    slots_(std::max(max_pending, size_t{1})) {
+  BROKER_ASSERT(reader_ != nullptr);
+  if (reader_->num_blocks() == 0)
+    return;
+  num_threads = std::max(num_threads, size_t{1});
+  threads_.reserve(num_threads);
+  for (size_t i = 0; i < num_threads; ++i)
+    threads_.emplace_back([this] { run(); });
+}
+
+parallel_generator_file_reader::~parallel_generator_file_reader() {
+  {
+    std::unique_lock<std::mutex> guard{mtx_};
+    done_ = true;
+  }
+  producer_cv_.notify_all();
+  for (auto& t : threads_)
+    t.join();
+}
+
+bool parallel_generator_file_reader::at_end() const noexcept {
+  auto n = reader_->num_blocks();
+  return n == 0 || (!cycle_ && consumed_ >= n);
+}
+
+caf::error parallel_generator_file_reader::next(batch& x) {
+  if (at_end())
+    return ec::end_of_file;
+  std::unique_lock<std::mutex> guard{mtx_};
+  auto& st = slots_[consumed_ % slots_.size()];
+  consumer_cv_.wait(guard, [&st] { return st.ready; });
+  x = std::move(st.content);
+  auto err = std::move(st.err);
+  st.content = batch{};
+  st.ready = false;
+  ++consumed_;
+  // We have freed one slot, i.e., one worker may claim another block.
+  producer_cv_.notify_one();
+  return err;
+}
+
+void parallel_generator_file_reader::run() {
+  auto n = reader_->num_blocks();
+  auto exhausted = [&] { return !cycle_ && claimed_ >= n; };
+  std::unique_lock<std::mutex> guard{mtx_};
+  for (;;) {
+    producer_cv_.wait(guard, [&] {
+      return done_ || exhausted() || claimed_ < consumed_ + slots_.size();
+    });
+    if (done_ || exhausted())
+      return;
+    auto seq = claimed_++;
+    guard.unlock();
+    batch tmp;
+    tmp.block = seq % n;
+    auto err = reader_->decode_block(tmp.block, tmp.xs, tmp.ts);
+    if (err)
+      BROKER_ERROR("unable to decode block" << tmp.block << ":" << err);
+    guard.lock();
+    // Only one worker claims a sequence number and the consumer waits for
+    // the slot, so no other thread writes to this slot in the meantime.
+    auto& st = slots_[seq % slots_.size()];
+    st.content = std::move(tmp);
+    st.err = std::move(err);
+    st.ready = true;
+    consumer_cv_.notify_one();
+  }
+}
+
+} // namespace broker::detail
@@ -0,0 +1,98 @@
+#include "broker/detail/prometheus_actor.hh"
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include <caf/io/receive_policy.hpp>
+#include <caf/io/system_messages.hpp>
+
+#include "broker/atoms.hh"
+#include "broker/data.hh"
+#include "broker/logger.hh"
+
+namespace broker::detail {
+
+namespace {
+
+/// Limits the size of request headers we accept.
+constexpr size_t max_request_size = 4096;
+
+/// Limits how long we wait for the core before giving up on a request.
+constexpr auto core_timeout = std::chrono::seconds(5);
+
+void respond(caf::io::broker* self, caf::io::connection_handle hdl,
+             const char* status, const std::string& body) {
+  std::string response = "HTTP/1.1 ";
+  response += status;
+  response += "\r\nContent-Type: text/plain; version=0.0.4\r\n"
+              "Content-Length: ";
+  response += std::to_string(body.size());
+  response += "\r\nConnection: close\r\n\r\n";
+  response += body;
+  self->write(hdl, response.size(), response.data());
+  self->flush(hdl);
+  self->quit();
+}
+
+} // namespace
+
+caf::behavior prometheus_actor(caf::io::broker* self, uint16_t port,
+                               std::string address, metric_registry_ptr reg,
+                               caf::actor core) {
+  auto addr = address.empty() ? nullptr : address.c_str();
+  auto res = self->add_tcp_doorman(port, addr, true);
+  if (!res) {
+    BROKER_ERROR("unable to serve metrics on port" << port << ":"
+                                                   << res.error());
+    self->quit(res.error());
+    return {};
+  }
+  BROKER_INFO("serving metrics on port" << res->second);
+  return {
+    [=](const caf::io::new_connection_msg& msg) {
+      auto worker = self->fork(prometheus_connection, msg.handle, reg, core);
+      self->link_to(worker);
+    },
+    [=](const caf::io::acceptor_closed_msg&) {
+      BROKER_ERROR("lost the metrics port");
+      self->quit();
+    },
+  };
+}
+
+caf::behavior prometheus_connection(caf::io::broker* self,
+                                    caf::io::connection_handle hdl,
+                                    metric_registry_ptr reg, caf::actor core) {
+  self->configure_read(hdl, caf::io::receive_policy::at_most(1024));
+  auto buf = std::make_shared<std::string>();
+  return {
+    [=](const caf::io::new_data_msg& msg) {
+      buf->insert(buf->end(), msg.buf.begin(), msg.buf.end());
+      if (buf->find("\r\n\r\n") == std::string::npos) {
+        if (buf->size() > max_request_size)
+          respond(self, hdl, "400 Bad Request", "request too large\n");
+        return;
+      }
+      // Stop reading, we only handle one request per connection.
+      self->configure_read(hdl, caf::io::receive_policy::at_most(0));
+      if (buf->compare(0, 13, "GET /metrics ") != 0) {
+        respond(self, hdl, "404 Not Found", "try /metrics\n");
+        return;
+      }
+      self->request(core, core_timeout, atom::get_v, atom::metrics_v)
+        .then(
+          [=](const table&) {
+            respond(self, hdl, "200 OK", render_prometheus(reg->collect()));
+          },
+          [=](const caf::error& err) {
+            BROKER_WARNING("unable to sample metrics:" << err);
+            respond(self, hdl, "503 Service Unavailable",
+                    "unable to sample metrics\n");
+          });
+    },
+    [=](const caf::io::connection_closed_msg&) { self->quit(); },
+  };
+}
+
+} // namespace broker::detail
@@ -0,0 +1,18 @@
+#include "broker/detail/retry_state.hh"
+
+#include <algorithm>
+
+namespace broker::detail {
+
+timespan retry_delay(timespan base, uint32_t count, timespan max_delay,
+                     std::minstd_rand& rng) {
+  auto upper_bound = std::max(base, max_delay);
+  auto result = base;
+  for (uint32_t i = 0; i < count && result < upper_bound; ++i)
+    result *= 2;
+  result = std::min(result, upper_bound);
+  std::uniform_int_distribution<timespan::rep> jitter{0, result.count() / 2};
+  return result + timespan{jitter(rng)};
+}
+
+} // namespace broker::detail
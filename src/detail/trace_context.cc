@@ -0,0 +1,40 @@
+#include "broker/detail/trace_context.hh"
+
+#include <random>
+
+namespace broker::detail {
+
+const char* to_string(trace_hop x) {
+  switch (x) {
+    case trace_hop::publisher_worker:
+      return "publisher_worker";
+    case trace_hop::origin:
+      return "origin";
+    case trace_hop::peer_ingress:
+      return "peer_ingress";
+    case trace_hop::forward:
+      return "forward";
+    case trace_hop::delivery:
+      return "delivery";
+    case trace_hop::subscriber_sink:
+      return "subscriber_sink";
+  }
+  return "???";
+}
+
+data to_data(const trace_context& x, const topic& t) {
+  vector points;
+  points.reserve(x.points.size());
+  for (auto& point : x.points)
+    points.emplace_back(vector{to_string(point.hop), point.time});
+  return vector{count{x.id}, t.string(), std::move(points)};
+}
+
+trace_sampler::trace_sampler(size_t rate) : rate_(rate) {
+  // Start at a random offset to make IDs from different nodes unlikely to
+  // collide. The lower bits leave room for plenty of traces per node.
+  std::random_device rd;
+  last_id_ = static_cast<uint64_t>(rd()) << 32;
+}
+
+} // namespace broker::detail
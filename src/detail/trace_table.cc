@@ -0,0 +1,92 @@
+#include "broker/detail/trace_table.hh"
+
+#include <caf/make_counted.hpp>
+
+namespace broker::detail {
+
+namespace {
+
+// Copies of a data message share their content, i.e., the address of the
+// topic identifies the message.
+const void* key_of(const data_message& x) {
+  return &get_topic(x);
+}
+
+} // namespace
+
+trace_table::trace_table(size_t capacity, clock_type::duration max_age)
+  : capacity_(capacity), max_age_(max_age) {
+  // nop
+}
+
+void trace_table::put(const data_message& msg, trace_context ctx) {
+  if (capacity_ == 0)
+    return;
+  auto now = clock_type::now();
+  std::unique_lock<std::mutex> guard{mtx_};
+  shrink(now, capacity_ - 1);
+  auto key = key_of(msg);
+  auto seq = next_seq_++;
+  entries_.insert_or_assign(key, entry{msg, std::move(ctx), seq});
+  order_.emplace_back(insertion{key, seq, now});
+  size_ = entries_.size();
+}
+
+optional<trace_context> trace_table::take(const data_message& msg) {
+  std::unique_lock<std::mutex> guard{mtx_};
+  auto i = entries_.find(key_of(msg));
+  if (i == entries_.end())
+    return caf::none;
+  auto result = std::move(i->second.ctx);
+  entries_.erase(i);
+  size_ = entries_.size();
+  return result;
+}
+
+optional<trace_context> trace_table::find(const data_message& msg) {
+  auto now = clock_type::now();
+  std::unique_lock<std::mutex> guard{mtx_};
+  shrink(now, capacity_);
+  auto i = entries_.find(key_of(msg));
+  if (i == entries_.end())
+    return caf::none;
+  return i->second.ctx;
+}
+
+std::vector<std::pair<size_t, trace_context>>
+trace_table::find_all(const std::vector<data_message>& xs) {
+  std::vector<std::pair<size_t, trace_context>> result;
+  auto now = clock_type::now();
+  std::unique_lock<std::mutex> guard{mtx_};
+  shrink(now, capacity_);
+  for (size_t index = 0; index < xs.size(); ++index)
+    if (auto i = entries_.find(key_of(xs[index])); i != entries_.end())
+      result.emplace_back(index, i->second.ctx);
+  return result;
+}
+
+void trace_table::shrink(clock_type::time_point now, size_t max_size) {
+  auto drop_front = [this] {
+    auto& x = order_.front();
+    // Skip insertions of entries that were taken or overridden already.
+    if (auto i = entries_.find(x.key);
+        i != entries_.end() && i->second.seq == x.seq)
+      entries_.erase(i);
+    order_.pop_front();
+  };
+  while (!order_.empty() && now - order_.front().added >= max_age_)
+    drop_front();
+  while (entries_.size() > max_size)
+    drop_front();
+  // Stale insertions only pile up when `take` removes entries, i.e., the
+  // entries are already gone. Dropping them bounds the memory of the queue.
+  while (!order_.empty() && entries_.empty())
+    order_.pop_front();
+  size_ = entries_.size();
+}
+
+trace_table_ptr make_trace_table() {
+  return caf::make_counted<trace_table>();
+}
+
+} // namespace broker::detail
@@ -0,0 +1,202 @@
+#include "broker/detail/unix_socket.hh"
+
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <set>
+
+#include <caf/actor_cast.hpp>
+#include <caf/actor_system.hpp>
+#include <caf/io/basp_broker.hpp>
+#include <caf/io/doorman.hpp>
+#include <caf/io/middleman.hpp>
+#include <caf/io/network/native_socket.hpp>
+#include <caf/io/scribe.hpp>
+#include <caf/none.hpp>
+#include <caf/send.hpp>
+
+#include "broker/atoms.hh"
+#include "broker/config.hh"
+#include "broker/logger.hh"
+
+#ifndef BROKER_WINDOWS
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace broker::detail {
+
+namespace {
+
+#ifndef BROKER_WINDOWS
+
+using caf::io::network::native_socket;
+
+// Owns a socket until calling `release`.
+class socket_guard {
+public:
+  explicit socket_guard(native_socket fd) : fd_(fd) {
+    // nop
+  }
+
+  ~socket_guard() {
+    if (fd_ != -1)
+      ::close(fd_);
+  }
+
+  native_socket release() {
+    auto result = fd_;
+    fd_ = -1;
+    return result;
+  }
+
+private:
+  native_socket fd_;
+};
+
+bool make_address(const std::string& path, sockaddr_un& addr) {
+  if (path.empty() || path.size() >= sizeof(addr.sun_path))
+    return false;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  memcpy(addr.sun_path, path.c_str(), path.size());
+  return true;
+}
+
+// Removes the socket file at `path` unless another process still accepts
+// connections on it. Never removes files other than sockets.
+caf::error remove_stale_socket(const std::string& path) {
+  struct stat st;
+  if (::lstat(path.c_str(), &st) != 0)
+    return caf::none;
+  if (!S_ISSOCK(st.st_mode))
+    return caf::make_error(caf::sec::cannot_open_port,
+                           "path exists and is not a socket", path);
+  sockaddr_un addr;
+  make_address(path, addr);
+  auto fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd == -1)
+    return caf::make_error(caf::sec::cannot_open_port, strerror(errno));
+  socket_guard guard{fd};
+  if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0)
+    return caf::make_error(caf::sec::cannot_open_port,
+                           "socket is in use by another process", path);
+  if (errno != ECONNREFUSED)
+    return caf::make_error(caf::sec::cannot_open_port, strerror(errno), path);
+  BROKER_DEBUG("remove stale socket" << path);
+  ::unlink(path.c_str());
+  return caf::none;
+}
+
+// Binds `fd` to `addr` without granting access to other users at any time,
+// since connections via the socket bypass SSL. The umask applies to the
+// whole process, hence we serialize all calls.
+bool bind_private(native_socket fd, const sockaddr_un& addr) {
+  static std::mutex mtx;
+  std::lock_guard<std::mutex> guard{mtx};
+  auto old_mask = ::umask(S_IRWXG | S_IRWXO);
+  auto res = ::bind(fd, reinterpret_cast<const sockaddr*>(&addr),
+                    sizeof(addr));
+  auto bind_errno = errno;
+  ::umask(old_mask);
+  errno = bind_errno;
+  return res == 0;
+}
+
+#endif // BROKER_WINDOWS
+
+} // namespace
+
+caf::optional<std::string> unix_socket_path_of(const std::string& address) {
+  constexpr char scheme[] = "unix://";
+  constexpr size_t scheme_size = sizeof(scheme) - 1;
+  if (address.compare(0, scheme_size, scheme) != 0)
+    return caf::none;
+  return address.substr(scheme_size);
+}
+
+std::string unix_socket_path(const std::string& dir, uint16_t port) {
+  std::string result = dir;
+  if (!result.empty() && result.back() != '/')
+    result += '/';
+  result += "broker-";
+  result += std::to_string(port);
+  result += ".sock";
+  return result;
+}
+
+caf::actor basp_broker(caf::actor_system& sys) {
+#if CAF_VERSION < 1800
+  auto hdl = sys.middleman().named_broker<caf::io::basp_broker>(
+    caf::atom("BASP"));
+#else
+  auto hdl = sys.middleman().named_broker<caf::io::basp_broker>("BASP");
+#endif
+  return caf::actor_cast<caf::actor>(hdl);
+}
+
+#ifndef BROKER_WINDOWS
+
+caf::error publish_unix_socket(caf::actor_system& sys, const caf::actor& whom,
+                               const std::string& path) {
+  BROKER_TRACE(BROKER_ARG(path));
+  sockaddr_un addr;
+  if (!make_address(path, addr))
+    return caf::make_error(caf::sec::cannot_open_port,
+                           "invalid UNIX domain socket path", path);
+  auto fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd == -1)
+    return caf::make_error(caf::sec::cannot_open_port, strerror(errno));
+  socket_guard guard{fd};
+  if (auto err = remove_stale_socket(path))
+    return err;
+  if (!bind_private(fd, addr) || ::listen(fd, SOMAXCONN) != 0)
+    return caf::make_error(caf::sec::cannot_open_port, strerror(errno), path);
+  if (auto err = caf::io::network::nonblocking(fd, true))
+    return err;
+  auto& mm = sys.middleman();
+  auto ptr = mm.backend().new_doorman(guard.release());
+  caf::anon_send(basp_broker(sys), atom::publish_v, std::move(ptr),
+                 uint16_t{0}, caf::actor_cast<caf::strong_actor_ptr>(whom),
+                 std::set<std::string>{});
+  return caf::none;
+}
+
+caf::expected<caf::io::scribe_ptr>
+connect_unix_socket(caf::actor_system& sys, const std::string& path) {
+  BROKER_TRACE(BROKER_ARG(path));
+  sockaddr_un addr;
+  if (!make_address(path, addr))
+    return caf::make_error(caf::sec::cannot_connect_to_node,
+                           "invalid UNIX domain socket path", path);
+  auto fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd == -1)
+    return caf::make_error(caf::sec::cannot_connect_to_node, strerror(errno));
+  socket_guard guard{fd};
+  if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+    return caf::make_error(caf::sec::cannot_connect_to_node, strerror(errno),
+                           path);
+  if (auto err = caf::io::network::nonblocking(fd, true))
+    return err;
+  return sys.middleman().backend().new_scribe(guard.release());
+}
+
+#else // BROKER_WINDOWS
+
+caf::error publish_unix_socket(caf::actor_system&, const caf::actor&,
+                               const std::string&) {
+  return caf::make_error(caf::sec::cannot_open_port,
+                         "UNIX domain sockets are not available");
+}
+
+caf::expected<caf::io::scribe_ptr> connect_unix_socket(caf::actor_system&,
+                                                       const std::string&) {
+  return caf::make_error(caf::sec::cannot_connect_to_node,
+                         "UNIX domain sockets are not available");
+}
+
+#endif // BROKER_WINDOWS
+
+} // namespace broker::detail
@@ -1,5 +1,6 @@
+#include <algorithm>
+#include <cstdio>
 #include <iostream>
-#include <unordered_set>
 
 #include <caf/config.hpp>
 #include <caf/node_id.hpp>
@@ -17,6 +18,9 @@
 #include "broker/defaults.hh"
 #include "broker/detail/die.hh"
 #include "broker/detail/filesystem.hh"
+#include "broker/detail/probes.hh"
+#include "broker/detail/prometheus_actor.hh"
+#include "broker/detail/unix_socket.hh"
 #include "broker/endpoint.hh"
 #include "broker/fwd.hh"
 #include "broker/logger.hh"
@@ -57,39 +61,50 @@ void endpoint::clock::advance_time(timestamp t) {
 
   lock_type guard{mtx_};
 
-  auto it = pending_.begin();
-
-  if (it->first > t)
+  if (pending_.front().due > t)
     return;
 
   // Note: this function is performance-sensitive in the case of Zeek
-  // reading pcaps and it's important to not construct this set unless
+  // reading pcaps and it's important to not construct this vector unless
   // it's actually going to be used.
-  std::unordered_set<caf::actor> sync_with_actors;
-
-  while (it != pending_.end() && it->first <= t) {
-    auto& pm = it->second;
-    caf::anon_send(pm.first, std::move(pm.second));
-    sync_with_actors.emplace(pm.first);
-    it = pending_.erase(it);
+  std::vector<caf::actor> sync_with_actors;
+
+  pending_msg_order order;
+  while (!pending_.empty() && pending_.front().due <= t) {
+    std::pop_heap(pending_.begin(), pending_.end(), order);
+    auto& pm = pending_.back();
+    caf::anon_send(pm.dest, std::move(pm.msg));
+    sync_with_actors.emplace_back(std::move(pm.dest));
+    pending_.pop_back();
     --pending_count_;
   }
 
   guard.unlock();
 
+  std::sort(sync_with_actors.begin(), sync_with_actors.end());
+  sync_with_actors.erase(std::unique(sync_with_actors.begin(),
+                                     sync_with_actors.end()),
+                         sync_with_actors.end());
+
+  // Sync with all actors at once instead of waiting for each actor in turn.
   caf::scoped_actor self{*sys_};
-  for (auto& who : sync_with_actors) {
+  for (auto& who : sync_with_actors)
     self->send(who, atom::sync_point_v, self);
-    self->delayed_send(self, timeout::frontend, atom::tick_v);
+  self->delayed_send(self, timeout::frontend, atom::tick_v);
+  auto pending = sync_with_actors.size();
+  auto timed_out = false;
+  while (pending > 0 && !timed_out) {
     self->receive(
       [&](atom::sync_point) {
-        // nop
+        --pending;
       },
       [&](atom::tick) {
         BROKER_DEBUG("advance_time actor syncing timed out");
+        timed_out = true;
       },
       [&](caf::error& e) {
         BROKER_DEBUG("advance_time actor syncing failed");
+        --pending;
       }
     );
   }
@@ -108,7 +123,9 @@ void endpoint::clock::send_later(caf::actor dest, timespan after,
   }
   lock_type guard{mtx_};
   auto t = this->now() + after;
-  pending_.emplace(t, pending_msg_type{std::move(dest), std::move(msg)});
+  pending_.emplace_back(
+    pending_msg_type{t, seq_++, std::move(dest), std::move(msg)});
+  std::push_heap(pending_.begin(), pending_.end(), pending_msg_order{});
   ++pending_count_;
 }
 
@@ -195,7 +212,47 @@ endpoint::endpoint(configuration config)
   if (( !config_.options().disable_ssl) && !system_.has_openssl_manager())
       detail::die("CAF OpenSSL manager is not available");
   BROKER_INFO("creating endpoint");
-  core_ = system_.spawn(core_actor, filter_type{}, config_.options(), clock_);
+  metrics_ = detail::make_metric_registry();
+  core_ = system_.spawn(core_actor, filter_type{}, config_.options(), clock_,
+                        metrics_);
+  shards_.emplace_back(core_);
+  // Split the topic space across multiple cores if requested.
+  auto num_shards = get_or(config_, "broker.core-shards",
+                           defaults::core_shards);
+  if (num_shards > 1) {
+    BROKER_INFO("run" << num_shards << "core shards");
+    for (size_t shard = 1; shard < num_shards; ++shard)
+      shards_.emplace_back(system_.spawn(core_shard_actor, filter_type{},
+                                         config_.options(), clock_, metrics_,
+                                         shard));
+    for (auto& hdl : shards_)
+      caf::anon_send(hdl, atom::shard_v, shards_);
+  }
+  // Let cores write directly into subscriber queues if requested.
+  if (get_or(config_, "broker.local-fast-path", defaults::local_fast_path)) {
+    BROKER_INFO("enable fast path for local subscribers");
+    local_subscribers_ = detail::make_local_subscriber_table();
+    for (auto& hdl : shards_)
+      caf::anon_send(hdl, atom::local_v, local_subscribers_);
+  }
+  // Let workers and cores hand trace contexts to each other. Receiving traces
+  // from peers does not depend on our own sample rate.
+  if (get_or(config_, "broker.trace-sample-rate",
+             defaults::trace_sample_rate) > 0)
+    outbound_traces_ = detail::make_trace_table();
+  inbound_traces_ = detail::make_trace_table();
+  for (auto& hdl : shards_)
+    caf::anon_send(hdl, atom::trace_v, outbound_traces_, inbound_traces_);
+  // Serve metrics via HTTP if requested.
+  auto metrics_port = get_or(config_, "broker.metrics-port",
+                             defaults::metrics_port);
+  if (metrics_port > 0) {
+    auto addr = get_or(config_, "broker.metrics-address",
+                       defaults::metrics_address);
+    auto exporter = system_.middleman().spawn_broker(
+      detail::prometheus_actor, metrics_port, std::move(addr), metrics_, core_);
+    children_.emplace_back(std::move(exporter));
+  }
 }
 
 endpoint::~endpoint() {
@@ -226,9 +283,14 @@ void endpoint::shutdown() {
     children_.clear();
   }
   BROKER_DEBUG("send shutdown message to core actor");
-  anon_send(core_, atom::shutdown_v);
+  for (auto& hdl : shards_)
+    anon_send(hdl, atom::shutdown_v);
+  shards_.clear();
   core_ = nullptr;
   system_.~actor_system();
+  for (auto& path : unix_sockets_)
+    std::remove(path.c_str());
+  unix_sockets_.clear();
   delete clock_;
   clock_ = nullptr;
 }
@@ -246,6 +308,16 @@ uint16_t endpoint::listen(const std::string& address, uint16_t port) {
   return res ? *res : 0;
 }
 
+bool endpoint::listen_unix(const std::string& path) {
+  BROKER_INFO("listening on" << path << "(no SSL)");
+  if (auto err = detail::publish_unix_socket(system_, core(), path)) {
+    BROKER_ERROR("cannot listen on" << path << ":" << err);
+    return false;
+  }
+  unix_sockets_.emplace_back(path);
+  return true;
+}
+
 bool endpoint::peer(const std::string& address, uint16_t port,
                     timeout::seconds retry) {
   BROKER_TRACE(BROKER_ARG(address) << BROKER_ARG(port) << BROKER_ARG(retry));
@@ -320,6 +392,21 @@ std::vector<peer_info> endpoint::peers() const {
   return result;
 }
 
+table endpoint::metrics() const {
+  table result;
+  caf::scoped_actor self{system_};
+  self->request(core(), caf::infinite, atom::get_v, atom::metrics_v)
+  .receive(
+    [&](table& xs) {
+      result = std::move(xs);
+    },
+    [](const caf::error& e) {
+      detail::die("failed to get metrics:", to_string(e));
+    }
+  );
+  return result;
+}
+
 std::vector<topic> endpoint::peer_subscriptions() const {
   std::vector<topic> result;
   caf::scoped_actor self{system_};
@@ -339,12 +426,21 @@ std::vector<topic> endpoint::peer_subscriptions() const {
 void endpoint::forward(std::vector<topic> ts)
 {
   BROKER_INFO("forwarding topics" << ts);
-  caf::anon_send(core(), atom::subscribe_v, std::move(ts));
+  auto filters = detail::partition(ts, shards_.size());
+  for (size_t i = 0; i < shards_.size(); ++i)
+    if (!filters[i].empty())
+      caf::anon_send(shards_[i], atom::subscribe_v, std::move(filters[i]));
+}
+
+void endpoint::dump_recording() {
+  BROKER_INFO("dumping recorded messages");
+  caf::anon_send(core(), atom::dump_v);
 }
 
 void endpoint::publish(topic t, data d) {
   BROKER_INFO("publishing" << std::make_pair(t, d));
-  caf::anon_send(core(), atom::publish_v,
+  BROKER_PROBE2(publish, t.string().c_str(), 1);
+  caf::anon_send(core_for(t), atom::publish_v,
                  make_data_message(std::move(t), std::move(d)));
 }
 
@@ -356,7 +452,8 @@ void endpoint::publish(const endpoint_info& dst, topic t, data d) {
 
 void endpoint::publish(data_message x){
   BROKER_INFO("publishing" << x);
-  caf::anon_send(core(), atom::publish_v, std::move(x));
+  BROKER_PROBE2(publish, get_topic(x).string().c_str(), 1);
+  caf::anon_send(core_for(get_topic(x)), atom::publish_v, std::move(x));
 }
 
 
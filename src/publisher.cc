@@ -7,6 +7,10 @@
 #include <caf/send.hpp>
 
 #include "broker/data.hh"
+#include "broker/defaults.hh"
+#include "broker/detail/probes.hh"
+#include "broker/detail/trace_context.hh"
+#include "broker/detail/trace_table.hh"
 #include "broker/endpoint.hh"
 #include "broker/message.hh"
 #include "broker/topic.hh"
@@ -30,6 +34,9 @@ struct publisher_worker_state {
   size_t counter = 0;
   bool shutting_down = false;
 
+  /// Selects messages for tracing.
+  detail::trace_sampler tracer;
+
   static const char* name;
 
   void tick() {
@@ -51,19 +58,35 @@ struct publisher_worker_state {
 
 const char* publisher_worker_state::name = "publisher_worker";
 
+detail::shared_publisher_queue_ptr<> make_queue(endpoint& ep) {
+  auto result = detail::make_shared_publisher_queue(queue_size);
+  result->metrics(ep.metrics_registry(), "broker_publisher");
+  return result;
+}
+
 behavior publisher_worker(stateful_actor<publisher_worker_state>* self,
-                          endpoint* ep,
-                          detail::shared_publisher_queue_ptr<> qptr) {
+                          detail::shared_publisher_queue_ptr<> qptr,
+                          caf::actor core, detail::trace_table_ptr traces,
+                          size_t trace_sample_rate) {
+  self->state.tracer = detail::trace_sampler{trace_sample_rate};
   auto handler
     = attach_stream_source(
-        self, ep->core(),
+        self, core,
         [](unit_t&) {
           // nop
         },
         [=](unit_t&, downstream<data_message>& out, size_t num) {
           auto& st = self->state;
-          auto consumed = qptr->consume(
-            num, [&](data_message&& x) { out.push(std::move(x)); });
+          auto consumed = qptr->consume(num, [&](data_message&& x) {
+            // The core picks up the context when sending `x` to its peers.
+            if (traces != nullptr)
+              if (auto id = st.tracer.next(); id != 0) {
+                detail::trace_context ctx{id, {}};
+                ctx.add(detail::trace_hop::publisher_worker);
+                traces->put(x, std::move(ctx));
+              }
+            out.push(std::move(x));
+          });
           if (consumed > 0) {
             st.counter += consumed;
           }
@@ -98,8 +121,11 @@ behavior publisher_worker(stateful_actor<publisher_worker_state>* self,
 
 publisher::publisher(endpoint& ep, topic t)
   : drop_on_destruction_(false),
-    queue_(detail::make_shared_publisher_queue(queue_size)),
-    worker_(ep.system().spawn(publisher_worker, &ep, queue_)),
+    queue_(make_queue(ep)),
+    worker_(ep.system().spawn(
+      publisher_worker, queue_, ep.core_for(t), ep.outbound_traces(),
+      get_or(ep.config(), "broker.trace-sample-rate",
+             defaults::trace_sample_rate))),
     topic_(std::move(t)) {
   // nop
 }
@@ -140,6 +166,7 @@ void publisher::drop_all_on_destruction() {
 
 void publisher::publish(data x) {
   BROKER_INFO("publishing" << std::make_pair(topic_, x));
+  BROKER_PROBE2(publish, topic_.string().c_str(), 1);
   if (queue_->produce(topic_, std::move(x)))
     anon_send(worker_, atom::resume_v);
 }
@@ -156,6 +183,7 @@ void publisher::publish(std::vector<data> xs) {
       BROKER_INFO("publishing" << std::make_pair(topic_, *l));
     }
 #endif
+    BROKER_PROBE2(publish, topic_.string().c_str(), j - i);
     if (queue_->produce(topic_, i, j))
       anon_send(worker_, atom::resume_v);
     i = j;
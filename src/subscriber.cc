@@ -4,12 +4,16 @@
 #include <cstddef>
 #include <utility>
 #include <chrono>
+#include <memory>
 #include <numeric>
 
 #include <caf/scheduled_actor.hpp>
 #include <caf/send.hpp>
 
 #include "broker/atoms.hh"
+#include "broker/detail/core_shards.hh"
+#include "broker/detail/trace_context.hh"
+#include "broker/detail/trace_table.hh"
 #include "broker/endpoint.hh"
 #include "broker/filter_type.hh"
 #include "broker/logger.hh"
@@ -31,6 +35,16 @@ struct subscriber_worker_state {
 
   bool calculate_rate = true;
 
+  /// Stores the slot of our inbound path at each core.
+  std::vector<stream_slot> slots;
+
+  /// Counts cores that did not open their stream to this worker yet.
+  size_t pending_handshakes = 0;
+
+  /// Stores the number of produced messages at the last tick when running on
+  /// the fast path.
+  size_t last_total = 0;
+
   static const char* name;
 
   void tick() {
@@ -59,12 +73,13 @@ public:
   using queue_ptr = detail::shared_subscriber_queue_ptr<>;
 
   subscriber_sink(scheduled_actor* self, subscriber_worker_state* state,
-                  queue_ptr qptr, size_t max_qsize)
+                  queue_ptr qptr, size_t max_qsize, endpoint* ep)
     : stream_manager(self),
       super(self),
       state_(state),
       queue_(std::move(qptr)),
-      max_qsize_(max_qsize) {
+      max_qsize_(max_qsize),
+      ep_(ep) {
     // nop
   }
 
@@ -80,6 +95,8 @@ protected:
       auto& xs = x.xs.get_mutable_as<vec_type>(0);
       auto xs_size = xs.size();
       state_->counter += xs_size;
+      if (auto& traces = ep_->inbound_traces(); traces && !traces->empty())
+        publish_traces(*traces, xs);
       queue_->produce(xs_size, std::make_move_iterator(xs.begin()),
                       std::make_move_iterator(xs.end()));
       return;
@@ -88,22 +105,40 @@ protected:
   }
 
 private:
+  /// Adds our hop to the traces of messages in `xs` and publishes them again.
+  void publish_traces(detail::trace_table& traces,
+                      const std::vector<data_message>& xs) {
+    for (auto& [index, ctx] : traces.find_all(xs)) {
+      auto& t = get_topic(xs[index]);
+      ctx.add(detail::trace_hop::subscriber_sink);
+      anon_send(ep_->core_for(topics::traces), atom::publish_v, atom::local_v,
+                make_data_message(topics::traces, to_data(ctx, t)));
+    }
+  }
+
   subscriber_worker_state* state_;
   queue_ptr queue_;
   size_t max_qsize_;
+  endpoint* ep_;
 };
 
 behavior subscriber_worker(stateful_actor<subscriber_worker_state>* self,
                            endpoint* ep,
                            detail::shared_subscriber_queue_ptr<> qptr,
                            std::vector<topic> ts, size_t max_qsize) {
-  self->send(self * ep->core(), atom::join_v, std::move(ts));
+  // Each core of a sharded endpoint opens a stream for its part of the topics.
+  auto cores = ep->shards();
+  auto filters = detail::partition(ts, cores.size());
+  for (size_t i = 0; i < cores.size(); ++i)
+    self->send(self * cores[i], atom::join_v, std::move(filters[i]));
+  self->state.slots.resize(cores.size(), invalid_stream_slot);
+  self->state.pending_handshakes = cores.size();
   self->set_default_handler(skip);
+  BROKER_ASSERT(qptr != nullptr);
+  auto mgr = make_counted<subscriber_sink>(self, &self->state, qptr,
+                                           max_qsize, ep);
   return {
     [=](const endpoint::stream_type& in) {
-      BROKER_ASSERT(qptr != nullptr);
-      auto mgr = make_counted<subscriber_sink>(self, &self->state, qptr,
-                                               max_qsize);
       auto slot = mgr->add_unchecked_inbound_path(in);
       if (slot == invalid_stream_slot) {
         BROKER_WARNING("failed to init stream to subscriber_worker");
@@ -111,7 +146,12 @@ behavior subscriber_worker(stateful_actor<subscriber_worker_state>* self,
       }
       auto path = mgr->get_inbound_path(slot);
       BROKER_ASSERT(path != nullptr);
-      auto slot_at_sender = path->slots.sender;
+      auto& st = self->state;
+      for (size_t i = 0; i < cores.size(); ++i)
+        if (path->hdl == caf::actor_cast<strong_actor_ptr>(cores[i]))
+          st.slots[i] = path->slots.sender;
+      if (--st.pending_handshakes > 0)
+        return;
       self->set_default_handler(print_and_drop);
       self->delayed_send(self, std::chrono::seconds(1), atom::tick_v);
       self->become(
@@ -122,11 +162,23 @@ behavior subscriber_worker(stateful_actor<subscriber_worker_state>* self,
           // manager.
         },
         [=](atom::join a0, atom::update a1, filter_type& f) {
-          self->send(ep->core(), a0, a1, slot_at_sender, std::move(f));
+          auto& slots = self->state.slots;
+          auto fs = detail::partition(f, cores.size());
+          for (size_t i = 0; i < cores.size(); ++i)
+            self->send(cores[i], a0, a1, slots[i], std::move(fs[i]));
         },
         [=](atom::join a0, atom::update a1, filter_type& f, caf::actor& who) {
-          self->send(ep->core(), a0, a1, slot_at_sender, std::move(f),
-                     std::move(who));
+          // Confirm the update only after all cores applied it.
+          auto& slots = self->state.slots;
+          auto fs = detail::partition(f, cores.size());
+          auto pending = std::make_shared<size_t>(cores.size());
+          for (size_t i = 0; i < cores.size(); ++i)
+            self->request(cores[i], caf::infinite, a0, a1, slots[i],
+                          std::move(fs[i]))
+              .then([=] {
+                if (--*pending == 0)
+                  self->send(who, true);
+              });
         },
         [=](atom::tick) {
           auto& st = self->state;
@@ -150,16 +202,57 @@ behavior subscriber_worker(stateful_actor<subscriber_worker_state>* self,
   };
 }
 
+/// Computes the rate of a subscriber that receives its messages directly from
+/// the cores. Cores bypass this actor, so it only samples the queue.
+behavior fast_path_worker(stateful_actor<subscriber_worker_state>* self,
+                          detail::shared_subscriber_queue_ptr<> qptr) {
+  self->delayed_send(self, std::chrono::seconds(1), atom::tick_v);
+  return {
+    [=](atom::resume) {
+      // nop
+    },
+    [=](atom::tick) {
+      auto& st = self->state;
+      auto total = qptr->produced();
+      st.counter = total - st.last_total;
+      st.last_total = total;
+      st.tick();
+      qptr->rate(st.rate());
+      if (st.calculate_rate)
+        self->delayed_send(self, std::chrono::seconds(1), atom::tick_v);
+    },
+    [=](atom::tick, bool x) {
+      auto& st = self->state;
+      if (st.calculate_rate == x)
+        return;
+      st.calculate_rate = x;
+      if (x)
+        self->delayed_send(self, std::chrono::seconds(1), atom::tick_v);
+    },
+  };
+}
+
 } // namespace <anonymous>
 
 subscriber::subscriber(endpoint& e, std::vector<topic> ts, size_t max_qsize)
-  : super(max_qsize), ep_(e) {
+  : super(max_qsize), ep_(e), fast_path_(e.local_subscribers()) {
   BROKER_INFO("creating subscriber for topic(s)" << ts);
+  queue_->metrics(ep_.get().metrics_registry(), "broker_subscriber");
+  if (fast_path_) {
+    // Cores deliver into our queue directly, but still need to announce our
+    // topics to their peers.
+    fast_path_->add(queue_, ts, max_qsize);
+    ep_.get().forward(std::move(ts));
+    worker_ = ep_.get().system().spawn(fast_path_worker, queue_);
+    return;
+  }
   worker_ = ep_.get().system().spawn(subscriber_worker, &ep_.get(), queue_, std::move(ts),
                                max_qsize);
 }
 
 subscriber::~subscriber() {
+  if (fast_path_)
+    fast_path_->erase(queue_.get());
   anon_send_exit(worker_, exit_reason::user_shutdown);
 }
 
@@ -173,6 +266,11 @@ void subscriber::add_topic(topic x, bool block) {
   auto i = std::find(filter_.begin(), e, x);
   if (i == e) {
     filter_.emplace_back(std::move(x));
+    if (fast_path_) {
+      fast_path_->set_filter(queue_.get(), filter_);
+      ep_.get().forward(filter_);
+      return;
+    }
     if (block) {
       caf::scoped_actor self{ep_.get().system()};
       self->send(worker_, atom::join_v, atom::update_v, filter_, self);
@@ -189,6 +287,10 @@ void subscriber::remove_topic(topic x, bool block) {
   auto i = std::find(filter_.begin(), e, x);
   if (i != filter_.end()) {
     filter_.erase(i);
+    if (fast_path_) {
+      fast_path_->set_filter(queue_.get(), filter_);
+      return;
+    }
     if (block) {
       caf::scoped_actor self{ep_.get().system()};
       self->send(worker_, atom::join_v, atom::update_v, filter_, self);
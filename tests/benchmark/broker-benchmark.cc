@@ -34,6 +34,7 @@ double rate_increase_interval = 0;
 double rate_increase_amount = 0;
 uint64_t max_received = 0;
 uint64_t max_in_flight = 0;
+int num_topics = 1;
 bool server = false;
 bool verbose = false;
 
@@ -54,6 +55,22 @@ size_t reset_num_events() {
       return result;
 }
 
+// Returns the topic for the events of the i-th topic space. Each space has its
+// own top-level component, i.e., a sharded core handles the spaces in parallel.
+topic events_topic(int i) {
+  // The Zeek and Python scripts only use the first space.
+  if (i == 0)
+    return "/benchmark/events";
+  return "benchmark-" + std::to_string(i) + "/events";
+}
+
+std::vector<topic> events_topics() {
+  std::vector<topic> result;
+  for (int i = 0; i < num_topics; ++i)
+    result.emplace_back(events_topic(i));
+  return result;
+}
+
 double current_time() {
   using namespace std::chrono;
   auto t = system_clock::now();
@@ -243,15 +260,16 @@ void client_mode(endpoint& ep, const std::string& host, int port) {
     std::cout << "*** endpoint is now peering to remote" << std::endl;
   if (batch_rate == 0) {
     ep.publish_all(
-      [](caf::unit_t&) {},
-      [](caf::unit_t&, caf::downstream<data_message>& out, size_t hint) {
+      [](int& next_topic) { next_topic = 0; },
+      [](int& next_topic, caf::downstream<data_message>& out, size_t hint) {
       for (size_t i = 0; i < hint; ++i) {
       auto name = "event_" + std::to_string(event_type);
-      out.push(data_message{"/benchmark/events",
+      out.push(data_message{events_topic(next_topic),
                zeek::Event(std::move(name), createEventArgs())});
+      next_topic = (next_topic + 1) % num_topics;
       }
       },
-      [](const caf::unit_t&) { return false; }
+      [](const int&) { return false; }
       );
     for (;;) {
       // Print status events.
@@ -263,7 +281,9 @@ void client_mode(endpoint& ep, const std::string& host, int port) {
   // Publish one message per interval.
   using std::chrono::duration_cast;
   using fractional_second = std::chrono::duration<double>;
-  auto p = ep.make_publisher("/benchmark/events");
+  std::vector<publisher> ps;
+  for (int i = 0; i < num_topics; ++i)
+    ps.emplace_back(ep.make_publisher(events_topic(i)));
   fractional_second fractional_inc_interval{rate_increase_interval};
   auto inc_interval = duration_cast<timespan>(fractional_inc_interval);
   timestamp timeout = std::chrono::system_clock::now();
@@ -275,10 +295,12 @@ void client_mode(endpoint& ep, const std::string& host, int port) {
     timeout += interval;
     std::this_thread::sleep_until(timeout);
     // Ship some data.
-    if (p.free_capacity() > 1) {
-      send_batch(ep, p);
-    } else {
-      std::cout << "*** skip batch: publisher queue full" << std::endl;
+    for (auto& p : ps) {
+      if (p.free_capacity() > 1) {
+        send_batch(ep, p);
+      } else {
+        std::cout << "*** skip batch: publisher queue full" << std::endl;
+      }
     }
     // Increase batch size when reaching interval_timeout.
     if (rate_increase_interval > 0 && rate_increase_amount > 0) {
@@ -300,9 +322,9 @@ void client_mode(endpoint& ep, const std::string& host, int port) {
 void server_mode(endpoint& ep, const std::string& iface, int port) {
   // Make sure to receive status updates.
   auto ss = ep.make_status_subscriber(true);
-  // Subscribe to /benchmark/events.
+  // Subscribe to /benchmark/events and all additional topic spaces.
   ep.subscribe_nosync(
-    {"/benchmark/events"},
+    events_topics(),
     [](caf::unit_t&) {
       // nop
     },
@@ -379,6 +401,9 @@ struct config : configuration {
            "additional batch size per interval")
       .add(max_received, "max-received,m", "stop benchmark after given count")
       .add(max_in_flight, "max-in-flight,f", "report when exceeding this count")
+      .add(num_topics, "topics,n",
+           "number of independent topic spaces (default: 1), combine with "
+           "--broker.core-shards for parallel cores")
       .add(server, "server", "run in server mode")
       .add(verbose, "verbose", "enable status output");
   }
@@ -410,6 +435,11 @@ int main(int argc, char** argv) {
   }
   if (cfg.cli_helptext_printed)
     return EXIT_SUCCESS;
+  if (num_topics < 1) {
+    std::cerr << "*** invalid number of topics\n\n";
+    usage(cfg, argv[0]);
+    return EXIT_FAILURE;
+  }
   if (cfg.remainder.size() != 1) {
     std::cerr << "*** too many arguments\n\n";
     usage(cfg, argv[0]);
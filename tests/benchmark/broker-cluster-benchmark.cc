@@ -1,6 +1,12 @@
+#include <array>
 #include <atomic>
 #include <chrono>
+#include <cmath>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <map>
+#include <sstream>
 #include <string>
 #include <thread>
 
@@ -9,6 +15,10 @@
 #include "caf/attach_stream_sink.hpp"
 #include "caf/attach_stream_source.hpp"
 #include "caf/event_based_actor.hpp"
+#include "caf/io/broker.hpp"
+#include "caf/io/middleman.hpp"
+#include "caf/io/receive_policy.hpp"
+#include "caf/io/system_messages.hpp"
 #include "caf/settings.hpp"
 #include "caf/stateful_actor.hpp"
 #include "caf/string_algorithms.hpp"
@@ -17,8 +27,12 @@
 #include "broker/atoms.hh"
 #include "broker/detail/filesystem.hh"
 #include "broker/detail/generator_file_reader.hh"
+#include "broker/detail/parallel_generator_file_reader.hh"
+#include "broker/detail/unix_socket.hh"
 #include "broker/endpoint.hh"
+#include "broker/message.hh"
 #include "broker/subscriber.hh"
+#include "broker/time.hh"
 
 using caf::actor_system_config;
 using caf::expected;
@@ -173,10 +187,24 @@ struct config : actor_system_config {
                         "path to the cluster configuration file")
       .add<bool>("dump-stats", "prints stats for all given generator files")
       .add<bool>("verbose,v", "enable verbose output")
+      .add<bool>("latency,l",
+                 "measures end-to-end latency of data messages")
+      .add<std::string>("csv-file", "writes results to this CSV file")
+      .add<std::string>("json-file", "writes results to this JSON file")
       .add<bool>("generate-config",
                  "creates a config file from given recording directories")
       .add<string_list>("excluded-nodes,e",
-                        "excludes given nodes from the setup");
+                        "excludes given nodes from the setup")
+      .add<std::string>("unix-socket-dir",
+                        "peers via UNIX domain sockets in this directory "
+                        "instead of TCP")
+      .add<size_t>("core-shards",
+                   "number of core actors per node (default: 1)")
+      .add<caf::timespan>("link-delay",
+                          "delays all traffic between peers by this amount "
+                          "in each direction")
+      .add<std::string>("peer-stream-goal",
+                        "batching for peers: throughput, latency or adaptive");
     set("scheduler.max-threads", 1);
 #if CAF_VERSION < 1800
     set("logger.file-verbosity", caf::atom("quiet"));
@@ -198,6 +226,242 @@ using broker::detail::readlines;
 
 } // namespace
 
+// -- latency measurement ------------------------------------------------------
+
+namespace latency {
+
+namespace {
+
+/// Configures whether generators stamp data messages with the current time.
+/// Set once before spawning any node.
+bool is_enabled;
+
+} // namespace
+
+bool enabled() {
+  return is_enabled;
+}
+
+/// Wraps the content of a data message into a vector that additionally holds
+/// the current time. Command messages remain unchanged.
+void stamp(broker::node_message::value_type& x) {
+  if (auto dm = get_if<broker::data_message>(&x))
+    *dm = broker::make_data_message(get_topic(*dm),
+                                    broker::vector{broker::now(),
+                                                   get_data(*dm)});
+}
+
+/// Returns the time that passed since a generator stamped `x` or `none` if
+/// `x` carries no timestamp.
+caf::optional<broker::timespan> elapsed(const broker::data_message& x) {
+  auto xs = get_if<broker::vector>(&get_data(x));
+  if (xs == nullptr || xs->size() != 2)
+    return caf::none;
+  if (auto t = get_if<broker::timestamp>(&xs->front()))
+    return broker::now() - *t;
+  return caf::none;
+}
+
+} // namespace latency
+
+namespace unix_sockets {
+
+namespace {
+
+/// Configures where nodes place their UNIX domain sockets. Nodes peer via TCP
+/// if empty. Set once before spawning any node.
+std::string dir;
+
+} // namespace
+
+bool enabled() {
+  return !dir.empty();
+}
+
+/// Returns the socket path that replaces the TCP `port` of a node.
+std::string path_of(uint16_t port) {
+  return broker::detail::unix_socket_path(dir, port);
+}
+
+/// Returns the `unix://` address for peering with the node at `port`.
+std::string address_of(uint16_t port) {
+  return "unix://" + path_of(port);
+}
+
+} // namespace unix_sockets
+
+namespace shards {
+
+namespace {
+
+/// Configures how many cores split the topic space on each node. Set once
+/// before spawning any node.
+size_t count = 1;
+
+} // namespace
+
+} // namespace shards
+
+namespace links {
+
+namespace {
+
+/// Configures the one-way delay of simulated links between peers. Nodes
+/// connect to each other directly if 0. Set once before spawning any node.
+broker::timespan delay{0};
+
+/// Configures how nodes batch messages for their peers. Nodes use Broker's
+/// default if empty. Set once before spawning any node.
+std::string peer_stream_goal;
+
+using buffer_type = decltype(caf::io::new_data_msg::buf);
+
+// Forwards all traffic between `down` and the node at `host:port` with delay.
+caf::behavior delayed_connection(caf::io::broker* self,
+                                 caf::io::connection_handle down,
+                                 std::string host, uint16_t port) {
+  auto up = self->add_tcp_scribe(host, port);
+  if (!up) {
+    err::println("simulated link cannot connect to ", host, ":", port, ": ",
+                 to_string(up.error()));
+    self->quit(up.error());
+    return {};
+  }
+  for (auto hdl : {down, *up})
+    self->configure_read(hdl, caf::io::receive_policy::at_most(65536));
+  auto partner = [down, up = *up](caf::io::connection_handle hdl) {
+    return hdl == down ? up : down;
+  };
+  return {
+    [=](caf::io::new_data_msg& msg) {
+      self->delayed_send(self, delay, partner(msg.handle), std::move(msg.buf));
+    },
+    [=](caf::io::connection_handle hdl, buffer_type& buf) {
+      self->write(hdl, buf.size(), buf.data());
+      self->flush(hdl);
+    },
+    [=](const caf::io::connection_closed_msg&) {
+      // Deliver data that is still on the link before closing the other end.
+      self->delayed_send(self, delay, broker::atom::shutdown_v);
+    },
+    [=](broker::atom::shutdown) { self->quit(); },
+  };
+}
+
+caf::behavior delayed_link(caf::io::broker* self, std::string host,
+                           uint16_t port) {
+  return {
+    [=](const caf::io::new_connection_msg& msg) {
+      auto worker = self->fork(delayed_connection, msg.handle, host, port);
+      self->link_to(worker);
+    },
+  };
+}
+
+} // namespace
+
+bool enabled() {
+  return delay.count() > 0;
+}
+
+/// Starts a proxy in `sys` that simulates a link to the node at `host:port`.
+/// @returns the port of the proxy.
+caf::expected<uint16_t> simulate(caf::actor_system& sys, caf::actor& proxy,
+                                 const std::string& host, uint16_t port) {
+  uint16_t proxy_port = 0;
+  auto res = sys.middleman().spawn_server(delayed_link, proxy_port, host, port);
+  if (!res)
+    return std::move(res.error());
+  proxy = std::move(*res);
+  return proxy_port;
+}
+
+} // namespace links
+
+/// Counts latencies in nanoseconds with logarithmic buckets and linear
+/// sub-buckets, i.e., each bucket covers at most 1/32 of its lower bound.
+class latency_histogram {
+public:
+  static constexpr size_t sub_buckets = 64;
+
+  static constexpr size_t half_sub_buckets = sub_buckets / 2;
+
+  void add(broker::timespan x) {
+    auto ns = static_cast<uint64_t>(std::max(x.count(), int64_t{0}));
+    ++buckets_[index_of(ns)];
+    ++count_;
+    sum_ += ns;
+    max_ = std::max(max_, ns);
+  }
+
+  void add(const latency_histogram& other) {
+    for (size_t i = 0; i < buckets_.size(); ++i)
+      buckets_[i] += other.buckets_[i];
+    count_ += other.count_;
+    sum_ += other.sum_;
+    max_ = std::max(max_, other.max_);
+  }
+
+  size_t count() const noexcept {
+    return count_;
+  }
+
+  uint64_t max() const noexcept {
+    return max_;
+  }
+
+  uint64_t mean() const noexcept {
+    return count_ > 0 ? sum_ / count_ : 0;
+  }
+
+  /// Returns the highest value in the bucket that holds the `p`-th percentile
+  /// with `p` in the range `[0, 1]`.
+  uint64_t percentile(double p) const {
+    if (count_ == 0)
+      return 0;
+    auto rank = std::max(static_cast<size_t>(std::ceil(p * count_)), size_t{1});
+    size_t seen = 0;
+    for (size_t i = 0; i < buckets_.size(); ++i) {
+      seen += buckets_[i];
+      if (seen >= rank)
+        return std::min(upper_bound_of(i), max_);
+    }
+    return max_;
+  }
+
+private:
+  static size_t bit_width(uint64_t x) {
+    size_t result = 0;
+    for (; x != 0; x >>= 1)
+      ++result;
+    return result;
+  }
+
+  static size_t index_of(uint64_t x) {
+    auto bits = bit_width(x);
+    if (bits <= 6)
+      return x;
+    auto magnitude = bits - 6;
+    return magnitude * half_sub_buckets + (x >> magnitude);
+  }
+
+  static uint64_t upper_bound_of(size_t index) {
+    if (index < sub_buckets)
+      return index;
+    auto magnitude = index / half_sub_buckets - 1;
+    auto sub_bucket = index % half_sub_buckets + half_sub_buckets;
+    return ((sub_bucket + 1) << magnitude) - 1;
+  }
+
+  std::array<size_t, 59 * half_sub_buckets + half_sub_buckets> buckets_{};
+
+  size_t count_ = 0;
+
+  uint64_t sum_ = 0;
+
+  uint64_t max_ = 0;
+};
+
 // -- data structures for the cluster setup ------------------------------------
 
 using inputs_by_node_map = std::map<std::string, size_t>;
@@ -229,6 +493,19 @@ struct node {
   // we produce the number of messages in the generator file.
   caf::optional<size_t> num_outputs;
 
+  /// Optionally enables replay mode, in which the generator reproduces the
+  /// recorded inter-arrival times of all messages. The value scales the
+  /// original speed, i.e., 2.0 replays twice as fast as recorded.
+  caf::optional<double> replay_speed;
+
+  /// Optionally decodes the generator file on this many threads ahead of
+  /// time. Requires a generator file in version 2 of the file format.
+  size_t generator_threads = 0;
+
+  /// Optionally makes the generator reuse up to this many messages per topic
+  /// and shape of the data instead of synthesizing each message.
+  size_t generator_pool_size = 0;
+
   /// Stores parent nodes in the pub/sub topology.
   std::vector<node*> left;
 
@@ -242,6 +519,17 @@ struct node {
   /// Stores how many inputs we receive per node.
   inputs_by_node_map inputs_by_node;
 
+  /// Stores how long this node took for publishing all messages.
+  caf::optional<caf::timespan> sending_time;
+
+  /// Stores how long this node took for receiving all expected messages.
+  caf::optional<caf::timespan> receiving_time;
+
+  /// Stores the end-to-end latency of received data messages by topic when
+  /// measuring latency. Only the consumer writes to this map until it reports
+  /// that the node reached its limit.
+  std::map<broker::topic, latency_histogram> latencies;
+
 #if CAF_VERSION < 1800
   /// Stores the CAF log level for this node.
   caf::atom_value log_verbosity = caf::atom("quiet");
@@ -323,11 +611,17 @@ expected<node> make_node(const string& name, const caf::settings& parameters) {
   SET_FIELD(num_inputs, optional);
   SET_FIELD(forward, optional);
   SET_FIELD(num_outputs, optional);
+  SET_FIELD(replay_speed, optional);
+  SET_FIELD(generator_threads, optional);
+  SET_FIELD(generator_pool_size, optional);
   SET_FIELD(inputs_by_node, optional);
   SET_FIELD(log_verbosity, optional);
   if (!result.generator_file.empty() && !is_file(result.generator_file))
     return make_error(caf::sec::invalid_argument, result.name,
                       "generator file does not exist", result.generator_file);
+  if (result.replay_speed && *result.replay_speed <= 0)
+    return make_error(caf::sec::invalid_argument, result.name,
+                      "replay-speed must be positive");
   if (!result.inputs_by_node.empty()) {
     auto plus = [](size_t n, const inputs_by_node_map::value_type& kvp) {
       return n + kvp.second;
@@ -366,6 +660,9 @@ struct node_manager_state {
     opts.ignore_broker_conf = true; // Make sure no one messes with our setup.
     broker::configuration cfg{opts};
     cfg.set("middleman.workers", 0);
+    cfg.set("broker.core-shards", shards::count);
+    if (!links::peer_stream_goal.empty())
+      cfg.set("broker.peer-stream-goal", links::peer_stream_goal);
     cfg.set("logger.file-name", this_node->name + ".log");
     cfg.set("logger.file-verbosity", this_node->log_verbosity);
     new (&ep) broker::endpoint(std::move(cfg));
@@ -412,6 +709,8 @@ void generator(caf::stateful_actor<generator_state>* self, node* this_node,
             st.remaining = 0;
             return;
           }
+          if (latency::enabled())
+            latency::stamp(x);
           out.push(std::move(x));
         }
         st.remaining -= n;
@@ -449,6 +748,8 @@ void generator(caf::stateful_actor<generator_state>* self, node* this_node,
             st.gptr = nullptr;
             break;
           }
+          if (latency::enabled())
+            latency::stamp(x);
           out.push(std::move(x));
         }
         // Make some noise every 1k messages or when done.
@@ -461,16 +762,242 @@ void generator(caf::stateful_actor<generator_state>* self, node* this_node,
   }
 }
 
+struct parallel_generator_state {
+  broker::detail::parallel_generator_file_reader_ptr gptr;
+
+  /// Stores how many messages we still produce or `none` for a single pass.
+  caf::optional<size_t> remaining;
+
+  /// Stores the current batch of decoded messages.
+  broker::detail::parallel_generator_file_reader::batch buf;
+
+  /// Stores the position of the next message in `buf`.
+  size_t pos = 0;
+
+  size_t pushed = 0;
+
+  static const char* name;
+
+  bool done() const {
+    if (remaining)
+      return *remaining == 0;
+    return pos == buf.xs.size() && (gptr == nullptr || gptr->at_end());
+  }
+};
+
+const char* parallel_generator_state::name = "parallel_generator";
+
+void parallel_generator(caf::stateful_actor<parallel_generator_state>* self,
+                        node* this_node, caf::actor core,
+                        broker::detail::generator_file_reader_ptr ptr) {
+  using value_type = broker::node_message::value_type;
+  using broker::detail::parallel_generator_file_reader;
+  auto& st = self->state;
+  auto num_threads = this_node->generator_threads;
+  auto cycle = this_node->num_outputs != caf::none;
+  // Keep a few batches per thread in the pipeline to have all threads busy
+  // while the consumer drains a batch.
+  st.gptr.reset(new parallel_generator_file_reader(
+    std::move(ptr), num_threads, num_threads * 4, cycle));
+  st.remaining = this_node->num_outputs;
+  attach_stream_source(
+    self, core,
+    [](caf::unit_t&) {
+      // nop
+    },
+    [=](caf::unit_t&, caf::downstream<value_type>& out, size_t hint) {
+      auto& st = self->state;
+      size_t n = 0;
+      while (n < hint && !st.done()) {
+        if (st.pos == st.buf.xs.size()) {
+          st.pos = 0;
+          if (auto err = st.gptr->next(st.buf)) {
+            err::println("error while parsing ", this_node->generator_file,
+                         ": ", to_string(err));
+            st.buf.xs.clear();
+            st.gptr = nullptr;
+            st.remaining = 0;
+            break;
+          }
+          if (st.buf.xs.empty())
+            continue;
+        }
+        auto& x = st.buf.xs[st.pos++];
+        if (latency::enabled())
+          latency::stamp(x);
+        out.push(std::move(x));
+        if (st.remaining)
+          --*st.remaining;
+        ++n;
+      }
+      if (st.done() || st.pushed / 1000 != (st.pushed + n) / 1000)
+        verbose::println(this_node->name, " pushed ", st.pushed + n,
+                         " messages");
+      st.pushed += n;
+    },
+    [=](const caf::unit_t&) { return self->state.done(); });
+}
+
+struct replayer_state {
+  broker::detail::generator_file_reader_ptr gptr;
+
+  /// Stores how many messages we still produce or `none` for a single pass.
+  caf::optional<size_t> remaining;
+
+  /// Stores the next message. We read one message ahead in order to know when
+  /// it becomes due.
+  broker::node_message::value_type next;
+
+  /// Stores whether `next` holds a valid message.
+  bool has_next = false;
+
+  /// Stores the recorded timestamp of `next`, shifted by `offset`.
+  broker::timestamp next_time;
+
+  /// Stores the recorded timestamp of the first message.
+  broker::timestamp first_time;
+
+  /// Stores the recorded timestamp of the last message we have read.
+  broker::timestamp last_time;
+
+  /// Shifts recorded timestamps after rewinding the generator file.
+  broker::timespan offset{0};
+
+  /// Stores when we have started replaying.
+  std::chrono::steady_clock::time_point start;
+
+  size_t pushed = 0;
+
+  node* this_node = nullptr;
+
+  static const char* name;
+
+  void read_next() {
+    has_next = false;
+    if (gptr == nullptr || (remaining && *remaining == 0))
+      return;
+    if (gptr->at_end()) {
+      if (!remaining)
+        return;
+      gptr->rewind();
+      offset += last_time - first_time;
+    }
+    broker::timestamp t;
+    if (auto err = gptr->read(next, t)) {
+      err::println("error while parsing ", this_node->generator_file, ": ",
+                   to_string(err));
+      gptr = nullptr;
+      return;
+    }
+    last_time = t;
+    next_time = t + offset;
+    has_next = true;
+    if (remaining)
+      --*remaining;
+  }
+
+  /// Returns the point in time when `next` becomes due.
+  std::chrono::steady_clock::time_point due() const {
+    auto speed = *this_node->replay_speed;
+    fractional_seconds delay{next_time - first_time};
+    using clock_duration = std::chrono::steady_clock::duration;
+    return start + duration_cast<clock_duration>(delay / speed);
+  }
+};
+
+const char* replayer_state::name = "replayer";
+
+caf::behavior replayer(caf::stateful_actor<replayer_state>* self,
+                       node* this_node, caf::actor core,
+                       broker::detail::generator_file_reader_ptr ptr) {
+  using value_type = broker::node_message::value_type;
+  if (!ptr->timestamped())
+    warn::println(this_node->name, ": ", this_node->generator_file,
+                  " has no timestamps, replaying at full speed");
+  auto& st = self->state;
+  st.this_node = this_node;
+  st.gptr = std::move(ptr);
+  st.remaining = this_node->num_outputs;
+  st.read_next();
+  st.first_time = st.next_time;
+  st.start = std::chrono::steady_clock::now();
+  auto handler
+    = attach_stream_source(
+        self, core,
+        [](caf::unit_t&) {
+          // nop
+        },
+        [=](caf::unit_t&, caf::downstream<value_type>& out, size_t hint) {
+          auto& st = self->state;
+          auto now = std::chrono::steady_clock::now();
+          size_t n = 0;
+          for (; n < hint && st.has_next && st.due() <= now; ++n) {
+            if (latency::enabled())
+              latency::stamp(st.next);
+            out.push(std::move(st.next));
+            st.read_next();
+          }
+          if (!st.has_next || st.pushed / 1000 != (st.pushed + n) / 1000)
+            verbose::println(this_node->name, " pushed ", st.pushed + n,
+                             " messages");
+          st.pushed += n;
+        },
+        [=](const caf::unit_t&) { return !self->state.has_next; })
+        .ptr();
+  self->send(self, broker::atom::tick_v);
+  return {
+    [=](broker::atom::tick) {
+      auto& st = self->state;
+      auto pushed_before = st.pushed;
+      if (handler->generate_messages())
+        handler->push();
+      if (!st.has_next) {
+        // Terminate after the stream delivered all pending messages.
+        self->unbecome();
+        return;
+      }
+      // Wake up when the next message becomes due.
+      auto now = std::chrono::steady_clock::now();
+      auto delay = st.due() - now;
+      if (delay.count() <= 0) {
+        // An overdue message that we could not push means we ran out of
+        // credit. The stream pulls overdue messages as soon as new credit
+        // arrives, so we only back off instead of spinning on the tick.
+        if (st.pushed == pushed_before)
+          delay = std::chrono::milliseconds(1);
+        else
+          delay = std::chrono::steady_clock::duration{0};
+      }
+      self->delayed_send(self, delay, broker::atom::tick_v);
+    },
+  };
+}
+
 void run_send_mode(node_manager_actor* self, caf::actor observer) {
   auto this_node = self->state.this_node;
   verbose::println(this_node->name, " starts publishing");
   auto t0 = std::chrono::steady_clock::now();
-  auto g = self->spawn(generator, this_node, self->state.ep.core(),
-                       std::move(self->state.generator));
+  auto& gptr = self->state.generator;
+  auto core = self->state.ep.core();
+  if (this_node->generator_threads > 0 && gptr->version() < 2) {
+    warn::println(this_node->name, ": ", this_node->generator_file,
+                  " uses version 1 of the file format, ignoring "
+                  "generator-threads");
+    this_node->generator_threads = 0;
+  }
+  caf::actor g;
+  if (this_node->replay_speed)
+    g = self->spawn(replayer, this_node, core, std::move(gptr));
+  else if (this_node->generator_threads > 0)
+    g = self->spawn(parallel_generator, this_node, core, std::move(gptr));
+  else
+    g = self->spawn(generator, this_node, core, std::move(gptr));
   g->attach_functor([this_node, t0, observer]() mutable {
     auto t1 = std::chrono::steady_clock::now();
+    auto runtime = duration_cast<caf::timespan>(t1 - t0);
+    this_node->sending_time = runtime;
     anon_send(observer, broker::atom::ok_v, broker::atom::write_v,
-              this_node->name, duration_cast<caf::timespan>(t1 - t0));
+              this_node->name, runtime);
   });
 }
 
@@ -493,13 +1020,29 @@ struct consumer_state {
     auto limit = this_node->num_inputs;
     if (received < limit && received + n >= limit) {
       auto stop = std::chrono::steady_clock::now();
+      auto runtime = duration_cast<caf::timespan>(stop - start);
+      this_node->receiving_time = runtime;
       anon_send(observer, broker::atom::ok_v, broker::atom::read_v,
-                this_node->name, duration_cast<caf::timespan>(stop - start));
+                this_node->name, runtime);
       verbose::println(this_node->name, " reached its limit");
     }
     received += n;
   }
 
+  void record_latencies(const std::vector<broker::command_message>&) {
+    // Only data messages carry timestamps.
+  }
+
+  void record_latencies(const std::vector<broker::data_message>& xs) {
+    // Stop recording after reaching the limit, because the main thread reads
+    // the histograms after receiving our final report.
+    auto limit = this_node->num_inputs;
+    auto n = received < limit ? std::min(xs.size(), limit - received) : 0;
+    for (size_t i = 0; i < n; ++i)
+      if (auto dt = latency::elapsed(xs[i]))
+        this_node->latencies[get_topic(xs[i])].add(*dt);
+  }
+
   template <class T>
   void attach_sink(caf::stream<T> in, caf::actor observer) {
     if (++connected_streams == 2) {
@@ -511,7 +1054,11 @@ struct consumer_state {
       [](caf::unit_t&) {
         // nop
       },
-      [=](caf::unit_t&, std::vector<T>& xs) { handle_messages(xs.size()); },
+      [=](caf::unit_t&, std::vector<T>& xs) {
+        if (latency::enabled())
+          record_latencies(xs);
+        handle_messages(xs.size());
+      },
       [=](caf::unit_t&, const caf::error& err) {
 #if CAF_VERSION < 1800
         auto& types = self->system().types();
@@ -579,10 +1126,9 @@ void run_receive_mode(node_manager_actor* self, caf::actor observer) {
 }
 
 caf::error try_connect(broker::endpoint& ep, broker::status_subscriber& ss,
-                       const node* this_node, const node* peer) {
-  const auto& authority = peer->id.authority();
-  auto host = to_string(authority.host);
-  ep.peer(host, authority.port, broker::timeout::seconds(1));
+                       const node* this_node, const std::string& host,
+                       uint16_t port) {
+  ep.peer(host, port, broker::timeout::seconds(1));
   for (;;) {
     auto ss_res = ss.get();
     using namespace broker;
@@ -601,7 +1147,7 @@ caf::error try_connect(broker::endpoint& ep, broker::status_subscriber& ss,
     BROKER_ASSERT(code == sc::peer_added);
     if (auto ctx = ss_stat.context<endpoint_info>()) {
       auto& net = ctx->network;
-      if (net && net->address == host && net->port == authority.port)
+      if (net && net->address == host && net->port == port)
         return caf::none;
     }
   }
@@ -621,13 +1167,24 @@ caf::behavior node_manager(node_manager_actor* self, node* this_node) {
       auto& st = self->state;
       if (this_node->id.scheme() == "tcp") {
         auto& authority = this_node->id.authority();
-        verbose::println(this_node->name, " starts listening at ", authority);
-        auto port = st.ep.listen(to_string(authority.host), authority.port);
-        if (port != authority.port) {
-          err::println(this_node->name, " opened port ", port, " instead of ",
-                       authority.port);
-          return make_error(caf::sec::runtime_error, this_node->name,
-                            "listening failed");
+        if (unix_sockets::enabled()) {
+          auto path = unix_sockets::path_of(authority.port);
+          verbose::println(this_node->name, " starts listening at ", path);
+          if (!st.ep.listen_unix(path)) {
+            err::println(this_node->name, " cannot listen at ", path);
+            return make_error(caf::sec::runtime_error, this_node->name,
+                              "listening failed");
+          }
+        } else {
+          verbose::println(this_node->name, " starts listening at ",
+                           authority);
+          auto port = st.ep.listen(to_string(authority.host), authority.port);
+          if (port != authority.port) {
+            err::println(this_node->name, " opened port ", port,
+                         " instead of ", authority.port);
+            return make_error(caf::sec::runtime_error, this_node->name,
+                              "listening failed");
+          }
         }
       }
       // Connect to all peers and wait for handshake success.
@@ -636,10 +1193,31 @@ caf::behavior node_manager(node_manager_actor* self, node* this_node) {
         for (const auto* peer : this_node->right) {
           verbose::println(this_node->name, " starts peering to ",
                            peer->id.authority(), " (", peer->name, ")");
+          const auto& authority = peer->id.authority();
+          auto host = to_string(authority.host);
+          auto port = authority.port;
+          if (unix_sockets::enabled()) {
+            host = unix_sockets::address_of(port);
+            port = 0;
+          } else if (links::enabled()) {
+            caf::actor proxy;
+            auto proxy_port = links::simulate(st.ep.system(), proxy, host,
+                                              port);
+            if (!proxy_port) {
+              err::println(this_node->name,
+                           " cannot simulate a link to ", peer->name, ": ",
+                           to_string(proxy_port.error()));
+              return std::move(proxy_port.error());
+            }
+            verbose::println(this_node->name, " reaches ", peer->name,
+                             " via a simulated link on port ", *proxy_port);
+            st.children.emplace_back(std::move(proxy));
+            port = *proxy_port;
+          }
           // Try to connect up to 5 times per peer before giving up.
           auto connected = false;
           for (int i = 1; !connected && i <= 5; ++i) {
-            if (auto err = try_connect(st.ep, ss, this_node, peer)) {
+            if (auto err = try_connect(st.ep, ss, this_node, host, port)) {
               if (i == 5) {
                 err::println(this_node->name,
                              " received an error while trying to peer to ",
@@ -664,6 +1242,7 @@ caf::behavior node_manager(node_manager_actor* self, node* this_node) {
         if (st.generator == nullptr)
           return make_error(caf::sec::cannot_open_file,
                             this_node->generator_file);
+        st.generator->pool_size(this_node->generator_pool_size);
       }
       verbose::println(this_node->name, " up and running");
       return broker::atom::ok_v;
@@ -974,6 +1553,159 @@ int generate_config(std::vector<std::string> directories) {
   return EXIT_SUCCESS;
 }
 
+// -- reporting ----------------------------------------------------------------
+
+constexpr double reported_percentiles[] = {0.5, 0.9, 0.99, 0.999};
+
+constexpr const char* reported_percentile_names[] = {"p50", "p90", "p99",
+                                                     "p99.9"};
+
+/// Merges the latencies of all topics on `x`.
+latency_histogram total_latency(const node& x) {
+  latency_histogram result;
+  for (const auto& kvp : x.latencies)
+    result.add(kvp.second);
+  return result;
+}
+
+void print_latency(const string& label, const latency_histogram& x) {
+  std::ostringstream ostr;
+  for (size_t i = 0; i < std::size(reported_percentiles); ++i)
+    ostr << reported_percentile_names[i] << ' '
+         << x.percentile(reported_percentiles[i]) << "ns, ";
+  ostr << "max " << x.max() << "ns";
+  out::println(label, " (latency): ", ostr.str());
+}
+
+void print_latencies(const std::vector<node>& nodes) {
+  for (const auto& x : nodes) {
+    if (x.latencies.empty())
+      continue;
+    print_latency(x.name, total_latency(x));
+    for (const auto& [key, hist] : x.latencies)
+      print_latency(x.name + " " + key.string(), hist);
+  }
+}
+
+string csv_field(const string& str) {
+  if (str.find_first_of(",\"\n") == string::npos)
+    return str;
+  string result = "\"";
+  for (auto ch : str) {
+    if (ch == '"')
+      result += '"';
+    result += ch;
+  }
+  result += '"';
+  return result;
+}
+
+bool write_csv(const string& file_name, const std::vector<node>& nodes,
+               caf::timespan system_time) {
+  std::ofstream f{file_name};
+  if (!f) {
+    err::println("unable to open CSV file: ", file_name);
+    return false;
+  }
+  f << "kind,node,topic,seconds,count";
+  for (auto name : reported_percentile_names)
+    f << ',' << name << "_ns";
+  f << ",max_ns,mean_ns\n";
+  auto seconds = [](caf::timespan x) {
+    return duration_cast<fractional_seconds>(x).count();
+  };
+  auto latency_row = [&](const string& name, const string& topic_name,
+                         const latency_histogram& x) {
+    f << "latency," << csv_field(name) << ',' << csv_field(topic_name) << ",,"
+      << x.count();
+    for (auto p : reported_percentiles)
+      f << ',' << x.percentile(p);
+    f << ',' << x.max() << ',' << x.mean() << '\n';
+  };
+  f << "system,,," << seconds(system_time) << ",,,,,,,\n";
+  for (const auto& x : nodes) {
+    if (x.sending_time)
+      f << "sending," << csv_field(x.name) << ",," << seconds(*x.sending_time)
+        << ",,,,,,,\n";
+    if (x.receiving_time)
+      f << "receiving," << csv_field(x.name) << ",,"
+        << seconds(*x.receiving_time) << ',' << x.num_inputs << ",,,,,,\n";
+    if (!x.latencies.empty()) {
+      latency_row(x.name, "", total_latency(x));
+      for (const auto& [key, hist] : x.latencies)
+        latency_row(x.name, key.string(), hist);
+    }
+  }
+  return static_cast<bool>(f);
+}
+
+string json_string(const string& str) {
+  string result = "\"";
+  for (auto ch : str) {
+    switch (ch) {
+      case '"':
+        result += "\\\"";
+        break;
+      case '\\':
+        result += "\\\\";
+        break;
+      case '\n':
+        result += "\\n";
+        break;
+      default:
+        result += ch;
+    }
+  }
+  result += '"';
+  return result;
+}
+
+void write_json_latency(std::ostream& f, const latency_histogram& x) {
+  f << "{\"count\": " << x.count();
+  for (size_t i = 0; i < std::size(reported_percentiles); ++i)
+    f << ", \"" << reported_percentile_names[i]
+      << "_ns\": " << x.percentile(reported_percentiles[i]);
+  f << ", \"max_ns\": " << x.max() << ", \"mean_ns\": " << x.mean() << "}";
+}
+
+bool write_json(const string& file_name, const std::vector<node>& nodes,
+                caf::timespan system_time) {
+  std::ofstream f{file_name};
+  if (!f) {
+    err::println("unable to open JSON file: ", file_name);
+    return false;
+  }
+  auto seconds = [](const caf::optional<caf::timespan>& x) {
+    if (!x)
+      return string{"null"};
+    return std::to_string(duration_cast<fractional_seconds>(*x).count());
+  };
+  f << "{\n  \"system\": " << seconds(system_time) << ",\n  \"nodes\": [";
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    auto& x = nodes[i];
+    f << (i == 0 ? "\n" : ",\n") << "    {\"name\": " << json_string(x.name)
+      << ", \"sending\": " << seconds(x.sending_time)
+      << ", \"receiving\": " << seconds(x.receiving_time)
+      << ", \"num_inputs\": " << x.num_inputs;
+    if (!x.latencies.empty()) {
+      f << ",\n     \"latency\": ";
+      write_json_latency(f, total_latency(x));
+      f << ",\n     \"topics\": {";
+      auto first = true;
+      for (const auto& [key, hist] : x.latencies) {
+        f << (first ? "\n" : ",\n") << "       " << json_string(key.string())
+          << ": ";
+        write_json_latency(f, hist);
+        first = false;
+      }
+      f << "}";
+    }
+    f << "}";
+  }
+  f << "\n  ]\n}\n";
+  return static_cast<bool>(f);
+}
+
 // -- main ---------------------------------------------------------------------
 
 void print_peering_node(const std::string& prefix, const node& x, bool is_last,
@@ -1032,6 +1764,18 @@ int main(int argc, char** argv) {
   // Enable global flags.
   if (get_or(cfg, "verbose", false))
     verbose::is_enabled = true;
+  if (get_or(cfg, "latency", false))
+    latency::is_enabled = true;
+  if (auto dir = get_if<string>(&cfg, "unix-socket-dir"))
+    unix_sockets::dir = *dir;
+  shards::count = get_or(cfg, "core-shards", size_t{1});
+  links::delay = get_or(cfg, "link-delay", broker::timespan{0});
+  if (auto goal = get_if<string>(&cfg, "peer-stream-goal"))
+    links::peer_stream_goal = *goal;
+  if (links::enabled() && unix_sockets::enabled()) {
+    err::println("cannot simulate links for UNIX domain sockets");
+    return EXIT_FAILURE;
+  }
   // Generate config file when demanded.
   if (get_or(cfg, "generate-config", false))
     return generate_config(cfg.remainder);
@@ -1234,6 +1978,12 @@ int main(int argc, char** argv) {
       std::accumulate(nodes.begin(), nodes.end(), size_t{0}, ok_count));
     auto t1 = std::chrono::steady_clock::now();
     out::println("system: ", duration_cast<fractional_seconds>(t1 - t0));
+    print_latencies(nodes);
+    auto system_time = duration_cast<caf::timespan>(t1 - t0);
+    if (auto file_name = get_if<string>(&cfg, "csv-file"))
+      write_csv(*file_name, nodes, system_time);
+    if (auto file_name = get_if<string>(&cfg, "json-file"))
+      write_json(*file_name, nodes, system_time);
     // Shutdown all endpoints.
     verbose::println("shut down all nodes");
     for (auto& x : nodes)
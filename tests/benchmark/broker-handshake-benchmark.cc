@@ -0,0 +1,137 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "broker/configuration.hh"
+#include "broker/endpoint.hh"
+#include "broker/status.hh"
+#include "broker/status_subscriber.hh"
+
+using namespace broker;
+
+using caf::get_if;
+
+namespace {
+
+// -- CLI state ----------------------------------------------------------------
+
+size_t num_clients = 50;
+
+size_t num_rounds = 5;
+
+size_t threads_per_node = 2;
+
+bool disable_ssl = false;
+
+struct config : configuration {
+  using super = configuration;
+
+  config() : configuration(skip_init) {
+    opt_group{custom_options_, "global"}
+      .add(num_clients, "clients,c",
+           "endpoints that connect at once in each round (default: 50)")
+      .add(num_rounds, "rounds,r", "number of rounds (default: 5)")
+      .add(threads_per_node, "threads,t",
+           "scheduler threads per endpoint (default: 2)")
+      .add(disable_ssl, "disable-ssl",
+           "connects without SSL to measure the baseline");
+  }
+
+  using super::init;
+};
+
+// -- utility ------------------------------------------------------------------
+
+using clock_type = std::chrono::steady_clock;
+
+double to_ms(clock_type::duration x) {
+  return std::chrono::duration<double, std::milli>(x).count();
+}
+
+std::unique_ptr<endpoint> make_node() {
+  broker_options bopts;
+  bopts.disable_ssl = disable_ssl;
+  bopts.ignore_broker_conf = true;
+  configuration cfg{bopts};
+  cfg.set("scheduler.max-threads", threads_per_node);
+  return std::make_unique<endpoint>(std::move(cfg));
+}
+
+// Blocks until `ss` reported `n` new peers. Errors may stem from clients of
+// the previous round that shut down, so we only report them.
+void await_peers(status_subscriber& ss, size_t n) {
+  while (n > 0) {
+    auto x = ss.get();
+    if (auto err = get_if<error>(&x))
+      std::cerr << "*** " << to_string(*err) << std::endl;
+    else if (auto st = get_if<status>(&x); st && st->code() == sc::peer_added)
+      --n;
+  }
+}
+
+// -- reconnect storm ----------------------------------------------------------
+
+// Mimics a restarted Zeek manager: in each round, all clients connect to the
+// server at once. Since each client is a new endpoint, each connection
+// performs a full handshake.
+bool run_storms() {
+  auto server = make_node();
+  auto port = server->listen("127.0.0.1", 0);
+  if (port == 0) {
+    std::cerr << "*** server cannot listen" << std::endl;
+    return false;
+  }
+  auto ss = server->make_status_subscriber(true);
+  clock_type::duration total{0};
+  std::cout << "handshakes" << (disable_ssl ? " (no SSL)" : " (SSL)") << ":\n";
+  for (size_t round = 0; round < num_rounds; ++round) {
+    std::vector<std::unique_ptr<endpoint>> clients;
+    for (size_t i = 0; i < num_clients; ++i)
+      clients.emplace_back(make_node());
+    auto start = clock_type::now();
+    for (auto& client : clients)
+      client->peer_nosync("127.0.0.1", port, timeout::seconds(0));
+    await_peers(ss, num_clients);
+    auto elapsed = clock_type::now() - start;
+    total += elapsed;
+    std::cout << "  round " << round << ":       " << std::fixed
+              << std::setprecision(2) << to_ms(elapsed) << " ms\n";
+    for (auto& client : clients)
+      client->shutdown();
+  }
+  auto secs = std::chrono::duration<double>(total).count();
+  auto num_handshakes = num_clients * num_rounds;
+  std::cout << "  handshakes:    " << num_handshakes << '\n'
+            << "  elapsed:       " << std::fixed << std::setprecision(2)
+            << to_ms(total) << " ms\n"
+            << "  per-sec:       " << std::setprecision(0)
+            << (secs > 0 ? num_handshakes / secs : 0.0) << '\n';
+  server->shutdown();
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  config cfg;
+  try {
+    cfg.init(argc, argv);
+  } catch (std::exception& ex) {
+    std::cerr << ex.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (cfg.cli_helptext_printed)
+    return EXIT_SUCCESS;
+  if (num_clients == 0 || num_rounds == 0) {
+    std::cerr << "*** need at least one client and one round" << std::endl;
+    return EXIT_FAILURE;
+  }
+  return run_storms() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,171 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "broker/configuration.hh"
+#include "broker/endpoint.hh"
+#include "broker/status.hh"
+#include "broker/status_subscriber.hh"
+
+using namespace broker;
+
+using caf::get_if;
+
+namespace {
+
+// -- CLI state ----------------------------------------------------------------
+
+size_t num_nodes = 20;
+
+size_t connect_workers = 4;
+
+size_t threads_per_node = 2;
+
+bool star = false;
+
+struct config : configuration {
+  using super = configuration;
+
+  config() : configuration(skip_init) {
+    opt_group{custom_options_, "global"}
+      .add(num_nodes, "nodes,n", "number of endpoints (default: 20)")
+      .add(connect_workers, "connect-workers,w",
+           "threads per endpoint for establishing connections (default: 4)")
+      .add(threads_per_node, "threads,t",
+           "scheduler threads per endpoint (default: 2)")
+      .add(star, "star,s",
+           "peers the first endpoint with all others instead of a full mesh");
+  }
+
+  using super::init;
+};
+
+// -- utility ------------------------------------------------------------------
+
+using clock_type = std::chrono::steady_clock;
+
+double to_ms(clock_type::duration x) {
+  return std::chrono::duration<double, std::milli>(x).count();
+}
+
+std::unique_ptr<endpoint> make_node() {
+  broker_options bopts;
+  bopts.disable_ssl = true;
+  bopts.ignore_broker_conf = true;
+  configuration cfg{bopts};
+  cfg.set("broker.connect-workers", connect_workers);
+  cfg.set("scheduler.max-threads", threads_per_node);
+  return std::make_unique<endpoint>(std::move(cfg));
+}
+
+// Returns the indexes of all nodes that node `i` peers with.
+std::vector<size_t> targets_of(size_t i) {
+  std::vector<size_t> result;
+  if (star) {
+    if (i == 0)
+      for (size_t j = 1; j < num_nodes; ++j)
+        result.emplace_back(j);
+  } else {
+    for (size_t j = 0; j < i; ++j)
+      result.emplace_back(j);
+  }
+  return result;
+}
+
+// Returns how many peerings node `i` has in the final topology.
+size_t degree_of(size_t i) {
+  if (!star)
+    return num_nodes - 1;
+  return i == 0 ? num_nodes - 1 : 1;
+}
+
+// Blocks until `ss` reported `n` new peers.
+bool await_peers(status_subscriber& ss, size_t n) {
+  while (n > 0) {
+    auto x = ss.get();
+    if (auto err = get_if<error>(&x)) {
+      // Peers retry failed attempts, so only report the error.
+      std::cerr << "*** " << to_string(*err) << std::endl;
+    } else if (auto st = get_if<status>(&x)) {
+      if (st->code() == sc::peer_added) {
+        --n;
+      } else if (st->code() == sc::peer_lost
+                 || st->code() == sc::peer_removed) {
+        std::cerr << "*** lost a peer while setting up the cluster"
+                  << std::endl;
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// -- mesh setup ---------------------------------------------------------------
+
+// Measures the time from starting all peerings until each endpoint reported
+// all of its peers.
+bool run_setup() {
+  std::vector<std::unique_ptr<endpoint>> nodes;
+  std::vector<uint16_t> ports;
+  std::vector<status_subscriber> subscribers;
+  for (size_t i = 0; i < num_nodes; ++i) {
+    nodes.emplace_back(make_node());
+    auto port = nodes.back()->listen("127.0.0.1", 0);
+    if (port == 0) {
+      std::cerr << "*** endpoint " << i << " cannot listen" << std::endl;
+      return false;
+    }
+    ports.emplace_back(port);
+    subscribers.emplace_back(nodes.back()->make_status_subscriber(true));
+  }
+  size_t num_peerings = 0;
+  auto start = clock_type::now();
+  for (size_t i = 0; i < num_nodes; ++i) {
+    for (auto j : targets_of(i)) {
+      nodes[i]->peer_nosync("127.0.0.1", ports[j], timeout::seconds(1));
+      ++num_peerings;
+    }
+  }
+  for (size_t i = 0; i < num_nodes; ++i)
+    if (!await_peers(subscribers[i], degree_of(i)))
+      return false;
+  auto elapsed = clock_type::now() - start;
+  auto secs = std::chrono::duration<double>(elapsed).count();
+  std::cout << "setup:\n"
+            << "  nodes:         " << num_nodes << '\n'
+            << "  peerings:      " << num_peerings << '\n'
+            << "  elapsed:       " << std::fixed << std::setprecision(2)
+            << to_ms(elapsed) << " ms\n"
+            << "  peerings/sec:  " << std::setprecision(0)
+            << (secs > 0 ? num_peerings / secs : 0.0) << '\n';
+  subscribers.clear();
+  for (auto& node : nodes)
+    node->shutdown();
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  config cfg;
+  try {
+    cfg.init(argc, argv);
+  } catch (std::exception& ex) {
+    std::cerr << ex.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (cfg.cli_helptext_printed)
+    return EXIT_SUCCESS;
+  if (num_nodes < 2) {
+    std::cerr << "*** need at least two nodes" << std::endl;
+    return EXIT_FAILURE;
+  }
+  return run_setup() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,377 @@
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <caf/binary_deserializer.hpp>
+#include <caf/binary_serializer.hpp>
+
+#include "broker/backend.hh"
+#include "broker/backend_options.hh"
+#include "broker/config.hh"
+#include "broker/configuration.hh"
+#include "broker/data.hh"
+#include "broker/detail/abstract_backend.hh"
+#include "broker/detail/filesystem.hh"
+#include "broker/detail/flare.hh"
+#include "broker/detail/make_backend.hh"
+#include "broker/detail/prefix_matcher.hh"
+#include "broker/detail/shared_subscriber_queue.hh"
+#include "broker/endpoint.hh"
+#include "broker/filter_type.hh"
+#include "broker/logger.hh"
+#include "broker/message.hh"
+#include "broker/topic.hh"
+
+using namespace broker;
+
+namespace {
+
+// -- CLI state ----------------------------------------------------------------
+
+bool json = false;
+
+std::string filter;
+
+caf::timespan min_time = std::chrono::milliseconds(200);
+
+struct config : configuration {
+  using super = configuration;
+
+  config() : configuration(skip_init) {
+    opt_group{custom_options_, "global"}
+      .add(json, "json,j", "print results as JSON")
+      .add(filter, "filter,f", "only run benchmarks containing this string")
+      .add(min_time, "min-time,t",
+           "minimum run time per benchmark (default: 200ms)");
+  }
+
+  using super::init;
+};
+
+// -- benchmark harness --------------------------------------------------------
+
+/// Prevents the compiler from optimizing away computations that produce `x`.
+template <class T>
+void escape(const T& x) {
+  static volatile const void* ptr;
+  ptr = &x;
+}
+
+struct result {
+  std::string name;
+  size_t iterations;
+  double ns_per_op;
+};
+
+std::vector<result> results;
+
+/// Calls `f(n)` with growing `n` until a single call takes at least
+/// `min_time`, then records the time per operation of the last call.
+/// The function object `f` runs `n` operations per call.
+void run(std::string name, std::function<void(size_t)> f) {
+  if (!filter.empty() && name.find(filter) == std::string::npos)
+    return;
+  using clock = std::chrono::steady_clock;
+  size_t n = 1;
+  for (;;) {
+    auto t0 = clock::now();
+    f(n);
+    auto elapsed = clock::now() - t0;
+    if (elapsed >= min_time || n >= (size_t{1} << 40)) {
+      auto ns = std::chrono::duration<double, std::nano>(elapsed).count();
+      results.emplace_back(result{std::move(name), n, ns / n});
+      if (!json) {
+        auto& x = results.back();
+        std::cout << std::left << std::setw(40) << x.name << std::right
+                  << std::setw(14) << std::fixed << std::setprecision(2)
+                  << x.ns_per_op << " ns/op" << std::setw(14) << x.iterations
+                  << " iterations" << std::endl;
+      }
+      return;
+    }
+    n *= 2;
+  }
+}
+
+void print_json() {
+  std::cout << "{\n  \"benchmarks\": [";
+  for (size_t i = 0; i < results.size(); ++i) {
+    auto& x = results[i];
+    std::cout << (i == 0 ? "\n" : ",\n") << "    {\"name\": \"" << x.name
+              << "\", \"iterations\": " << x.iterations
+              << ", \"ns_per_op\": " << std::fixed << std::setprecision(2)
+              << x.ns_per_op << ", \"ops_per_sec\": " << std::setprecision(0)
+              << (x.ns_per_op > 0 ? 1e9 / x.ns_per_op : 0.0) << "}";
+  }
+  std::cout << "\n  ]\n}" << std::endl;
+}
+
+// -- test data ----------------------------------------------------------------
+
+address make_ipv4(uint32_t x) {
+  return address{&x, address::family::ipv4, address::byte_order::host};
+}
+
+/// Returns a value that resembles a Zeek log entry.
+data make_record() {
+  return vector{
+    timestamp{std::chrono::seconds(1577836800)},
+    "CWG8Ax2yEnYBnXoCYc",
+    make_ipv4(0xC0A8012A),
+    port{52321, port::protocol::tcp},
+    make_ipv4(0x0A000001),
+    port{443, port::protocol::tcp},
+    enum_value{"tcp"},
+    "ssl",
+    timespan{std::chrono::milliseconds(1234)},
+    count{4711},
+    count{65536},
+    "SF",
+    boolean{true},
+    set{"ShADadFf", "dns"},
+    table{{"orig_pkts", count{12}}, {"resp_pkts", count{21}}},
+  };
+}
+
+std::vector<topic> make_topics(size_t n) {
+  std::vector<topic> result;
+  for (size_t i = 0; i < n; ++i)
+    result.emplace_back("zeek/logs/stream-" + std::to_string(i) + "/entries");
+  return result;
+}
+
+// -- benchmarks ---------------------------------------------------------------
+
+void data_benchmarks() {
+  auto x = make_record();
+  caf::binary_serializer::container_type buf;
+  run("data/serialize", [&](size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+      buf.clear();
+      caf::binary_serializer sink{nullptr, buf};
+      escape(sink(x));
+    }
+  });
+  run("data/deserialize", [&](size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+      data y;
+      caf::binary_deserializer source{nullptr, buf};
+      escape(source(y));
+      escape(y);
+    }
+  });
+  run("data/hash", [&](size_t n) {
+    std::hash<data> h;
+    for (size_t i = 0; i < n; ++i)
+      escape(h(x));
+  });
+  run("data/copy", [&](size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+      auto y = x;
+      escape(y);
+    }
+  });
+}
+
+void topic_benchmarks() {
+  topic t{"zeek/logs/stream-42/entries"};
+  topic prefix{"zeek/logs"};
+  run("topic/split", [&](size_t n) {
+    for (size_t i = 0; i < n; ++i)
+      escape(topic::split(t));
+  });
+  auto components = topic::split(t);
+  run("topic/join", [&](size_t n) {
+    for (size_t i = 0; i < n; ++i)
+      escape(topic::join(components));
+  });
+  run("topic/prefix_of", [&](size_t n) {
+    for (size_t i = 0; i < n; ++i)
+      escape(prefix.prefix_of(t));
+  });
+  run("topic/concat", [&](size_t n) {
+    for (size_t i = 0; i < n; ++i)
+      escape(prefix / "stream-42");
+  });
+}
+
+void filter_benchmarks() {
+  auto topics = make_topics(64);
+  filter_type filter{topics.begin(), topics.begin() + 16};
+  detail::prefix_matcher matches;
+  topic hit{"zeek/logs/stream-7/entries/x"};
+  topic miss{"zeek/logs/stream-63/entries/x"};
+  run("prefix_matcher/hit", [&](size_t n) {
+    for (size_t i = 0; i < n; ++i)
+      escape(matches(filter, hit));
+  });
+  run("prefix_matcher/miss", [&](size_t n) {
+    for (size_t i = 0; i < n; ++i)
+      escape(matches(filter, miss));
+  });
+  run("filter_extend/64-topics", [&](size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+      filter_type f;
+      for (auto& x : topics)
+        filter_extend(f, x);
+      escape(f);
+    }
+  });
+}
+
+void queue_benchmarks() {
+  auto q = detail::make_shared_subscriber_queue();
+  auto msg = make_data_message("zeek/logs", make_record());
+  run("shared_subscriber_queue/single", [&](size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+      q->produce(msg);
+      q->consume(1, nullptr, [](data_message&& x) { escape(x); });
+    }
+  });
+  std::vector<data_message> batch(64, msg);
+  run("shared_subscriber_queue/batch-64", [&](size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+      q->produce(batch.size(), batch.begin(), batch.end());
+      escape(q->consume_all());
+    }
+  });
+  detail::flare fx;
+  run("flare/fire-extinguish", [&](size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+      fx.fire();
+      escape(fx.extinguish_one());
+    }
+  });
+}
+
+void log_benchmarks() {
+  // Measures the same statement as endpoint::publish. Depending on
+  // BROKER_LOG_LEVEL, the statement either compiles to nothing or performs
+  // a runtime check of the log level.
+  topic t{"zeek/logs"};
+  auto d = make_record();
+  run("log/info-statement", [&](size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+      BROKER_INFO("publishing" << std::make_pair(t, d));
+      escape(i);
+    }
+  });
+}
+
+void endpoint_benchmarks() {
+  broker_options opts;
+  opts.disable_ssl = true;
+  opts.ignore_broker_conf = true;
+  endpoint ep{configuration{opts}};
+  topic t{"zeek/logs"};
+  auto d = make_record();
+  run("endpoint/publish", [&](size_t n) {
+    for (size_t i = 0; i < n; ++i)
+      ep.publish(t, d);
+  });
+}
+
+void backend_benchmarks(const char* name, backend type) {
+  auto path = detail::make_temp_file_name();
+  backend_options opts{{"path", path}};
+  auto ptr = detail::make_backend(type, std::move(opts));
+  if (ptr == nullptr) {
+    std::cerr << "*** unable to create " << name << " backend\n";
+    return;
+  }
+  auto& be = *ptr;
+  // Operate on a fixed key space to keep the store size stable.
+  constexpr size_t num_keys = 1024;
+  std::vector<data> keys;
+  for (size_t i = 0; i < num_keys; ++i)
+    keys.emplace_back("key-" + std::to_string(i));
+  auto value = make_record();
+  auto prefix = std::string{"backend/"} + name + "/";
+  run(prefix + "put", [&](size_t n) {
+    for (size_t i = 0; i < n; ++i)
+      escape(be.put(keys[i % num_keys], value));
+  });
+  run(prefix + "get", [&](size_t n) {
+    for (size_t i = 0; i < n; ++i)
+      escape(be.get(keys[i % num_keys]));
+  });
+  run(prefix + "exists", [&](size_t n) {
+    for (size_t i = 0; i < n; ++i)
+      escape(be.exists(keys[i % num_keys]));
+  });
+  run(prefix + "erase", [&](size_t n) {
+    for (size_t i = 0; i < n; ++i)
+      escape(be.erase(keys[i % num_keys]));
+  });
+  run(prefix + "add", [&](size_t n) {
+    data one = count{1};
+    for (size_t i = 0; i < n; ++i)
+      escape(be.add(keys[i % num_keys], one, data::type::count));
+  });
+  run(prefix + "subtract", [&](size_t n) {
+    data one = count{1};
+    for (size_t i = 0; i < n; ++i)
+      escape(be.subtract(keys[i % num_keys], one));
+  });
+  run(prefix + "size", [&](size_t n) {
+    for (size_t i = 0; i < n; ++i)
+      escape(be.size());
+  });
+  run(prefix + "keys", [&](size_t n) {
+    for (size_t i = 0; i < n; ++i)
+      escape(be.keys());
+  });
+  run(prefix + "snapshot", [&](size_t n) {
+    for (size_t i = 0; i < n; ++i)
+      escape(be.snapshot());
+  });
+  run(prefix + "expiries", [&](size_t n) {
+    for (size_t i = 0; i < n; ++i)
+      escape(be.expiries());
+  });
+  run(prefix + "clear", [&](size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+      be.put(keys[i % num_keys], value);
+      escape(be.clear());
+    }
+  });
+  ptr.reset();
+  detail::remove_all(path);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  config cfg;
+  try {
+    cfg.init(argc, argv);
+  } catch (std::exception& ex) {
+    std::cerr << ex.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (cfg.cli_helptext_printed)
+    return EXIT_SUCCESS;
+  data_benchmarks();
+  topic_benchmarks();
+  filter_benchmarks();
+  queue_benchmarks();
+  log_benchmarks();
+  endpoint_benchmarks();
+  backend_benchmarks("memory", backend::memory);
+  backend_benchmarks("sqlite", backend::sqlite);
+#ifdef BROKER_HAVE_ROCKSDB
+  backend_benchmarks("rocksdb", backend::rocksdb);
+#endif
+  if (json)
+    print_json();
+  return EXIT_SUCCESS;
+}
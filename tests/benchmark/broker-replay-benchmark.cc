@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "broker/backend.hh"
+#include "broker/configuration.hh"
+#include "broker/data.hh"
+#include "broker/endpoint.hh"
+#include "broker/store.hh"
+
+using namespace broker;
+
+namespace {
+
+// -- CLI state ----------------------------------------------------------------
+
+size_t num_stores = 10;
+
+size_t num_packets = 100000;
+
+timespan packet_gap = std::chrono::milliseconds(1);
+
+timespan expiry = std::chrono::milliseconds(100);
+
+struct config : configuration {
+  using super = configuration;
+
+  config() : configuration(skip_init) {
+    opt_group{custom_options_, "global"}
+      .add(num_stores, "stores,s", "number of master stores (default: 10)")
+      .add(num_packets, "packets,n",
+           "number of simulated packets (default: 100000)")
+      .add(packet_gap, "packet-gap,g",
+           "simulated time between two packets (default: 1ms)")
+      .add(expiry, "expiry,e",
+           "expiry of each store entry (default: 100ms)");
+  }
+
+  using super::init;
+};
+
+// -- utility ------------------------------------------------------------------
+
+using clock_type = std::chrono::steady_clock;
+
+double to_ms(clock_type::duration x) {
+  return std::chrono::duration<double, std::milli>(x).count();
+}
+
+/// Prints summary statistics for a set of latency measurements in
+/// microseconds.
+void print_latencies(std::vector<clock_type::duration> xs) {
+  if (xs.empty())
+    return;
+  std::sort(xs.begin(), xs.end());
+  auto percentile = [&xs](double p) {
+    auto index = static_cast<size_t>(p * (xs.size() - 1));
+    return std::chrono::duration<double, std::micro>(xs[index]).count();
+  };
+  std::cout << std::fixed << std::setprecision(2)
+            << "  advance-p50:   " << percentile(0.5) << " us\n"
+            << "  advance-p90:   " << percentile(0.9) << " us\n"
+            << "  advance-p99:   " << percentile(0.99) << " us\n"
+            << "  advance-max:   " << percentile(1.0) << " us\n";
+}
+
+// -- replay -------------------------------------------------------------------
+
+// Mimics Zeek reading a pcap: each packet advances the simulated time and
+// writes an entry with expiry into one of the stores. Hence, most calls to
+// advance_time deliver expiration messages to the stores and then sync with
+// them.
+bool run_replay() {
+  broker_options bopts;
+  bopts.disable_ssl = true;
+  bopts.ignore_broker_conf = true;
+  bopts.use_real_time = false;
+  endpoint ep{configuration{bopts}};
+  auto t = timestamp{std::chrono::seconds(1)};
+  ep.advance_time(t);
+  std::vector<store> stores;
+  for (size_t i = 0; i < num_stores; ++i) {
+    auto st = ep.attach_master("replay-" + std::to_string(i), backend::memory);
+    if (!st) {
+      std::cerr << "*** unable to attach master: " << to_string(st.error())
+                << std::endl;
+      return false;
+    }
+    stores.emplace_back(std::move(*st));
+  }
+  std::cout << "replay:\n";
+  std::vector<clock_type::duration> latencies;
+  latencies.reserve(num_packets);
+  auto start = clock_type::now();
+  for (size_t i = 0; i < num_packets; ++i) {
+    t += packet_gap;
+    auto key = static_cast<count>(i);
+    stores[i % stores.size()].put(key, key, expiry);
+    auto t0 = clock_type::now();
+    ep.advance_time(t);
+    latencies.emplace_back(clock_type::now() - t0);
+  }
+  auto elapsed = clock_type::now() - start;
+  auto secs = std::chrono::duration<double>(elapsed).count();
+  std::cout << "  packets:       " << num_packets << '\n'
+            << "  elapsed:       " << std::fixed << std::setprecision(2)
+            << to_ms(elapsed) << " ms\n"
+            << "  pkts-per-sec:  " << std::setprecision(0)
+            << (secs > 0 ? num_packets / secs : 0.0) << '\n';
+  print_latencies(std::move(latencies));
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  config cfg;
+  try {
+    cfg.init(argc, argv);
+  } catch (std::exception& ex) {
+    std::cerr << ex.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (cfg.cli_helptext_printed)
+    return EXIT_SUCCESS;
+  if (num_stores == 0) {
+    std::cerr << "*** need at least one store" << std::endl;
+    return EXIT_FAILURE;
+  }
+  return run_replay() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,353 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <caf/send.hpp>
+
+#include "broker/atoms.hh"
+#include "broker/backend.hh"
+#include "broker/backend_options.hh"
+#include "broker/config.hh"
+#include "broker/configuration.hh"
+#include "broker/data.hh"
+#include "broker/detail/abstract_backend.hh"
+#include "broker/detail/filesystem.hh"
+#include "broker/detail/generator_file_reader.hh"
+#include "broker/detail/make_backend.hh"
+#include "broker/endpoint.hh"
+#include "broker/internal_command.hh"
+#include "broker/message.hh"
+#include "broker/store.hh"
+
+using namespace broker;
+
+namespace {
+
+// -- CLI state ----------------------------------------------------------------
+
+std::string generator_file;
+
+std::string backend_name = "memory";
+
+std::string backend_path;
+
+std::string mode = "both";
+
+size_t max_commands = 0;
+
+size_t sample_interval = 1000;
+
+struct config : configuration {
+  using super = configuration;
+
+  config() : configuration(skip_init) {
+    opt_group{custom_options_, "global"}
+      .add(generator_file, "generator-file,g",
+           "generator file with recorded store commands")
+      .add(backend_name, "backend,b",
+           "'memory' (default), 'sqlite', or 'rocksdb'")
+      .add(backend_path, "path,p",
+           "storage location for the backend (default: temporary file)")
+      .add(mode, "mode,m", "'direct', 'master', or 'both' (default)")
+      .add(max_commands, "max-commands,n",
+           "stops after this many commands (default: all)")
+      .add(sample_interval, "sample-interval,s",
+           "measures the round-trip time of every n-th request in master "
+           "mode (default: 1000)");
+  }
+
+  using super::init;
+};
+
+// -- utility ------------------------------------------------------------------
+
+using clock_type = std::chrono::steady_clock;
+
+double to_ms(clock_type::duration x) {
+  return std::chrono::duration<double, std::milli>(x).count();
+}
+
+/// Prints summary statistics for a set of latency measurements in
+/// microseconds.
+void print_latencies(std::vector<clock_type::duration> xs) {
+  if (xs.empty())
+    return;
+  std::sort(xs.begin(), xs.end());
+  auto percentile = [&xs](double p) {
+    auto index = static_cast<size_t>(p * (xs.size() - 1));
+    return std::chrono::duration<double, std::micro>(xs[index]).count();
+  };
+  std::cout << std::fixed << std::setprecision(2)
+            << "  latency-p50:   " << percentile(0.5) << " us\n"
+            << "  latency-p90:   " << percentile(0.9) << " us\n"
+            << "  latency-p99:   " << percentile(0.99) << " us\n"
+            << "  latency-p99.9: " << percentile(0.999) << " us\n"
+            << "  latency-max:   " << percentile(1.0) << " us\n";
+}
+
+void print_throughput(size_t n, clock_type::duration elapsed) {
+  auto secs = std::chrono::duration<double>(elapsed).count();
+  std::cout << "  commands:      " << n << '\n'
+            << "  elapsed:       " << std::fixed << std::setprecision(2)
+            << to_ms(elapsed) << " ms\n"
+            << "  ops-per-sec:   " << std::setprecision(0)
+            << (secs > 0 ? n / secs : 0.0) << '\n';
+}
+
+caf::optional<timestamp> to_expiry(const caf::optional<timespan>& x) {
+  if (x)
+    return broker::now() + *x;
+  return caf::none;
+}
+
+// -- loading commands ---------------------------------------------------------
+
+bool load_commands(std::vector<internal_command>& result) {
+  auto reader = detail::make_generator_file_reader(generator_file);
+  if (reader == nullptr) {
+    std::cerr << "*** unable to open generator file: " << generator_file
+              << std::endl;
+    return false;
+  }
+  detail::generator_file_reader::value_type x;
+  while (!reader->at_end()) {
+    if (auto err = reader->read(x)) {
+      std::cerr << "*** error while parsing " << generator_file << ": "
+                << to_string(err) << std::endl;
+      return false;
+    }
+    if (is_command_message(x)) {
+      result.emplace_back(get_command(caf::get<command_message>(x)));
+      if (result.size() == max_commands)
+        break;
+    }
+  }
+  return true;
+}
+
+// -- direct mode --------------------------------------------------------------
+
+/// Applies recorded commands to a backend, i.e., performs the same operations
+/// as a master would perform without any messaging overhead.
+struct direct_applier {
+  detail::abstract_backend& be;
+
+  template <class T>
+  bool operator()(const T&) {
+    // Nothing to do for none and snapshot_sync_command.
+    return true;
+  }
+
+  bool operator()(const put_command& x) {
+    return static_cast<bool>(be.put(x.key, x.value, to_expiry(x.expiry)));
+  }
+
+  bool operator()(const put_unique_command& x) {
+    auto exists = be.exists(x.key);
+    if (!exists)
+      return false;
+    if (*exists)
+      return true;
+    return static_cast<bool>(be.put(x.key, x.value, to_expiry(x.expiry)));
+  }
+
+  bool operator()(const erase_command& x) {
+    return static_cast<bool>(be.erase(x.key));
+  }
+
+  bool operator()(const add_command& x) {
+    return static_cast<bool>(
+      be.add(x.key, x.value, x.init_type, to_expiry(x.expiry)));
+  }
+
+  bool operator()(const subtract_command& x) {
+    return static_cast<bool>(be.subtract(x.key, x.value, to_expiry(x.expiry)));
+  }
+
+  bool operator()(const snapshot_command&) {
+    return static_cast<bool>(be.snapshot());
+  }
+
+  bool operator()(const set_command& x) {
+    if (!be.clear())
+      return false;
+    for (auto& kvp : x.state)
+      if (!be.put(kvp.first, kvp.second))
+        return false;
+    return true;
+  }
+
+  bool operator()(const clear_command&) {
+    return static_cast<bool>(be.clear());
+  }
+};
+
+bool run_direct(backend type, const std::string& path,
+                const std::vector<internal_command>& cmds) {
+  backend_options opts{{"path", path}};
+  std::cout << "direct " << backend_name << ":\n";
+  auto t0 = clock_type::now();
+  auto be = detail::make_backend(type, opts);
+  auto t1 = clock_type::now();
+  if (be == nullptr) {
+    std::cerr << "*** unable to create backend" << std::endl;
+    return false;
+  }
+  std::cout << "  open:          " << to_ms(t1 - t0) << " ms\n";
+  direct_applier f{*be};
+  std::vector<clock_type::duration> latencies;
+  latencies.reserve(cmds.size());
+  size_t failed = 0;
+  auto start = clock_type::now();
+  for (auto& cmd : cmds) {
+    auto op_start = clock_type::now();
+    if (!caf::visit(f, cmd.content))
+      ++failed;
+    latencies.emplace_back(clock_type::now() - op_start);
+  }
+  print_throughput(cmds.size(), clock_type::now() - start);
+  std::cout << "  failed:        " << failed << '\n';
+  print_latencies(std::move(latencies));
+  auto size = be->size();
+  std::cout << "  entries:       " << (size ? *size : 0) << '\n';
+  t0 = clock_type::now();
+  auto snapshot = be->snapshot();
+  t1 = clock_type::now();
+  if (!snapshot) {
+    std::cerr << "*** unable to take a snapshot: "
+              << to_string(snapshot.error()) << std::endl;
+    return false;
+  }
+  std::cout << "  snapshot:      " << to_ms(t1 - t0) << " ms\n";
+  // Reopen the backend to measure recovery times for persistent backends.
+  be = nullptr;
+  std::cout << "  disk-bytes:    " << detail::disk_usage(path) << '\n';
+  t0 = clock_type::now();
+  be = detail::make_backend(type, opts);
+  t1 = clock_type::now();
+  if (be == nullptr) {
+    std::cerr << "*** unable to reopen backend" << std::endl;
+    return false;
+  }
+  size = be->size();
+  std::cout << "  restart:       " << to_ms(t1 - t0) << " ms\n"
+            << "  restored:      " << (size ? *size : 0) << " entries\n";
+  return true;
+}
+
+// -- master mode --------------------------------------------------------------
+
+bool run_master(backend type, const std::string& path,
+                std::vector<internal_command> cmds) {
+  backend_options opts{{"path", path}};
+  std::cout << "master " << backend_name << ":\n";
+  broker_options bopts;
+  bopts.disable_ssl = true;
+  bopts.ignore_broker_conf = true;
+  endpoint ep{configuration{bopts}};
+  auto t0 = clock_type::now();
+  auto st = ep.attach_master("benchmark", type, opts);
+  auto t1 = clock_type::now();
+  if (!st) {
+    std::cerr << "*** unable to attach master: " << to_string(st.error())
+              << std::endl;
+    return false;
+  }
+  std::cout << "  open:          " << to_ms(t1 - t0) << " ms\n";
+  // Send all commands straight to the master like a store frontend would.
+  // Snapshot commands require a clone on the other end, so we skip them.
+  auto master = st->frontend();
+  std::vector<clock_type::duration> latencies;
+  size_t sent = 0;
+  data probe = "broker-store-benchmark";
+  auto start = clock_type::now();
+  for (auto& cmd : cmds) {
+    using tag = internal_command::type;
+    auto t = static_cast<tag>(cmd.content.index());
+    if (t == tag::none || t == tag::snapshot_command
+        || t == tag::snapshot_sync_command)
+      continue;
+    caf::anon_send(master, atom::local_v, std::move(cmd));
+    if (++sent % sample_interval == 0) {
+      // The round trip includes all commands that precede the request in
+      // the mailbox of the master.
+      auto t0 = clock_type::now();
+      st->exists(probe);
+      latencies.emplace_back(clock_type::now() - t0);
+    }
+  }
+  // The master processes messages in order, so the response to this request
+  // arrives after the master has processed all commands.
+  st->exists(probe);
+  print_throughput(sent, clock_type::now() - start);
+  std::cout << "  skipped:       " << (cmds.size() - sent) << '\n';
+  print_latencies(std::move(latencies));
+  auto keys = st->keys();
+  if (keys && is<set>(*keys))
+    std::cout << "  entries:       " << get<set>(*keys).size() << '\n';
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  config cfg;
+  try {
+    cfg.init(argc, argv);
+  } catch (std::exception& ex) {
+    std::cerr << ex.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (cfg.cli_helptext_printed)
+    return EXIT_SUCCESS;
+  if (generator_file.empty()) {
+    std::cerr << "*** no generator file specified" << std::endl;
+    return EXIT_FAILURE;
+  }
+  backend type;
+  if (backend_name == "memory") {
+    type = backend::memory;
+  } else if (backend_name == "sqlite") {
+    type = backend::sqlite;
+  } else if (backend_name == "rocksdb") {
+    type = backend::rocksdb;
+  } else {
+    std::cerr << "*** invalid backend: " << backend_name << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (mode != "direct" && mode != "master" && mode != "both") {
+    std::cerr << "*** invalid mode: " << mode << std::endl;
+    return EXIT_FAILURE;
+  }
+  sample_interval = std::max(sample_interval, size_t{1});
+  std::vector<internal_command> cmds;
+  if (!load_commands(cmds))
+    return EXIT_FAILURE;
+  if (cmds.empty()) {
+    std::cerr << "*** no store commands in " << generator_file << std::endl;
+    return EXIT_FAILURE;
+  }
+  auto path = backend_path.empty() ? detail::make_temp_file_name()
+                                   : backend_path;
+  // Each run starts with empty storage.
+  auto ok = true;
+  if (mode != "master") {
+    detail::remove_all(path);
+    ok = run_direct(type, path, cmds);
+  }
+  if (ok && mode != "direct") {
+    detail::remove_all(path);
+    ok = run_master(type, path, cmds);
+  }
+  detail::remove_all(path);
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
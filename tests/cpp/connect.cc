@@ -0,0 +1,117 @@
+// This suite checks how endpoints establish connections to peers. Unlike the
+// integration suite, it uses real sockets, because the helper threads for
+// connecting bypass CAF's test multiplexer.
+#define SUITE connect
+
+#include "test.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "broker/configuration.hh"
+#include "broker/endpoint.hh"
+#include "broker/error.hh"
+#include "broker/status.hh"
+#include "broker/status_subscriber.hh"
+
+using namespace broker;
+
+namespace {
+
+using namespace std::chrono_literals;
+
+configuration make_config() {
+  broker_options options;
+  options.disable_ssl = true;
+  options.ignore_broker_conf = true;
+  configuration cfg{options};
+  cfg.set("logger.inline-output", true);
+  cfg.set("broker.connect-workers", size_t{2});
+  cfg.set("broker.max-retry-interval", timespan{2s});
+  return cfg;
+}
+
+struct fixture {
+  // Summarizes the events of a status subscriber.
+  struct event_counts {
+    size_t added = 0;
+    size_t unavailable = 0;
+  };
+
+  std::unique_ptr<endpoint> make_node() {
+    return std::make_unique<endpoint>(make_config());
+  }
+
+  // Returns a port that no endpoint listens on.
+  uint16_t unused_port() {
+    auto tmp = make_node();
+    auto port = tmp->listen("127.0.0.1", 0);
+    tmp->shutdown();
+    return port;
+  }
+
+  // Collects events until `ss` reported `n` new peers or `timeout` expired.
+  event_counts await_peers(status_subscriber& ss, size_t n, timespan timeout) {
+    event_counts result;
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (result.added < n && std::chrono::steady_clock::now() < deadline) {
+      auto x = ss.get(100ms);
+      if (auto st = caf::get_if<status>(&x); st && st->code() == sc::peer_added)
+        ++result.added;
+      else if (auto err = caf::get_if<error>(&x);
+               err && err->code() == static_cast<uint8_t>(ec::peer_unavailable))
+        ++result.unavailable;
+    }
+    return result;
+  }
+};
+
+} // namespace
+
+CAF_TEST_FIXTURE_SCOPE(connect_tests, fixture)
+
+CAF_TEST(helper threads connect to multiple peers at once) {
+  auto origin = make_node();
+  auto ss = origin->make_status_subscriber(true);
+  std::vector<std::unique_ptr<endpoint>> targets;
+  std::vector<uint16_t> ports;
+  for (size_t i = 0; i < 4; ++i) {
+    targets.emplace_back(make_node());
+    ports.emplace_back(targets.back()->listen("127.0.0.1", 0));
+    REQUIRE_NOT_EQUAL(ports.back(), 0u);
+  }
+  MESSAGE("peer with all targets and one unreachable port");
+  origin->peer_nosync("127.0.0.1", unused_port(), timeout::seconds(0));
+  for (auto port : ports)
+    origin->peer_nosync("127.0.0.1", port, timeout::seconds(0));
+  auto counts = await_peers(ss, ports.size(), 10s);
+  CHECK_EQUAL(counts.added, ports.size());
+  CHECK_EQUAL(origin->peers().size(), ports.size());
+  origin->shutdown();
+  for (auto& target : targets)
+    target->shutdown();
+}
+
+CAF_TEST(peers retry with backoff until the remote side listens) {
+  auto port = unused_port();
+  REQUIRE_NOT_EQUAL(port, 0u);
+  auto origin = make_node();
+  auto ss = origin->make_status_subscriber(true);
+  origin->peer_nosync("127.0.0.1", port, timeout::seconds(1));
+  MESSAGE("wait for at least one failed attempt");
+  std::this_thread::sleep_for(1500ms);
+  auto target = make_node();
+  REQUIRE_EQUAL(target->listen("127.0.0.1", port), port);
+  auto counts = await_peers(ss, 1, 10s);
+  CHECK_EQUAL(counts.added, 1u);
+  CHECK_GREATER_EQUAL(counts.unavailable, 1u);
+  origin->shutdown();
+  target->shutdown();
+}
+
+CAF_TEST_FIXTURE_SCOPE_END()
@@ -9,6 +9,7 @@
 #include <caf/test/io_dsl.hpp>
 
 #include "broker/configuration.hh"
+#include "broker/detail/filesystem.hh"
 #include "broker/endpoint.hh"
 #include "broker/logger.hh"
 
@@ -123,6 +124,87 @@ struct fixture : test_coordinator_fixture<config> {
   }
 };
 
+// Keeps up to 100 messages in memory for disconnected peers.
+struct spool_config : config {
+  spool_config() {
+    set("broker.peer-spool-size", size_t{100});
+  }
+};
+
+// Keeps 2 messages in memory and up to 100 more on disk for disconnected
+// peers.
+struct disk_spool_config : config {
+  std::string dir = detail::make_temp_file_name();
+
+  disk_spool_config() {
+    set("broker.peer-spool-size", size_t{2});
+    set("broker.peer-spool-disk-size", size_t{100});
+    set("broker.peer-spool-directory", dir);
+  }
+
+  ~disk_spool_config() {
+    detail::remove_all(dir);
+  }
+};
+
+template <class Config>
+struct spool_fixture : test_coordinator_fixture<Config> {
+  spool_fixture() {
+    base_fixture::init_socket_api();
+  }
+
+  ~spool_fixture() {
+    base_fixture::deinit_socket_api();
+  }
+
+  // Disconnects a peer while the driver publishes and then checks whether a
+  // core with the same node ID receives all messages after re-peering. All
+  // cores of a single actor system share the same node ID.
+  void check_replay() {
+    auto& sys = this->sys;
+    auto& self = this->self;
+    broker_options options;
+    options.disable_ssl = true;
+    auto spawn_core = [&] {
+      auto hdl = sys.spawn(core_actor, filter_type{"a", "b", "c"}, options,
+                           nullptr, nullptr);
+      anon_send(hdl, atom::no_events_v);
+      return hdl;
+    };
+    auto core1 = spawn_core();
+    auto core2 = spawn_core();
+    this->run();
+    CAF_MESSAGE("peer core1 with core2");
+    self->send(core1, atom::peer_v, core2);
+    this->run();
+    CAF_MESSAGE("kill core2 and publish while it is gone");
+    anon_send_exit(core2, caf::exit_reason::user_shutdown);
+    this->run();
+    auto d1 = sys.spawn(driver, core1, false);
+    this->run();
+    CAF_MESSAGE("re-peer core1 with core3 on the same node");
+    auto core3 = spawn_core();
+    auto leaf = sys.spawn(consumer, filter_type{"b"}, core3);
+    this->run();
+    self->send(core1, atom::peer_v, core3);
+    this->run();
+    CAF_MESSAGE("check that core3 received the spooled messages in order");
+    this->sched.inline_next_enqueue();
+    self->request(leaf, caf::infinite, atom::get_v)
+      .receive(
+        [&](const std::vector<element_type>& xs) {
+          auto expected = data_msgs({{"b", true}, {"b", false},
+                                     {"b", true}, {"b", false}});
+          CAF_CHECK_EQUAL(xs, expected);
+        },
+        [&](const error& err) { CAF_FAIL(err); });
+    anon_send_exit(core1, caf::exit_reason::user_shutdown);
+    anon_send_exit(core3, caf::exit_reason::user_shutdown);
+    anon_send_exit(leaf, caf::exit_reason::user_shutdown);
+    this->run();
+  }
+};
+
 } // namespace <anonymous>
 
 CAF_TEST_FIXTURE_SCOPE(local_tests, fixture)
@@ -133,8 +215,8 @@ CAF_TEST(local_peers) {
   // Spawn core actors and disable events.
   broker_options options;
   options.disable_ssl = true;
-  auto core1 = sys.spawn(core_actor, filter_type{"a", "b", "c"}, options, nullptr);
-  auto core2 = sys.spawn(core_actor, filter_type{"a", "b", "c"}, options, nullptr);
+  auto core1 = sys.spawn(core_actor, filter_type{"a", "b", "c"}, options, nullptr, nullptr);
+  auto core2 = sys.spawn(core_actor, filter_type{"a", "b", "c"}, options, nullptr, nullptr);
   anon_send(core1, atom::no_events_v);
   anon_send(core2, atom::no_events_v);
   run();
@@ -247,9 +329,9 @@ CAF_TEST(triangle_peering) {
   // Spawn core actors and disable events.
   broker_options options;
   options.disable_ssl = true;
-  auto core1 = sys.spawn(core_actor, filter_type{"a", "b", "c"}, options, nullptr);
-  auto core2 = sys.spawn(core_actor, filter_type{"a", "b", "c"}, options, nullptr);
-  auto core3 = sys.spawn(core_actor, filter_type{"a", "b", "c"}, options, nullptr);
+  auto core1 = sys.spawn(core_actor, filter_type{"a", "b", "c"}, options, nullptr, nullptr);
+  auto core2 = sys.spawn(core_actor, filter_type{"a", "b", "c"}, options, nullptr, nullptr);
+  auto core3 = sys.spawn(core_actor, filter_type{"a", "b", "c"}, options, nullptr, nullptr);
   anon_send(core1, atom::no_events_v);
   anon_send(core2, atom::no_events_v);
   anon_send(core3, atom::no_events_v);
@@ -367,9 +449,9 @@ CAF_TEST(sequenced_peering) {
   // Spawn core actors and disable events.
   broker_options options;
   options.disable_ssl = true;
-  auto core1 = sys.spawn(core_actor, filter_type{"a", "b", "c"}, options, nullptr);
-  auto core2 = sys.spawn(core_actor, filter_type{"a", "b", "c"}, options, nullptr);
-  auto core3 = sys.spawn(core_actor, filter_type{"a", "b", "c"}, options, nullptr);
+  auto core1 = sys.spawn(core_actor, filter_type{"a", "b", "c"}, options, nullptr, nullptr);
+  auto core2 = sys.spawn(core_actor, filter_type{"a", "b", "c"}, options, nullptr, nullptr);
+  auto core3 = sys.spawn(core_actor, filter_type{"a", "b", "c"}, options, nullptr, nullptr);
   CAF_MESSAGE(BROKER_ARG(core1));
   CAF_MESSAGE(BROKER_ARG(core2));
   CAF_MESSAGE(BROKER_ARG(core3));
@@ -474,7 +556,7 @@ struct error_signaling_fixture : base_fixture {
     CAF_MESSAGE(BROKER_ARG(core1));
     anon_send(core1, atom::subscribe_v, filter_type{"a", "b", "c"});
     core2 = sys.spawn(core_actor, filter_type{"a", "b", "c"},
-                      ep.config().options(), nullptr);
+                      ep.config().options(), nullptr, nullptr);
     CAF_MESSAGE(BROKER_ARG(core2));
     run();
     CAF_MESSAGE("init done");
@@ -741,3 +823,19 @@ CAF_TEST(remote_peers_setup2) {
 }
 
 CAF_TEST_FIXTURE_SCOPE_END()
+
+CAF_TEST_FIXTURE_SCOPE(spooling, spool_fixture<spool_config>)
+
+CAF_TEST(returning_peers_receive_spooled_messages) {
+  check_replay();
+}
+
+CAF_TEST_FIXTURE_SCOPE_END()
+
+CAF_TEST_FIXTURE_SCOPE(disk_spooling, spool_fixture<disk_spool_config>)
+
+CAF_TEST(returning_peers_receive_spooled_messages_from_disk) {
+  check_replay();
+}
+
+CAF_TEST_FIXTURE_SCOPE_END()
@@ -0,0 +1,101 @@
+#define SUITE async_generator_file_writer
+
+#include "broker/detail/async_generator_file_writer.hh"
+
+#include "test.hh"
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "broker/detail/filesystem.hh"
+#include "broker/detail/generator_file_reader.hh"
+
+using namespace broker;
+
+namespace {
+
+struct fixture {
+  fixture() {
+    file_name = detail::make_temp_file_name();
+  }
+
+  ~fixture() {
+    detail::remove(file_name);
+  }
+
+  std::string file_name;
+};
+
+} // namespace
+
+CAF_TEST_FIXTURE_SCOPE(async_generator_file_writer_tests, fixture)
+
+CAF_TEST(spsc queues are bounded FIFO queues) {
+  detail::spsc_queue<int> queue{3};
+  CHECK_EQUAL(queue.capacity(), 4u);
+  CHECK(queue.empty());
+  for (int i = 0; i < 4; ++i)
+    CHECK(queue.try_push(i));
+  CHECK(!queue.try_push(4));
+  int x = -1;
+  for (int i = 0; i < 4; ++i) {
+    CHECK(queue.try_pop(x));
+    CHECK_EQUAL(x, i);
+  }
+  CHECK(!queue.try_pop(x));
+  CHECK(queue.empty());
+}
+
+CAF_TEST(the writer thread writes all messages before shutting down) {
+  auto t0 = broker::now();
+  {
+    auto out = detail::make_generator_file_writer(file_name);
+    REQUIRE_NOT_EQUAL(out, nullptr);
+    detail::async_generator_file_writer writer{std::move(out), 1024};
+    for (integer i = 0; i < 1000; ++i)
+      CHECK(writer.push(make_data_message("foo", i),
+                        t0 + std::chrono::milliseconds(i)));
+    CHECK(!writer.failed());
+  }
+  auto reader = detail::make_generator_file_reader(file_name);
+  REQUIRE_NOT_EQUAL(reader, nullptr);
+  CHECK_EQUAL(reader->entries(), 1000u);
+  detail::generator_file_reader::value_type msg;
+  timestamp t;
+  for (int i = 0; i < 1000; ++i) {
+    CHECK_EQUAL(reader->read(msg, t), caf::none);
+    CHECK_EQUAL(t, t0 + std::chrono::milliseconds(i));
+  }
+}
+
+CAF_TEST(flight recorder writers only keep the most recent dumps) {
+  auto dir = detail::make_temp_file_name();
+  detail::mkdirs(dir);
+  auto prefix = dir + "/dump-";
+  auto dump_file = [&](size_t i) {
+    return prefix + std::to_string(i) + ".dat";
+  };
+  {
+    detail::flight_recorder::limits cfg;
+    cfg.max_entries = 100;
+    REQUIRE(detail::mkdirs(dir + "/segments"));
+    detail::flight_recorder_ptr rec{
+      new detail::flight_recorder(dir + "/segments", cfg)};
+    detail::async_generator_file_writer writer{std::move(rec), prefix, 1024, 2};
+    for (integer i = 0; i < 5; ++i) {
+      CHECK(writer.push(make_data_message("foo", i), broker::now()));
+      writer.dump();
+      // Wait for the writer thread before requesting the next dump.
+      while (!detail::exists(dump_file(i)))
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  for (size_t i = 0; i < 3; ++i)
+    CHECK(!detail::exists(dump_file(i)));
+  for (size_t i = 3; i < 5; ++i)
+    CHECK(detail::exists(dump_file(i)));
+  detail::remove_all(dir);
+}
+
+CAF_TEST_FIXTURE_SCOPE_END()
@@ -0,0 +1,83 @@
+#define SUITE batch_tuner
+
+#include "broker/detail/batch_tuner.hh"
+
+#include "test.hh"
+
+using namespace broker;
+using namespace std::chrono_literals;
+
+using detail::batch_tuner;
+using detail::stream_goal;
+
+namespace {
+
+timestamp at(timespan dt) {
+  return timestamp{1s} + dt;
+}
+
+// Simulates a peer that acknowledges one batch per `rtt` and grants `credit`
+// with each ack.
+void simulate(batch_tuner& tuner, timespan rtt, int32_t credit) {
+  for (int64_t id = 0; id < 50; ++id) {
+    tuner.sent(id + 1, at(id * rtt));
+    tuner.acked(id, credit, at((id + 1) * rtt));
+  }
+}
+
+} // namespace
+
+CAF_TEST(stream goals convert from and to strings) {
+  for (auto x : {stream_goal::throughput, stream_goal::latency,
+                 stream_goal::adaptive}) {
+    stream_goal y = stream_goal::throughput;
+    CHECK(convert(to_string(x), y));
+    CHECK_EQUAL(x, y);
+  }
+  stream_goal y = stream_goal::latency;
+  CHECK(!convert("fast", y));
+  CHECK_EQUAL(y, stream_goal::latency);
+}
+
+CAF_TEST(fixed goals ignore measurements) {
+  batch_tuner throughput{stream_goal::throughput};
+  batch_tuner latency{stream_goal::latency};
+  CHECK_EQUAL(throughput.target(50), 50u);
+  CHECK_EQUAL(latency.target(50), 1u);
+  CHECK(!throughput.flush(10, 50));
+  CHECK(throughput.flush(50, 50));
+  CHECK(latency.flush(1, 50));
+  CHECK(!latency.flush(0, 50));
+}
+
+CAF_TEST(adaptive tuners start with small batches) {
+  batch_tuner tuner{stream_goal::adaptive};
+  CHECK_EQUAL(tuner.rtt(), timespan{0});
+  CHECK_EQUAL(tuner.target(50), 1u);
+}
+
+CAF_TEST(adaptive tuners measure RTT and consumer rate) {
+  batch_tuner tuner{stream_goal::adaptive};
+  simulate(tuner, 10ms, 1000);
+  CHECK_EQUAL(tuner.rtt(), timespan{10ms});
+  CHECK(tuner.rate() > 99000 && tuner.rate() < 101000);
+}
+
+CAF_TEST(adaptive tuners pick larger batches for longer round trips) {
+  batch_tuner lan{stream_goal::adaptive};
+  simulate(lan, 100us, 10);
+  batch_tuner wan{stream_goal::adaptive};
+  simulate(wan, 50ms, 5000);
+  // Both peers consume 100k messages per second. The LAN peer receives
+  // batches of about 5 messages, the WAN peer receives full batches.
+  CHECK(lan.target(1000) >= 4 && lan.target(1000) <= 6);
+  CHECK_EQUAL(wan.target(1000), 1000u);
+}
+
+CAF_TEST(tuners only track a bounded number of batches) {
+  batch_tuner tuner{stream_goal::adaptive};
+  for (int64_t id = 1; id <= 1000; ++id)
+    tuner.sent(id, at(id * 1ms));
+  tuner.acked(999, 10, at(1001ms));
+  CHECK_EQUAL(tuner.rtt(), timespan{1ms});
+}
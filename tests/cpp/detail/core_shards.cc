@@ -0,0 +1,50 @@
+#define SUITE core_shards
+
+#include "broker/detail/core_shards.hh"
+
+#include "test.hh"
+
+using namespace broker;
+
+CAF_TEST(topics with the same top-level component map to the same shard) {
+  for (size_t n = 1; n < 8; ++n) {
+    auto i = detail::shard_of("zeek/events", n);
+    CHECK_LESS(i, n);
+    CHECK_EQUAL(detail::shard_of("zeek/logs/conn", n), i);
+    CHECK_EQUAL(detail::shard_of("zeek", n), i);
+  }
+  CHECK_EQUAL(detail::shard_of("zeek/events", 1), 0u);
+}
+
+CAF_TEST(internal topics always map to the first shard) {
+  for (size_t n = 1; n < 8; ++n) {
+    CHECK_EQUAL(detail::shard_of(topics::statuses, n), 0u);
+    CHECK_EQUAL(detail::shard_of(topics::metrics, n), 0u);
+  }
+}
+
+CAF_TEST(the mapping spreads top-level components across shards) {
+  std::vector<size_t> hits(4);
+  for (int i = 0; i < 100; ++i)
+    ++hits[detail::shard_of("space-" + std::to_string(i) + "/x", hits.size())];
+  for (auto n : hits)
+    CHECK_GREATER(n, 0u);
+}
+
+CAF_TEST(filters without complete top-level component go to all shards) {
+  filter_type xs{"zeek/events", "ze", "", topics::statuses};
+  auto zeek = detail::shard_of("zeek/", 4);
+  auto fs = detail::partition(xs, 4);
+  REQUIRE_EQUAL(fs.size(), 4u);
+  for (size_t i = 0; i < fs.size(); ++i) {
+    filter_type expected;
+    if (i == zeek)
+      expected.emplace_back("zeek/events");
+    expected.emplace_back("ze");
+    expected.emplace_back("");
+    if (i == 0)
+      expected.emplace_back(topics::statuses);
+    CHECK_EQUAL(fs[i], expected);
+  }
+  CHECK_EQUAL(detail::partition(xs, 1), std::vector<filter_type>{xs});
+}
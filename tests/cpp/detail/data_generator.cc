@@ -237,4 +237,49 @@ TEST(roundtrip with meta_data_writer) {
   CHECK_EQUAL(get<std::string>(x[3]).size(), get<std::string>(y[3]).size());
 }
 
+TEST(skipping consumes all meta data of a value) {
+  detail::meta_data_writer writer{sink};
+  data x = vector{1, "abc", table{{"a", set{1, 2}}}, enum_value{"foo"}};
+  CHECK_EQUAL(writer(x), caf::none);
+  caf::binary_deserializer source{nullptr, buf};
+  detail::data_generator generator{source};
+  data::type tag{};
+  CHECK_EQUAL(source(tag), caf::none);
+  CHECK_EQUAL(tag, data::type::vector);
+  CHECK_EQUAL(generator.skip(tag), caf::none);
+  CHECK_EQUAL(source.remaining(), 0u);
+}
+
+TEST(pooled mode reuses messages per topic and shape) {
+  detail::meta_data_writer writer{sink};
+  for (int i = 0; i < 6; ++i)
+    CHECK_EQUAL(writer(vector{1, "abc"}), caf::none);
+  CHECK_EQUAL(writer(vector{1, "abcd"}), caf::none);
+  caf::binary_deserializer source{nullptr, buf};
+  detail::data_generator generator{source};
+  generator.pool_size(2);
+  std::vector<data_message> xs;
+  for (int i = 0; i < 6; ++i) {
+    data_message x;
+    CHECK_EQUAL(generator.generate(i < 4 ? "foo" : "bar", x), caf::none);
+    xs.emplace_back(std::move(x));
+  }
+  data_message y;
+  CHECK_EQUAL(generator.generate("foo", y), caf::none);
+  CHECK_EQUAL(source.remaining(), 0u);
+  // The first two messages fill the pool, then the generator cycles.
+  CHECK_NOT_EQUAL(&get_data(xs[0]), &get_data(xs[1]));
+  CHECK_EQUAL(&get_data(xs[0]), &get_data(xs[2]));
+  CHECK_EQUAL(&get_data(xs[1]), &get_data(xs[3]));
+  // Each topic has its own pool.
+  CHECK_EQUAL(get_topic(xs[4]), topic{"bar"});
+  CHECK_NOT_EQUAL(&get_data(xs[0]), &get_data(xs[4]));
+  // Each shape has its own pool.
+  REQUIRE(holds_alternative<vector>(get_data(y)));
+  auto& y_vec = get<vector>(get_data(y));
+  REQUIRE_EQUAL(y_vec.size(), 2u);
+  REQUIRE(holds_alternative<std::string>(y_vec[1]));
+  CHECK_EQUAL(get<std::string>(y_vec[1]).size(), 4u);
+}
+
 FIXTURE_SCOPE_END()
@@ -0,0 +1,136 @@
+#define SUITE flight_recorder
+
+#include "broker/detail/flight_recorder.hh"
+
+#include "test.hh"
+
+#include "broker/detail/filesystem.hh"
+#include "broker/detail/generator_file_reader.hh"
+
+using namespace broker;
+
+namespace {
+
+struct fixture {
+  fixture() {
+    dir = detail::make_temp_file_name();
+    detail::mkdirs(dir);
+    dump_file = dir + "/dump.dat";
+  }
+
+  ~fixture() {
+    detail::remove_all(dir);
+  }
+
+  // Writes `n` messages starting at `first`, one millisecond apart.
+  void write(detail::flight_recorder& rec, integer first, integer n) {
+    for (integer i = first; i < first + n; ++i)
+      REQUIRE_EQUAL(rec.write(make_data_message("foo", i),
+                              t0 + std::chrono::milliseconds(i)),
+                    caf::none);
+  }
+
+  // Reads all data messages from the dump file.
+  std::vector<integer> read_dump() {
+    std::vector<integer> result;
+    auto reader = detail::make_generator_file_reader(dump_file);
+    if (reader == nullptr) {
+      FAIL("unable to open dump file");
+      return result;
+    }
+    detail::generator_file_reader::value_type x;
+    while (!reader->at_end()) {
+      if (auto err = reader->read(x)) {
+        FAIL("unable to read from dump file: " << err);
+        return result;
+      }
+      auto& msg = caf::get<data_message>(x);
+      result.emplace_back(caf::get<integer>(get_data(msg)));
+    }
+    return result;
+  }
+
+  std::string dir;
+
+  std::string dump_file;
+
+  timestamp t0 = broker::now();
+};
+
+std::vector<integer> iota(integer first, integer last) {
+  std::vector<integer> result;
+  for (integer i = first; i < last; ++i)
+    result.emplace_back(i);
+  return result;
+}
+
+} // namespace
+
+CAF_TEST_FIXTURE_SCOPE(flight_recorder_tests, fixture)
+
+CAF_TEST(the flight recorder keeps the most recent entries) {
+  detail::flight_recorder::limits cfg;
+  cfg.max_entries = 100;
+  cfg.num_segments = 4;
+  detail::flight_recorder rec{dir, cfg};
+  write(rec, 0, 1000);
+  CHECK_LESS_EQUAL(rec.num_segments(), 5u);
+  CHECK_GREATER_EQUAL(rec.entries(), 100u);
+  CHECK_LESS_EQUAL(rec.entries(), 125u);
+  REQUIRE_EQUAL(rec.dump(dump_file), caf::none);
+  CHECK_EQUAL(read_dump(), iota(1000 - rec.entries(), 1000));
+}
+
+CAF_TEST(the flight recorder drops entries older than its max age) {
+  detail::flight_recorder::limits cfg;
+  cfg.max_age = std::chrono::milliseconds(100);
+  cfg.num_segments = 4;
+  detail::flight_recorder rec{dir, cfg};
+  write(rec, 0, 1000);
+  REQUIRE_EQUAL(rec.dump(dump_file), caf::none);
+  auto xs = read_dump();
+  REQUIRE(!xs.empty());
+  CHECK_GREATER_EQUAL(xs.front(), 1000 - 200);
+  CHECK_EQUAL(xs.back(), 999);
+}
+
+CAF_TEST(dumps include all entries since the last rotation) {
+  detail::flight_recorder::limits cfg;
+  cfg.max_entries = 1000;
+  detail::flight_recorder rec{dir, cfg};
+  write(rec, 0, 10);
+  CHECK(rec.has_new_entries());
+  REQUIRE_EQUAL(rec.dump(dump_file), caf::none);
+  CHECK(!rec.has_new_entries());
+  CHECK_EQUAL(read_dump(), iota(0, 10));
+  write(rec, 10, 10);
+  REQUIRE_EQUAL(rec.dump(dump_file), caf::none);
+  CHECK_EQUAL(read_dump(), iota(0, 20));
+}
+
+CAF_TEST(repeated dumps keep the configured number of entries) {
+  detail::flight_recorder::limits cfg;
+  cfg.max_entries = 100;
+  cfg.num_segments = 4;
+  detail::flight_recorder rec{dir, cfg};
+  // Each dump closes a segment with a single entry.
+  for (integer i = 0; i < 200; ++i) {
+    write(rec, i, 1);
+    REQUIRE_EQUAL(rec.dump(dump_file), caf::none);
+  }
+  CHECK_EQUAL(rec.entries(), 100u);
+  CHECK_EQUAL(read_dump(), iota(100, 200));
+}
+
+CAF_TEST(the flight recorder removes its segments on destruction) {
+  detail::flight_recorder::limits cfg;
+  cfg.max_entries = 10;
+  {
+    detail::flight_recorder rec{dir, cfg};
+    write(rec, 0, 100);
+    CHECK(detail::exists(dir + "/segment-33.dat"));
+  }
+  CHECK(!detail::exists(dir + "/segment-33.dat"));
+}
+
+CAF_TEST_FIXTURE_SCOPE_END()
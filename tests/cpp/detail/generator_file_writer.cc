@@ -4,8 +4,12 @@
 
 #include "test.hh"
 
+#include <cstring>
+#include <fstream>
+
 #include "broker/detail/filesystem.hh"
 #include "broker/detail/generator_file_reader.hh"
+#include "broker/detail/meta_data_writer.hh"
 
 using namespace broker;
 
@@ -85,4 +89,194 @@ CAF_TEST(command_message roundtrip with generator_file_reader) {
   CHECK_EQUAL(reader->read(y_msg), ec::end_of_file);
 }
 
+CAF_TEST(readers can seek to any entry in multi-block files) {
+  {
+    auto out = detail::make_generator_file_writer(file_name);
+    out->block_size(64);
+    for (integer i = 0; i < 100; ++i)
+      out->write(make_data_message(i % 2 == 0 ? "foo" : "bar", i));
+  }
+  auto reader = detail::make_generator_file_reader(file_name);
+  REQUIRE_NOT_EQUAL(reader, nullptr);
+  CHECK_EQUAL(reader->version(), 2u);
+  CHECK_GREATER(reader->num_blocks(), 1u);
+  CHECK_EQUAL(reader->entries(), 100u);
+  CHECK_EQUAL(reader->data_entries(), 100u);
+  CHECK_EQUAL(reader->topics(), std::vector<topic>({"foo", "bar"}));
+  caf::variant<data_message, command_message> msg;
+  CHECK_EQUAL(reader->seek(51), caf::none);
+  CHECK_EQUAL(reader->read(msg), caf::none);
+  CHECK_EQUAL(get_topic(msg), topic{"bar"});
+  CHECK_EQUAL(reader->read(msg), caf::none);
+  CHECK_EQUAL(get_topic(msg), topic{"foo"});
+  CHECK_EQUAL(reader->seek(100), caf::none);
+  CHECK(reader->at_end());
+  CHECK_EQUAL(reader->seek(101), ec::end_of_file);
+  reader->rewind();
+  size_t total = 0;
+  while (!reader->at_end()) {
+    CHECK_EQUAL(reader->read(msg), caf::none);
+    ++total;
+  }
+  CHECK_EQUAL(total, 100u);
+}
+
+CAF_TEST(blocks decode independently) {
+  {
+    auto out = detail::make_generator_file_writer(file_name);
+    out->block_size(64);
+    for (integer i = 0; i < 100; ++i)
+      out->write(make_data_message(i % 2 == 0 ? "foo" : "bar", i));
+  }
+  auto reader = detail::make_generator_file_reader(file_name);
+  REQUIRE_NOT_EQUAL(reader, nullptr);
+  std::vector<detail::generator_file_reader::value_type> xs;
+  for (size_t i = 0; i < reader->num_blocks(); ++i) {
+    CHECK_EQUAL(reader->first_entry(i), xs.size());
+    CHECK_EQUAL(reader->decode_block(i, xs), caf::none);
+  }
+  REQUIRE_EQUAL(xs.size(), 100u);
+  for (size_t i = 0; i < xs.size(); ++i)
+    CHECK_EQUAL(get_topic(xs[i]), topic{i % 2 == 0 ? "foo" : "bar"});
+}
+
+CAF_TEST(generator files store a timestamp for each entry) {
+  auto t0 = broker::now();
+  std::vector<timestamp> times;
+  for (int i = 0; i < 50; ++i)
+    times.emplace_back(t0 + std::chrono::milliseconds(i * i));
+  {
+    auto out = detail::make_generator_file_writer(file_name);
+    out->block_size(64);
+    for (size_t i = 0; i < times.size(); ++i)
+      out->write(make_data_message("foo", integer{1}), times[i]);
+  }
+  auto reader = detail::make_generator_file_reader(file_name);
+  REQUIRE_NOT_EQUAL(reader, nullptr);
+  CHECK(reader->timestamped());
+  caf::variant<data_message, command_message> msg;
+  timestamp t;
+  for (size_t i = 0; i < times.size(); ++i) {
+    CHECK_EQUAL(reader->read(msg, t), caf::none);
+    CHECK_EQUAL(t, times[i]);
+  }
+  CHECK_EQUAL(reader->seek(42), caf::none);
+  CHECK_EQUAL(reader->read(msg, t), caf::none);
+  CHECK_EQUAL(t, times[42]);
+  std::vector<detail::generator_file_reader::value_type> xs;
+  std::vector<timestamp> ts;
+  for (size_t i = 0; i < reader->num_blocks(); ++i)
+    CHECK_EQUAL(reader->decode_block(i, xs, ts), caf::none);
+  CHECK_EQUAL(ts, times);
+}
+
+CAF_TEST(readers recover files without index) {
+  {
+    auto out = detail::make_generator_file_writer(file_name);
+    out->block_size(64);
+    for (integer i = 0; i < 100; ++i)
+      out->write(make_data_message("foo", i));
+    // Simulate a crash: flush all blocks but never write the index.
+    out->flush();
+    std::ifstream in{file_name, std::ios::binary};
+    std::vector<char> buf{std::istreambuf_iterator<char>{in},
+                          std::istreambuf_iterator<char>{}};
+    std::ofstream copy{file_name + ".crashed", std::ios::binary};
+    copy.write(buf.data(), buf.size());
+  }
+  auto reader = detail::make_generator_file_reader(file_name + ".crashed");
+  detail::remove(file_name + ".crashed");
+  REQUIRE_NOT_EQUAL(reader, nullptr);
+  CHECK_EQUAL(reader->entries(), 100u);
+  CHECK_EQUAL(reader->topics(), std::vector<topic>({"foo"}));
+}
+
+CAF_TEST(readers accept version 1 files) {
+  {
+    caf::binary_serializer::container_type buf;
+    caf::binary_serializer sink{nullptr, buf};
+    using entry_type = detail::generator_file_writer::format::entry_type;
+    uint16_t tid = 0;
+    detail::meta_data_writer writer{sink};
+    CHECK_EQUAL(sink(entry_type::new_topic, std::string{"foo/bar"},
+                     entry_type::data_message, tid),
+                caf::none);
+    CHECK_EQUAL(writer(data{vector{1, 2, "a"}}), caf::none);
+    auto magic = detail::generator_file_writer::format::magic;
+    uint8_t version = 1;
+    char header[sizeof(magic) + sizeof(version)];
+    memcpy(header, &magic, sizeof(magic));
+    memcpy(header + sizeof(magic), &version, sizeof(version));
+    std::ofstream out{file_name, std::ios::binary};
+    out.write(header, sizeof(header));
+    out.write(reinterpret_cast<const char*>(buf.data()), buf.size());
+  }
+  auto reader = detail::make_generator_file_reader(file_name);
+  REQUIRE_NOT_EQUAL(reader, nullptr);
+  CHECK_EQUAL(reader->version(), 1u);
+  caf::variant<data_message, command_message> msg;
+  CHECK_EQUAL(reader->read(msg), caf::none);
+  CHECK_EQUAL(get_topic(msg), topic{"foo/bar"});
+  CHECK(reader->at_end());
+  CHECK_EQUAL(reader->entries(), 1u);
+}
+
+CAF_TEST(readers ignore indexes with empty blocks) {
+  {
+    using format = detail::generator_file_writer::format;
+    caf::binary_serializer::container_type buf;
+    caf::binary_serializer sink{nullptr, buf};
+    auto magic = format::magic;
+    auto version = format::version;
+    auto index_magic = format::index_magic;
+    // Write a single block that claims to contain no entries.
+    format::block_info info;
+    info.offset = format::header_size;
+    CHECK_EQUAL(sink(magic, version, info.header), caf::none);
+    uint64_t index_offset = buf.size();
+    uint32_t num_topics = 0;
+    std::vector<format::block_info> index{info};
+    CHECK_EQUAL(sink(num_topics, index, index_offset, index_magic), caf::none);
+    std::ofstream out{file_name, std::ios::binary};
+    out.write(reinterpret_cast<const char*>(buf.data()), buf.size());
+  }
+  // Scanning stops at the empty block, i.e., the file has no entries.
+  auto reader = detail::make_generator_file_reader(file_name);
+  REQUIRE_NOT_EQUAL(reader, nullptr);
+  CHECK_EQUAL(reader->num_blocks(), 0u);
+  CHECK_EQUAL(reader->entries(), 0u);
+  CHECK(reader->at_end());
+}
+
+CAF_TEST(readers scan all blocks if the index is corrupt) {
+  {
+    auto out = detail::make_generator_file_writer(file_name);
+    out->block_size(64);
+    for (integer i = 0; i < 100; ++i)
+      out->write(make_data_message("foo", i));
+  }
+  {
+    // Point the trailer to an empty index.
+    using format = detail::generator_file_writer::format;
+    std::fstream f{file_name, std::ios::binary | std::ios::in | std::ios::out};
+    f.seekg(0, std::ios::end);
+    uint64_t file_size = f.tellg();
+    REQUIRE_GREATER(file_size, format::trailer_size);
+    uint64_t index_offset = file_size - format::trailer_size;
+    caf::binary_serializer::container_type buf;
+    caf::binary_serializer sink{nullptr, buf};
+    CHECK_EQUAL(sink(index_offset), caf::none);
+    f.seekp(static_cast<std::streamoff>(index_offset));
+    f.write(reinterpret_cast<const char*>(buf.data()), buf.size());
+  }
+  auto reader = detail::make_generator_file_reader(file_name);
+  REQUIRE_NOT_EQUAL(reader, nullptr);
+  CHECK_EQUAL(reader->entries(), 100u);
+  CHECK_EQUAL(reader->topics(), std::vector<topic>({"foo"}));
+  caf::variant<data_message, command_message> msg;
+  CHECK_EQUAL(reader->seek(99), caf::none);
+  CHECK_EQUAL(reader->read(msg), caf::none);
+  CHECK_EQUAL(get_data(get<data_message>(msg)), data{integer{99}});
+}
+
 CAF_TEST_FIXTURE_SCOPE_END()
@@ -0,0 +1,91 @@
+#define SUITE local_subscriber_table
+
+#include "broker/detail/local_subscriber_table.hh"
+
+#include "test.hh"
+
+using namespace broker;
+
+namespace {
+
+struct fixture {
+  static constexpr size_t max_qsize = 20;
+
+  detail::local_subscriber_table_ptr tbl;
+  detail::shared_subscriber_queue_ptr<> q1;
+  detail::shared_subscriber_queue_ptr<> q2;
+
+  fixture() : tbl(detail::make_local_subscriber_table()) {
+    q1 = detail::make_shared_subscriber_queue<data_message>();
+    q2 = detail::make_shared_subscriber_queue<data_message>();
+  }
+
+  static data_message msg(std::string t) {
+    return make_data_message(topic{std::move(t)}, data{42});
+  }
+};
+
+} // namespace
+
+CAF_TEST_FIXTURE_SCOPE(local_subscriber_table_tests, fixture)
+
+CAF_TEST(an empty table delivers nothing) {
+  CHECK_EQUAL(tbl->size(), 0u);
+  CHECK_EQUAL(tbl->deliver(msg("a/b")), 0u);
+}
+
+CAF_TEST(the table delivers messages by topic prefix) {
+  tbl->add(q1, filter_type{"a"}, max_qsize);
+  tbl->add(q2, filter_type{"a/b", "c"}, max_qsize);
+  CHECK_EQUAL(tbl->size(), 2u);
+  CHECK_EQUAL(tbl->deliver(msg("a/b/c")), 2u);
+  CHECK_EQUAL(tbl->deliver(msg("a/x")), 1u);
+  CHECK_EQUAL(tbl->deliver(msg("c")), 1u);
+  CHECK_EQUAL(tbl->deliver(msg("d")), 0u);
+  CHECK_EQUAL(q1->buffer_size(), 2u);
+  CHECK_EQUAL(q2->buffer_size(), 2u);
+  CHECK_EQUAL(q1->produced(), 2u);
+  auto xs = q2->consume_all();
+  REQUIRE_EQUAL(xs.size(), 2u);
+  CHECK_EQUAL(get_topic(xs[0]), topic{"a/b/c"});
+  CHECK_EQUAL(get_topic(xs[1]), topic{"c"});
+  CHECK_EQUAL(q2->produced(), 2u);
+}
+
+CAF_TEST(set_filter replaces the filter of a queue) {
+  tbl->add(q1, filter_type{"a"}, max_qsize);
+  tbl->set_filter(q1.get(), filter_type{"b"});
+  CHECK_EQUAL(tbl->deliver(msg("a/x")), 0u);
+  CHECK_EQUAL(tbl->deliver(msg("b/x")), 1u);
+}
+
+CAF_TEST(erase stops delivery to a queue) {
+  tbl->add(q1, filter_type{"a"}, max_qsize);
+  tbl->add(q2, filter_type{"a"}, max_qsize);
+  tbl->erase(q1.get());
+  CHECK_EQUAL(tbl->size(), 1u);
+  CHECK_EQUAL(tbl->deliver(msg("a")), 1u);
+  CHECK_EQUAL(q1->buffer_size(), 0u);
+  CHECK_EQUAL(q2->buffer_size(), 1u);
+}
+
+CAF_TEST(the table drops messages for full queues) {
+  tbl->add(q1, filter_type{"a"}, 3);
+  tbl->add(q2, filter_type{"a"}, max_qsize);
+  MESSAGE("q1 never consumes and fills up after three messages");
+  for (int i = 0; i < 3; ++i)
+    CHECK_EQUAL(tbl->deliver(msg("a")), 2u);
+  for (int i = 0; i < 5; ++i)
+    CHECK_EQUAL(tbl->deliver(msg("a")), 1u);
+  CHECK_EQUAL(q1->buffer_size(), 3u);
+  CHECK_EQUAL(q1->produced(), 3u);
+  CHECK_EQUAL(q1->dropped(), 5u);
+  CHECK_EQUAL(q2->buffer_size(), 8u);
+  CHECK_EQUAL(q2->dropped(), 0u);
+  MESSAGE("q1 accepts messages again after consuming");
+  CHECK_EQUAL(q1->consume_all().size(), 3u);
+  CHECK_EQUAL(tbl->deliver(msg("a")), 2u);
+  CHECK_EQUAL(q1->buffer_size(), 1u);
+}
+
+CAF_TEST_FIXTURE_SCOPE_END()
@@ -0,0 +1,133 @@
+#define SUITE metric_registry
+
+#include "broker/detail/metric_registry.hh"
+
+#include "test.hh"
+
+#include "broker/detail/shared_publisher_queue.hh"
+#include "broker/detail/shared_subscriber_queue.hh"
+
+using namespace broker;
+
+namespace {
+
+struct fixture {
+  detail::metric_registry_ptr reg = detail::make_metric_registry();
+
+  integer get(const std::string& key) {
+    auto xs = reg->snapshot();
+    auto i = xs.find(key);
+    if (i == xs.end()) {
+      FAIL("no metric named " << key);
+      return -1;
+    }
+    return caf::get<integer>(i->second);
+  }
+};
+
+} // namespace
+
+CAF_TEST_FIXTURE_SCOPE(metric_registry_tests, fixture)
+
+CAF_TEST(lookups return the same metric for the same name and labels) {
+  auto& x = reg->counter("foo", {{"peer", "a"}});
+  auto& y = reg->counter("foo", {{"peer", "a"}});
+  auto& z = reg->counter("foo", {{"peer", "b"}});
+  CHECK_EQUAL(&x, &y);
+  CHECK_NOT_EQUAL(&x, &z);
+  CHECK_EQUAL(reg->size(), 2u);
+}
+
+CAF_TEST(counters and gauges update their values) {
+  auto& x = reg->counter("requests_total");
+  auto& y = reg->gauge("queued");
+  x.inc();
+  x.inc(4);
+  y.inc(10);
+  y.dec(3);
+  CHECK_EQUAL(x.value(), 5);
+  CHECK_EQUAL(y.value(), 7);
+  y.set(42);
+  CHECK_EQUAL(y.value(), 42);
+  auto samples = reg->collect();
+  REQUIRE_EQUAL(samples.size(), 2u);
+  CHECK_EQUAL(samples[0].name, "queued");
+  CHECK(samples[0].kind == detail::metric::type::gauge);
+  CHECK_EQUAL(samples[1].name, "requests_total");
+  CHECK(samples[1].kind == detail::metric::type::counter);
+}
+
+CAF_TEST(snapshots render labels in the Prometheus format) {
+  CHECK_EQUAL(detail::render_metric_name("foo", {}), "foo");
+  CHECK_EQUAL(detail::render_metric_name("foo", {{"b", "2"}, {"a", "1"}}),
+              R"(foo{a="1",b="2"})");
+  CHECK_EQUAL(detail::render_metric_name("foo", {{"a", "x\"y\\z"}}),
+              R"(foo{a="x\"y\\z"})");
+  reg->counter("foo", {{"peer", "a"}}).inc(3);
+  CHECK_EQUAL(get(R"(foo{peer="a"})"), 3);
+}
+
+CAF_TEST(the Prometheus exporter groups samples by name) {
+  reg->counter("sent_total", {{"peer", "b"}}).inc(2);
+  reg->counter("sent_total", {{"peer", "a"}}).inc(1);
+  reg->gauge("peers").set(2);
+  CHECK_EQUAL(detail::render_prometheus(reg->collect()),
+              "# TYPE peers gauge\n"
+              "peers 2\n"
+              "# TYPE sent_total counter\n"
+              "sent_total{peer=\"a\"} 1\n"
+              "sent_total{peer=\"b\"} 2\n");
+}
+
+CAF_TEST(removing a label drops all matching metrics) {
+  reg->counter("sent", {{"peer", "a"}});
+  reg->counter("received", {{"peer", "a"}});
+  reg->counter("sent", {{"peer", "b"}});
+  reg->gauge("peers");
+  reg->remove("peer", "a");
+  CHECK_EQUAL(reg->size(), 2u);
+  auto xs = reg->snapshot();
+  CHECK_EQUAL(xs.count(R"(sent{peer="b"})"), 1u);
+  CHECK_EQUAL(xs.count("peers"), 1u);
+}
+
+CAF_TEST(removing by labels only drops metrics that carry all labels) {
+  reg->counter("received", {{"peer", "a"}, {"shard", "0"}});
+  reg->counter("received", {{"peer", "a"}, {"shard", "1"}});
+  reg->counter("received", {{"peer", "b"}, {"shard", "0"}});
+  reg->remove(detail::metric_labels{{"peer", "a"}, {"shard", "0"}});
+  CHECK_EQUAL(reg->size(), 2u);
+  auto xs = reg->snapshot();
+  CHECK_EQUAL(xs.count(R"(received{peer="a",shard="1"})"), 1u);
+  CHECK_EQUAL(xs.count(R"(received{peer="b",shard="0"})"), 1u);
+}
+
+CAF_TEST(subscriber queues report depth and drops) {
+  auto q = detail::make_shared_subscriber_queue();
+  q->metrics(reg, "sub");
+  std::vector<data_message> xs;
+  for (integer i = 0; i < 5; ++i)
+    xs.emplace_back(make_data_message("foo", i));
+  q->produce(xs.size(), xs.begin(), xs.end());
+  CHECK_EQUAL(get("sub_queued_messages"), 5);
+  CHECK_EQUAL(get("sub_messages_total"), 5);
+  q->consume(2, nullptr, [](data_message&&) {});
+  CHECK_EQUAL(get("sub_queued_messages"), 3);
+  q = nullptr;
+  CHECK_EQUAL(get("sub_queued_messages"), 0);
+  CHECK_EQUAL(get("sub_dropped_messages_total"), 3);
+}
+
+CAF_TEST(publisher queues report depth) {
+  auto q = detail::make_shared_publisher_queue(10);
+  q->metrics(reg, "pub");
+  for (integer i = 0; i < 4; ++i)
+    q->produce("foo", data{i});
+  CHECK_EQUAL(get("pub_queued_messages"), 4);
+  q->consume(10, [](data_message&&) {});
+  CHECK_EQUAL(get("pub_queued_messages"), 0);
+  CHECK_EQUAL(get("pub_messages_total"), 4);
+  CHECK_EQUAL(get("pub_blocked_total"), 0);
+}
+
+CAF_TEST_FIXTURE_SCOPE_END()
@@ -0,0 +1,88 @@
+#define SUITE parallel_generator_file_reader
+
+#include "broker/detail/parallel_generator_file_reader.hh"
+
+#include "test.hh"
+
+#include "broker/detail/filesystem.hh"
+#include "broker/detail/generator_file_writer.hh"
+
+using namespace broker;
+
+namespace {
+
+struct fixture {
+  fixture() {
+    file_name = detail::make_temp_file_name();
+    auto out = detail::make_generator_file_writer(file_name);
+    out->block_size(64);
+    for (integer i = 0; i < 100; ++i)
+      out->write(make_data_message("foo/" + std::to_string(i % 10), i));
+  }
+
+  ~fixture() {
+    detail::remove(file_name);
+  }
+
+  detail::parallel_generator_file_reader_ptr make_reader(size_t num_threads,
+                                                         bool cycle) {
+    auto reader = detail::make_generator_file_reader(file_name);
+    if (reader == nullptr)
+      FAIL("unable to open generator file");
+    using impl = detail::parallel_generator_file_reader;
+    return detail::parallel_generator_file_reader_ptr{
+      new impl(std::move(reader), num_threads, 2, cycle)};
+  }
+
+  std::string file_name;
+};
+
+topic expected_topic(size_t i) {
+  return topic{"foo/" + std::to_string(i % 10)};
+}
+
+} // namespace
+
+CAF_TEST_FIXTURE_SCOPE(parallel_generator_file_reader_tests, fixture)
+
+CAF_TEST(batches arrive in file order) {
+  auto reader = make_reader(4, false);
+  REQUIRE_GREATER(reader->reader().num_blocks(), 4u);
+  CHECK_EQUAL(reader->num_threads(), 4u);
+  detail::parallel_generator_file_reader::batch buf;
+  size_t n = 0;
+  for (size_t i = 0; !reader->at_end(); ++i) {
+    REQUIRE_EQUAL(reader->next(buf), caf::none);
+    CHECK_EQUAL(buf.block, i);
+    CHECK_EQUAL(buf.xs.size(), buf.ts.size());
+    for (auto& x : buf.xs)
+      CHECK_EQUAL(get_topic(x), expected_topic(n++));
+  }
+  CHECK_EQUAL(n, 100u);
+  CHECK_EQUAL(reader->next(buf), ec::end_of_file);
+}
+
+CAF_TEST(cycling readers restart at the first block) {
+  auto reader = make_reader(3, true);
+  auto num_blocks = reader->reader().num_blocks();
+  detail::parallel_generator_file_reader::batch buf;
+  size_t n = 0;
+  for (size_t i = 0; i < num_blocks * 3; ++i) {
+    REQUIRE(!reader->at_end());
+    REQUIRE_EQUAL(reader->next(buf), caf::none);
+    CHECK_EQUAL(buf.block, i % num_blocks);
+    for (auto& x : buf.xs)
+      CHECK_EQUAL(get_topic(x), expected_topic(n++ % 100));
+  }
+  CHECK_EQUAL(n, 300u);
+}
+
+CAF_TEST(destroying the reader stops all workers) {
+  // Must not hang even if the workers wait for free slots.
+  auto reader = make_reader(4, true);
+  detail::parallel_generator_file_reader::batch buf;
+  CHECK_EQUAL(reader->next(buf), caf::none);
+  reader.reset();
+}
+
+CAF_TEST_FIXTURE_SCOPE_END()
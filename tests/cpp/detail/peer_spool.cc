@@ -0,0 +1,155 @@
+#define SUITE peer_spool
+
+#include "broker/detail/peer_spool.hh"
+
+#include "test.hh"
+
+#include <vector>
+
+#include "broker/detail/filesystem.hh"
+#include "broker/detail/trace_context.hh"
+#include "broker/internal_command.hh"
+
+using namespace broker;
+
+namespace {
+
+using spool_type = detail::peer_spool<std::string>;
+
+using message_type = spool_type::message_type;
+
+message_type msg(std::string t, int x) {
+  return message_type{make_data_message(topic{std::move(t)}, data{x}), 20, {},
+                      caf::none};
+}
+
+std::vector<data> values(const std::vector<message_type>& xs) {
+  std::vector<data> result;
+  for (auto& x : xs)
+    result.emplace_back(get_data(caf::get<data_message>(x.content)));
+  return result;
+}
+
+} // namespace
+
+CAF_TEST(a spool with capacity 0 is disabled) {
+  spool_type spool;
+  CHECK(!spool.enabled());
+  spool.open("alice", filter_type{"a"});
+  CHECK(spool.empty());
+  spool.add(msg("a/b", 1));
+  CHECK_EQUAL(spool.size("alice"), 0u);
+}
+
+CAF_TEST(spools keep matching messages until the peer returns) {
+  spool_type spool{10};
+  spool.open("alice", filter_type{"a"});
+  spool.open("bob", filter_type{"b"});
+  spool.add(msg("a/x", 1));
+  spool.add(msg("b/x", 2));
+  spool.add(msg("a/y", 3));
+  spool.add(msg("c", 4));
+  spool.add("bob", msg("c", 5));
+  CHECK_EQUAL(spool.size("alice"), 2u);
+  CHECK_EQUAL(spool.size("bob"), 2u);
+  std::vector<message_type> out;
+  CHECK_EQUAL(spool.take("alice", out), 0u);
+  CHECK_EQUAL(values(out), std::vector<data>({data{1}, data{3}}));
+  CHECK(!spool.contains("alice"));
+  CHECK(spool.contains("bob"));
+  out.clear();
+  CHECK_EQUAL(spool.take("bob", out), 0u);
+  CHECK_EQUAL(values(out), std::vector<data>({data{2}, data{5}}));
+  CHECK(spool.empty());
+}
+
+CAF_TEST(full spools drop their oldest messages) {
+  spool_type spool{2};
+  spool.open("alice", filter_type{"a"});
+  for (int i = 0; i < 5; ++i)
+    spool.add(msg("a", i));
+  std::vector<message_type> out;
+  CHECK_EQUAL(spool.take("alice", out), 3u);
+  CHECK_EQUAL(values(out), std::vector<data>({data{3}, data{4}}));
+}
+
+CAF_TEST(expire discards old spools) {
+  spool_type spool{10};
+  spool.open("alice", filter_type{"a"});
+  CHECK_EQUAL(spool.expire(std::chrono::hours(1)), 0u);
+  CHECK(spool.contains("alice"));
+  CHECK_EQUAL(spool.expire(std::chrono::seconds(0)), 1u);
+  CHECK(spool.empty());
+}
+
+CAF_TEST(spools write messages beyond their capacity to disk) {
+  auto dir = detail::make_temp_file_name();
+  REQUIRE(detail::mkdirs(dir));
+  {
+    spool_type spool{2};
+    spool.overflow(dir + "/spool-", 3);
+    spool.open("alice", filter_type{"a"});
+    for (int i = 0; i < 7; ++i)
+      spool.add(msg("a", i));
+    CHECK_EQUAL(spool.size("alice"), 5u);
+    CHECK(detail::exists(dir + "/spool-0.dat"));
+    std::vector<message_type> out;
+    CHECK_EQUAL(spool.take("alice", out), 2u);
+    CHECK_EQUAL(values(out), std::vector<data>({data{0}, data{1}, data{2},
+                                                data{3}, data{4}}));
+    CHECK_EQUAL(out.back().ttl, 20u);
+    CHECK(!detail::exists(dir + "/spool-0.dat"));
+    MESSAGE("expiring a spool removes its file");
+    spool.open("bob", filter_type{"a"});
+    for (int i = 0; i < 4; ++i)
+      spool.add(msg("a", i));
+    CHECK(detail::exists(dir + "/spool-1.dat"));
+    CHECK_EQUAL(spool.expire(std::chrono::seconds(0)), 1u);
+    CHECK(!detail::exists(dir + "/spool-1.dat"));
+  }
+  detail::remove_all(dir);
+}
+
+CAF_TEST(spools keep all fields of messages on disk) {
+  auto dir = detail::make_temp_file_name();
+  REQUIRE(detail::mkdirs(dir));
+  {
+    spool_type spool{1};
+    spool.overflow(dir + "/spool-", 10);
+    spool.open("alice", filter_type{"a"});
+    spool.add(msg("a", 0));
+    auto x = msg("a/b", 1);
+    x.ttl = 7;
+    x.receivers = {"bob", "carl"};
+    x.trace = detail::trace_context{42, {}};
+    x.trace->add(detail::trace_hop::origin);
+    spool.add(x);
+    auto y = make_command_message(
+      topic{"a/c"}, make_internal_command<put_command>(
+                      data{"key"}, data{23}, caf::none, publisher_id{}));
+    spool.add(message_type{y, 3, {}, caf::none});
+    CHECK_EQUAL(spool.size("alice"), 3u);
+    std::vector<message_type> out;
+    CHECK_EQUAL(spool.take("alice", out), 0u);
+    REQUIRE_EQUAL(out.size(), 3u);
+    auto& x_copy = out[1];
+    CHECK_EQUAL(get_topic(x_copy.content), topic{"a/b"});
+    CHECK_EQUAL(get_data(caf::get<data_message>(x_copy.content)), data{1});
+    CHECK_EQUAL(x_copy.ttl, 7u);
+    CHECK_EQUAL(x_copy.receivers, x.receivers);
+    REQUIRE(x_copy.trace);
+    CHECK_EQUAL(x_copy.trace->id, 42u);
+    REQUIRE_EQUAL(x_copy.trace->points.size(), 1u);
+    CHECK_EQUAL(x_copy.trace->points[0].time, x.trace->points[0].time);
+    auto& y_copy = out[2];
+    REQUIRE(is_command_message(y_copy.content));
+    CHECK_EQUAL(get_topic(y_copy.content), topic{"a/c"});
+    auto& cmd = get_command(caf::get<command_message>(y_copy.content));
+    auto put = caf::get_if<put_command>(&cmd);
+    REQUIRE(put != nullptr);
+    CHECK_EQUAL(put->key, data{"key"});
+    CHECK_EQUAL(put->value, data{23});
+    CHECK_EQUAL(y_copy.ttl, 3u);
+  }
+  detail::remove_all(dir);
+}
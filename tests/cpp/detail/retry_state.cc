@@ -0,0 +1,58 @@
+#define SUITE retry_state
+
+#include "broker/detail/retry_state.hh"
+
+#include "test.hh"
+
+using namespace broker;
+using namespace std::chrono_literals;
+
+using detail::retry_delay;
+
+namespace {
+
+struct fixture {
+  std::minstd_rand rng{42};
+
+  // Checks whether `retry_delay` stays within `[x, 1.5 * x]`.
+  bool in_range(timespan base, uint32_t count, timespan max_delay,
+                timespan x) {
+    for (int i = 0; i < 100; ++i) {
+      auto y = retry_delay(base, count, max_delay, rng);
+      if (y < x || y > x + x / 2)
+        return false;
+    }
+    return true;
+  }
+};
+
+} // namespace
+
+CAF_TEST_FIXTURE_SCOPE(retry_state_tests, fixture)
+
+CAF_TEST(retry delays double with each failed attempt) {
+  CHECK(in_range(1s, 0, 30s, 1s));
+  CHECK(in_range(1s, 1, 30s, 2s));
+  CHECK(in_range(1s, 2, 30s, 4s));
+  CHECK(in_range(1s, 4, 30s, 16s));
+}
+
+CAF_TEST(retry delays stop growing at the maximum) {
+  CHECK(in_range(1s, 5, 30s, 30s));
+  CHECK(in_range(1s, 1000, 30s, 30s));
+}
+
+CAF_TEST(retry delays never fall below the base interval) {
+  CHECK(in_range(5s, 0, 0s, 5s));
+  CHECK(in_range(5s, 3, 1s, 5s));
+}
+
+CAF_TEST(retry delays vary between attempts) {
+  auto x = retry_delay(1s, 0, 30s, rng);
+  auto different = false;
+  for (int i = 0; i < 10 && !different; ++i)
+    different = retry_delay(1s, 0, 30s, rng) != x;
+  CHECK(different);
+}
+
+CAF_TEST_FIXTURE_SCOPE_END()
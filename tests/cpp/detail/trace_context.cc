@@ -0,0 +1,75 @@
+#define SUITE trace_context
+
+#include "broker/detail/trace_context.hh"
+
+#include "test.hh"
+
+#include <caf/binary_deserializer.hpp>
+#include <caf/binary_serializer.hpp>
+
+#include "broker/message.hh"
+
+using namespace broker;
+
+CAF_TEST(the sampler selects one in N messages) {
+  detail::trace_sampler off;
+  for (int i = 0; i < 10; ++i)
+    CHECK_EQUAL(off.next(), 0u);
+  detail::trace_sampler sampler{3};
+  std::vector<uint64_t> ids;
+  for (int i = 0; i < 9; ++i)
+    if (auto id = sampler.next(); id != 0)
+      ids.emplace_back(id);
+  REQUIRE_EQUAL(ids.size(), 3u);
+  CHECK_EQUAL(ids[1], ids[0] + 1);
+  CHECK_EQUAL(ids[2], ids[1] + 1);
+}
+
+CAF_TEST(traces convert to data) {
+  detail::trace_context x{42, {}};
+  x.points.emplace_back(detail::trace_point{detail::trace_hop::origin,
+                                            timestamp{timespan{1}}});
+  x.points.emplace_back(detail::trace_point{detail::trace_hop::delivery,
+                                            timestamp{timespan{2}}});
+  CHECK_EQUAL(to_data(x, "foo/bar"),
+              data(vector{count{42}, "foo/bar",
+                          vector{vector{"origin", timestamp{timespan{1}}},
+                                 vector{"delivery", timestamp{timespan{2}}}}}));
+}
+
+CAF_TEST(node messages carry traces over the wire) {
+  auto msg = make_node_message(make_data_message("foo", data{42}), 20);
+  msg.trace = detail::trace_context{7, {}};
+  msg.trace->add(detail::trace_hop::origin);
+  msg.trace->add(detail::trace_hop::forward);
+  caf::binary_serializer::container_type buf;
+  caf::binary_serializer sink{nullptr, buf};
+  REQUIRE_EQUAL(sink(msg), caf::none);
+  node_message copy;
+  caf::binary_deserializer source{nullptr, buf};
+  REQUIRE_EQUAL(source(copy), caf::none);
+  CHECK_EQUAL(copy.ttl, 20u);
+  REQUIRE(copy.trace);
+  CHECK_EQUAL(copy.trace->id, 7u);
+  REQUIRE_EQUAL(copy.trace->points.size(), 2u);
+  CHECK(copy.trace->points[0].hop == detail::trace_hop::origin);
+  CHECK(copy.trace->points[1].hop == detail::trace_hop::forward);
+  CHECK_EQUAL(copy.trace->points[0].time, msg.trace->points[0].time);
+}
+
+CAF_TEST(untraced node messages keep their wire format) {
+  auto msg = make_node_message(make_data_message("foo", data{42}), 20);
+  caf::binary_serializer::container_type buf;
+  caf::binary_serializer sink{nullptr, buf};
+  REQUIRE_EQUAL(sink(msg), caf::none);
+  caf::binary_serializer::container_type expected;
+  caf::binary_serializer expected_sink{nullptr, expected};
+  REQUIRE_EQUAL(expected_sink(msg.content, msg.ttl, msg.receivers), caf::none);
+  CHECK_EQUAL(buf, expected);
+  node_message copy;
+  copy.trace = detail::trace_context{7, {}};
+  caf::binary_deserializer source{nullptr, buf};
+  REQUIRE_EQUAL(source(copy), caf::none);
+  CHECK_EQUAL(copy.ttl, 20u);
+  CHECK(!copy.trace);
+}
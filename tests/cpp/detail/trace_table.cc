@@ -0,0 +1,85 @@
+#define SUITE trace_table
+
+#include "broker/detail/trace_table.hh"
+
+#include "test.hh"
+
+#include <chrono>
+#include <thread>
+
+using namespace broker;
+
+namespace {
+
+using namespace std::chrono_literals;
+
+detail::trace_context ctx(uint64_t id) {
+  return detail::trace_context{id, {}};
+}
+
+data_message msg(std::string t) {
+  return make_data_message(topic{std::move(t)}, data{42});
+}
+
+} // namespace
+
+CAF_TEST(copies of a message share their entry) {
+  detail::trace_table tbl;
+  auto x = msg("foo");
+  auto y = msg("foo");
+  CHECK(tbl.empty());
+  tbl.put(x, ctx(1));
+  CHECK(!tbl.empty());
+  MESSAGE("equal messages are not the same message");
+  CHECK(!tbl.find(y));
+  MESSAGE("find keeps the entry, take removes it");
+  auto copy = x;
+  auto found = tbl.find(copy);
+  REQUIRE(found);
+  CHECK_EQUAL(found->id, 1u);
+  auto taken = tbl.take(copy);
+  REQUIRE(taken);
+  CHECK_EQUAL(taken->id, 1u);
+  CHECK(!tbl.take(x));
+  CHECK(tbl.empty());
+}
+
+CAF_TEST(find_all returns the positions of messages with an entry) {
+  detail::trace_table tbl;
+  std::vector<data_message> xs{msg("a"), msg("b"), msg("c")};
+  tbl.put(xs[0], ctx(1));
+  tbl.put(xs[2], ctx(3));
+  auto found = tbl.find_all(xs);
+  REQUIRE_EQUAL(found.size(), 2u);
+  CHECK_EQUAL(found[0].first, 0u);
+  CHECK_EQUAL(found[0].second.id, 1u);
+  CHECK_EQUAL(found[1].first, 2u);
+  CHECK_EQUAL(found[1].second.id, 3u);
+  MESSAGE("the entries remain for other subscribers");
+  CHECK_EQUAL(tbl.find_all(xs).size(), 2u);
+}
+
+CAF_TEST(full tables drop their oldest entry) {
+  detail::trace_table tbl{2};
+  std::vector<data_message> xs{msg("a"), msg("b"), msg("c")};
+  for (uint64_t i = 0; i < xs.size(); ++i)
+    tbl.put(xs[i], ctx(i + 1));
+  CHECK(!tbl.find(xs[0]));
+  CHECK(tbl.find(xs[1]));
+  CHECK(tbl.find(xs[2]));
+  MESSAGE("taking an entry makes room without dropping another one");
+  CHECK(tbl.take(xs[1]));
+  auto x = msg("d");
+  tbl.put(x, ctx(4));
+  CHECK(tbl.find(xs[2]));
+  CHECK(tbl.find(x));
+}
+
+CAF_TEST(tables drop entries after their maximum age) {
+  detail::trace_table tbl{16, 10ms};
+  auto x = msg("foo");
+  tbl.put(x, ctx(1));
+  std::this_thread::sleep_for(20ms);
+  CHECK(!tbl.find(x));
+  CHECK(tbl.empty());
+}
@@ -0,0 +1,71 @@
+#define SUITE unix_socket
+
+#include "broker/detail/unix_socket.hh"
+
+#include "test.hh"
+
+#include <cstring>
+#include <fstream>
+
+#include "broker/config.hh"
+#include "broker/detail/filesystem.hh"
+
+#ifndef BROKER_WINDOWS
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+using namespace broker;
+
+CAF_TEST(socket paths derive from directory and port) {
+  CHECK_EQUAL(detail::unix_socket_path("/tmp", 9999), "/tmp/broker-9999.sock");
+  CHECK_EQUAL(detail::unix_socket_path("/tmp/", 9999),
+              "/tmp/broker-9999.sock");
+  CHECK_EQUAL(detail::unix_socket_path("run", 1), "run/broker-1.sock");
+}
+
+CAF_TEST(the unix scheme selects a UNIX domain socket) {
+  CHECK_EQUAL(detail::unix_socket_path_of("unix:///tmp/broker.sock"),
+              std::string{"/tmp/broker.sock"});
+  CHECK_EQUAL(detail::unix_socket_path_of("unix://broker.sock"),
+              std::string{"broker.sock"});
+  CHECK_EQUAL(detail::unix_socket_path_of("127.0.0.1"), caf::none);
+  CHECK_EQUAL(detail::unix_socket_path_of("unix:/tmp/broker.sock"), caf::none);
+}
+
+#ifndef BROKER_WINDOWS
+
+CAF_TEST_FIXTURE_SCOPE(unix_socket_tests, base_fixture)
+
+CAF_TEST(publishing never replaces files that are not sockets) {
+  auto path = detail::make_temp_file_name();
+  std::ofstream{path} << "foo";
+  CHECK_NOT_EQUAL(detail::publish_unix_socket(sys, caf::actor{}, path),
+                  caf::none);
+  CHECK_EQUAL(detail::read(path), "foo");
+  detail::remove(path);
+}
+
+CAF_TEST(publishing never replaces sockets that are in use) {
+  auto path = detail::make_temp_file_name();
+  sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  REQUIRE_LESS(path.size(), sizeof(addr.sun_path));
+  memcpy(addr.sun_path, path.c_str(), path.size());
+  auto fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  REQUIRE_NOT_EQUAL(fd, -1);
+  REQUIRE_EQUAL(::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)),
+                0);
+  REQUIRE_EQUAL(::listen(fd, 1), 0);
+  CHECK_NOT_EQUAL(detail::publish_unix_socket(sys, caf::actor{}, path),
+                  caf::none);
+  CHECK(detail::exists(path));
+  ::close(fd);
+  detail::remove(path);
+}
+
+CAF_TEST_FIXTURE_SCOPE_END()
+
+#endif // BROKER_WINDOWS
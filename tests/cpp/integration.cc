@@ -54,7 +54,7 @@ using caf::io::connection_handle;
 
 namespace {
 
-configuration make_config() {
+configuration make_config(size_t num_shards = 1) {
   broker_options options;
   options.disable_ssl = true;
   configuration cfg(options);
@@ -67,6 +67,9 @@ configuration make_config() {
   cfg.set("middleman.network-backend", atom("testing"));
   cfg.set("scheduler.policy", atom("testing"));
   cfg.set("logger.inline-output", true);
+  // Helper threads for connecting would bypass the test multiplexer.
+  cfg.set("broker.connect-workers", size_t{0});
+  cfg.set("broker.core-shards", num_shards);
   return cfg;
 }
 
@@ -131,10 +134,11 @@ struct peer_fixture {
   caf::timespan credit_round_interval;
 
   // Initializes this peer and registers it at parent.
-  peer_fixture(global_fixture* parent_ptr, std::string peer_name)
+  peer_fixture(global_fixture* parent_ptr, std::string peer_name,
+               size_t num_shards = 1)
     : parent(parent_ptr),
       name(std::move(peer_name)),
-      ep(make_config()),
+      ep(make_config(num_shards)),
       sys(ep.system()),
       sched(dynamic_cast<caf::scheduler::test_coordinator&>(sys.scheduler())),
       mm(sys.middleman()),
@@ -579,3 +583,92 @@ CAF_TEST(connection_retry) {
 
 CAF_TEST_FIXTURE_SCOPE_END()
 
+// -- peering of sharded endpoints ---------------------------------------------
+
+namespace {
+
+// Mercury and venus both run two core shards, earth runs three.
+struct shards_fixture : global_fixture {
+  peer_fixture mercury;
+  peer_fixture venus;
+  peer_fixture earth;
+
+  shards_fixture()
+    : mercury(this, "mercury", 2),
+      venus(this, "venus", 2),
+      earth(this, "earth", 3) {
+    base_fixture::init_socket_api();
+  }
+
+  ~shards_fixture() {
+    base_fixture::deinit_socket_api();
+  }
+
+  void connect_peers() {
+    MESSAGE("prepare connections");
+    auto server_handle = mercury.make_accept_handle();
+    mercury.mpx.prepare_connection(server_handle,
+                                   mercury.make_connection_handle(), venus.mpx,
+                                   "mercury", 4040,
+                                   venus.make_connection_handle());
+    mercury.mpx.prepare_connection(server_handle,
+                                   mercury.make_connection_handle(), earth.mpx,
+                                   "mercury", 4040,
+                                   earth.make_connection_handle());
+    MESSAGE("start listening on mercury:4040");
+    mercury.sched.after_next_enqueue([&] {
+      exec_loop();
+      MESSAGE("peer venus to mercury:4040");
+      venus.loop_after_next_enqueue();
+      venus.ep.peer("mercury", 4040);
+      MESSAGE("peer earth to mercury:4040");
+      earth.loop_after_next_enqueue();
+      earth.ep.peer("mercury", 4040);
+    });
+    mercury.ep.listen("", 4040);
+    exec_loop();
+  }
+};
+
+} // namespace
+
+CAF_TEST_FIXTURE_SCOPE(sharded_endpoints, shards_fixture)
+
+CAF_TEST(peers_with_the_same_number_of_shards_exchange_messages) {
+  auto venus_es = venus.ep.make_status_subscriber(true);
+  venus_es.set_rate_calculation(false);
+  exec_loop();
+  connect_peers();
+  CAF_CHECK_EQUAL(event_log(venus_es.poll()), event_log({sc::peer_added}));
+  CAF_CHECK_EQUAL(venus.peers().size(), 1u);
+  MESSAGE("publish on topics that map to different shards");
+  mercury.subscribe_to("foo");
+  venus.publish("foo/a", 1, 2, 3);
+  venus.publish("foo/b", 4, 5, 6);
+  venus.publish("foo/c", 7, 8, 9);
+  exec_loop();
+  CAF_CHECK_EQUAL(mercury.data.size(), 9u);
+  venus.loop_after_next_enqueue();
+  venus.ep.unpeer("mercury", 4040);
+}
+
+CAF_TEST(peers_with_different_numbers_of_shards_drop_the_peering) {
+  auto mercury_es = mercury.ep.make_status_subscriber(true);
+  auto earth_es = earth.ep.make_status_subscriber(true);
+  for (auto es : {&mercury_es, &earth_es})
+    es->set_rate_calculation(false);
+  exec_loop();
+  connect_peers();
+  MESSAGE("earth removes mercury after comparing the number of shards");
+  CAF_CHECK_EQUAL(event_log(earth_es.poll()),
+                  event_log({sc::peer_added, sc::peer_removed}));
+  CAF_CHECK(earth.peers().empty());
+  MESSAGE("mercury only keeps venus as peer");
+  auto mercury_peers = mercury.peers();
+  CAF_REQUIRE_EQUAL(mercury_peers.size(), 1u);
+  CAF_CHECK_EQUAL(mercury_peers.front().peer.node, venus.ep.node_id());
+  venus.loop_after_next_enqueue();
+  venus.ep.unpeer("mercury", 4040);
+}
+
+CAF_TEST_FIXTURE_SCOPE_END()
@@ -3,6 +3,7 @@
 
 #include "test.hh"
 
+#include <chrono>
 #include <ciso646>
 #include <cstdlib>
 #include <string>
@@ -12,6 +13,8 @@
 #include "broker/configuration.hh"
 #include "broker/data.hh"
 #include "broker/endpoint.hh"
+#include "broker/status.hh"
+#include "broker/status_subscriber.hh"
 #include "broker/subscriber.hh"
 #include "broker/topic.hh"
 
@@ -24,6 +27,8 @@ configuration make_config(std::string cert_id) {
   cfg.parse(caf::test::engine::argc(), caf::test::engine::argv());
   // cfg.set("scheduler.policy", caf::atom("testing"));
   cfg.set("logger.inline-output",  true);
+  // Establish SSL connections on helper threads rather than in the middleman.
+  cfg.set("broker.connect-workers", size_t{2});
 
 //  cfg.scheduler_policy = caf::atom("testing");
   if ( cert_id.size() ) {
@@ -58,12 +63,14 @@ struct ssl_auth_fixture {
   peer_fixture venus_auth;
   peer_fixture earth_no_auth;
   peer_fixture earth_wrong_auth;
+  peer_fixture mars_auth;
 
   ssl_auth_fixture()
     : mercury_auth("mercury_auth", make_config("1")),
       venus_auth("venus_auth", make_config("2")),
       earth_no_auth("earth_no_auth", make_config("")),
-      earth_wrong_auth("earth_wrong_auth", make_config("self-signed")) {
+      earth_wrong_auth("earth_wrong_auth", make_config("self-signed")),
+      mars_auth("mars_auth", make_config("1")) {
   }
 };
 
@@ -138,5 +145,31 @@ CAF_TEST(authenticated_failure_wrong_ssl_peer) {
   earth_wrong_auth.ep.shutdown();
 }
 
+CAF_TEST(helper threads establish authenticated sessions) {
+  MESSAGE("mercury_auth and mars_auth listen");
+  auto p1 = mercury_auth.ep.listen("127.0.0.1", 0);
+  auto p2 = mars_auth.ep.listen("127.0.0.1", 0);
+  MESSAGE("venus_auth peers with both on helper threads");
+  auto es = venus_auth.ep.make_status_subscriber(true);
+  venus_auth.ep.peer_nosync("127.0.0.1", p1, timeout::seconds(0));
+  venus_auth.ep.peer_nosync("127.0.0.1", p2, timeout::seconds(0));
+  size_t added = 0;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (added < 2 && std::chrono::steady_clock::now() < deadline) {
+    auto x = es.get(std::chrono::milliseconds(100));
+    if (auto st = caf::get_if<status>(&x); st && st->code() == sc::peer_added)
+      ++added;
+  }
+  CAF_CHECK_EQUAL(added, 2u);
+  CAF_CHECK_EQUAL(venus_auth.ep.peers().size(), 2u);
+  MESSAGE("peers without a valid certificate still fail");
+  auto p3 = earth_wrong_auth.ep.listen("127.0.0.1", 0);
+  CAF_CHECK(not venus_auth.ep.peer("127.0.0.1", p3, timeout::seconds(0)));
+  venus_auth.ep.shutdown();
+  mercury_auth.ep.shutdown();
+  mars_auth.ep.shutdown();
+  earth_wrong_auth.ep.shutdown();
+}
+
 CAF_TEST_FIXTURE_SCOPE_END()
 
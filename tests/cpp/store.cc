@@ -105,6 +105,30 @@ TEST(expiration) {
   CHECK_EQUAL(error_of(m->get("foo")), ec::no_such_key);
 }
 
+TEST(expiration with simulated time) {
+  using std::chrono::seconds;
+  broker_options opts;
+  opts.use_real_time = false;
+  endpoint ep{configuration{opts}};
+  ep.advance_time(timestamp{seconds(1)});
+  auto m1 = ep.attach_master("grubby-1", backend::memory);
+  auto m2 = ep.attach_master("grubby-2", backend::memory);
+  REQUIRE(m1);
+  REQUIRE(m2);
+  m1->put("foo", 42, seconds(10));
+  m2->put("bar", 23, seconds(10));
+  m2->put("baz", 7, seconds(20));
+  CHECK_EQUAL(value_of(m1->get("foo")), data{42});
+  CHECK_EQUAL(value_of(m2->get("bar")), data{23});
+  // Returns only after both masters have processed their expirations.
+  ep.advance_time(timestamp{seconds(12)});
+  CHECK_EQUAL(error_of(m1->get("foo")), ec::no_such_key);
+  CHECK_EQUAL(error_of(m2->get("bar")), ec::no_such_key);
+  CHECK_EQUAL(value_of(m2->get("baz")), data{7});
+  ep.advance_time(timestamp{seconds(22)});
+  CHECK_EQUAL(error_of(m2->get("baz")), ec::no_such_key);
+}
+
 TEST(proxy) {
   endpoint ep;
   auto m = ep.attach_master("puneta", backend::memory);
@@ -65,7 +65,7 @@ CAF_TEST(blocking_subscriber) {
   // Spawn/get/configure core actors.
   broker_options options;
   options.disable_ssl = true;
-  auto core1 = sys.spawn(core_actor, filter_type{"a", "b", "c"}, options, nullptr);
+  auto core1 = sys.spawn(core_actor, filter_type{"a", "b", "c"}, options, nullptr, nullptr);
   auto core2 = ep.core();
   anon_send(core2, atom::subscribe_v, filter_type{"a", "b", "c"});
   anon_send(core1, atom::no_events_v);
@@ -103,7 +103,7 @@ CAF_TEST(nonblocking_subscriber) {
   // Spawn/get/configure core actors.
   broker_options options;
   options.disable_ssl = true;
-  auto core1 = sys.spawn(core_actor, filter_type{"a", "b", "c"}, options, nullptr);
+  auto core1 = sys.spawn(core_actor, filter_type{"a", "b", "c"}, options, nullptr, nullptr);
   auto core2 = ep.core();
   anon_send(core1, atom::no_events_v);
   anon_send(core2, atom::no_events_v);
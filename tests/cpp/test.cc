@@ -65,6 +65,8 @@ configuration base_fixture::make_config() {
   cfg.set("logger.verbosity", "TRACE");
 #endif
   cfg.load<io::middleman, io::network::test_multiplexer>();
+  // Helper threads for connecting would bypass the deterministic scheduler.
+  cfg.set("broker.connect-workers", size_t{0});
   return cfg;
 }
 